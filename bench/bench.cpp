@@ -0,0 +1,366 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <learnopengl/camera.h>
+#include <learnopengl/geometry_arena.h>
+#include <learnopengl/gl_state.h>
+#include <learnopengl/instance_buffer.h>
+#include <learnopengl/mapped_file.h>
+#include <learnopengl/model.h>
+#include <learnopengl/render_queue.h>
+#include <learnopengl/shader.h>
+#include <learnopengl/uniform_blocks.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// benchmarks, run by hand from the project directory with the name of the benchmark as the argument. They print
+// their measurements and read the assets from resources/ the way the application does. The ones that draw do it in
+// a hidden window the size of the application's
+
+const unsigned int SCR_WIDTH = 800;
+const unsigned int SCR_HEIGHT = 600;
+// the scene's far plane, the render queue quantizes depth up to it
+const float FAR_PLANE = 100.0f;
+
+// the Camera block of the scene (see cameraBlock in src/main.cpp)
+UniformBlocks::Camera cameraBlock(const Camera &camera)
+{
+    UniformBlocks::Camera block = {};
+    block.projection = glm::perspective(glm::radians(camera.Zoom), (float) SCR_WIDTH / (float) SCR_HEIGHT, 0.1f, FAR_PLANE);
+    block.view = camera.GetViewMatrix();
+    block.skyboxView = glm::mat4(glm::mat3(block.view));
+    block.viewPosition = glm::vec4(camera.Position, 1.0f);
+    return block;
+}
+
+// a Lights block whose sun and moon circle the earth at time like in the scene, so the spotlights change every frame
+// the time does
+UniformBlocks::Lights lightsBlock(double time)
+{
+    UniformBlocks::Lights block = {};
+    block.directionalLight.direction = glm::vec3(0.0f, -0.5f, 0.0f);
+    block.sunLight.position = glm::vec3(sin(time) - 0.2, 1.0f, cos(time));
+    block.sunLight.direction = glm::vec3(sin(time)/5.0f-0.2f,-1.0f,cos(time)/5.0f) - block.sunLight.position;
+    block.moonLight.position = glm::vec3(-sin(time) - 0.2f, 1.0f, -cos(time));
+    block.moonLight.direction = glm::vec3(-sin(time)/4.0f-0.2f,-1.0f,-cos(time)/4.0f) - block.moonLight.position;
+    return block;
+}
+
+// a hidden window with the context the application asks for, null when there is none. The GL state is set up
+// like the scene's
+GLFWwindow *createContext()
+{
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow *window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "bench", nullptr, nullptr);
+    if (window == nullptr) {
+        std::cout << "ERROR::BENCH:: failed to create GLFW window" << std::endl;
+        return nullptr;
+    }
+    glfwMakeContextCurrent(window);
+    if (!gladLoadGLLoader((GLADloadproc) glfwGetProcAddress)) {
+        std::cout << "ERROR::BENCH:: failed to initialize GLAD" << std::endl;
+        return nullptr;
+    }
+    GeometryArena::Instance().LoadFunctions((GLADloadproc) glfwGetProcAddress);
+    GLState &glState = GLState::Instance();
+    glState.Enable(GL_DEPTH_TEST);
+    glState.Enable(GL_BLEND);
+    glState.BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glState.Enable(GL_CULL_FACE);
+    glState.CullFace(GL_BACK);
+    return window;
+}
+
+// writes a wavy grid of quads with texture coordinates and a shared normal, about the given number of triangles
+bool writeBenchmarkObj(const std::string &path, size_t triangles)
+{
+    std::FILE *file = std::fopen(path.c_str(), "w");
+    if (!file)
+        return false;
+    int quads = (int)std::ceil(std::sqrt(triangles / 2.0));
+    int side = quads + 1;
+    std::fprintf(file, "o grid\n");
+    for (int y = 0; y < side; y++)
+        for (int x = 0; x < side; x++)
+            std::fprintf(file, "v %.6f %.6f %.6f\n", x / (float)quads, 0.1f * std::sin(x * 0.05f) * std::cos(y * 0.05f), y / (float)quads);
+    for (int y = 0; y < side; y++)
+        for (int x = 0; x < side; x++)
+            std::fprintf(file, "vt %.6f %.6f\n", x / (float)quads, y / (float)quads);
+    std::fprintf(file, "vn 0.0000 1.0000 0.0000\n");
+    for (int y = 0; y < quads; y++)
+        for (int x = 0; x < quads; x++)
+        {
+            int a = y * side + x + 1, b = a + 1, c = a + side + 1, d = a + side;
+            std::fprintf(file, "f %d/%d/1 %d/%d/1 %d/%d/1 %d/%d/1\n", a, a, d, d, c, c, b, b);
+        }
+    return std::fclose(file) == 0;
+}
+
+// import throughput of both importers on the largest models and on a generated 10M triangle grid
+int benchmarkObjLoader()
+{
+    std::string generated = std::string(P_tmpdir) + "/obj_loader_benchmark.obj";
+    std::cout << "writing " << generated << std::endl;
+    if (!writeBenchmarkObj(generated, 10000000))
+    {
+        std::cout << "ERROR::OBJ_LOADER:: can't write " << generated << std::endl;
+        return 1;
+    }
+
+    for (const std::string &path : {std::string("resources/objects/sun/sun.obj"), std::string("resources/objects/bird/bird.obj"), generated})
+    {
+        MappedFile file;
+        file.Open(path);
+        double megabytes = file.Size() / (1024.0 * 1024.0);
+        // Assimp needs several GB for the generated grid, it's only timed on the real models
+        for (MeshImporter importer : {MeshImporter::Obj, MeshImporter::Assimp})
+        {
+            if (importer == MeshImporter::Assimp && path == generated)
+                continue;
+            std::vector<MeshData> meshes;
+            auto start = std::chrono::steady_clock::now();
+            Model::ImportMeshes(path, meshes, importer);
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            size_t triangles = 0, vertices = 0;
+            for (const MeshData &mesh : meshes)
+            {
+                triangles += mesh.indices.size() / 3;
+                vertices += mesh.vertices.size();
+            }
+            std::cout << path << " (" << megabytes << " MB) " << (importer == MeshImporter::Obj ? "ObjLoader" : "Assimp") << ": "
+                      << seconds * 1000.0 << " ms, " << megabytes / seconds << " MB/s, " << triangles << " triangles, "
+                      << vertices << " vertices" << std::endl;
+        }
+    }
+    std::remove(generated.c_str());
+    return 0;
+}
+
+// CPU time of the uniform updates per frame, in two parts. The uniforms still set outside the shared blocks (the
+// earth's model matrix and material, the bloom exposure) three ways: glGetUniformLocation on every call (how Shader
+// used to set uniforms), Shader's by-name setters (a hash and a table lookup per call) and pre-resolved handles.
+// Then the Camera and Lights block updates that replaced 30 loose uniforms of the earth pass, with the animated
+// lights (part of the lights block is uploaded every frame) and with everything still (nothing is uploaded)
+int benchmarkUniforms()
+{
+    Shader earthShader("resources/shaders/flat_earth.vs", "resources/shaders/flat_earth.fs", nullptr,
+                       ShaderDefines().Set("SPOT_LIGHTS", 2));
+    Shader bloomShader("resources/shaders/bloom.vs", "resources/shaders/bloom.fs", nullptr, ShaderDefines().Set("BLOOM"));
+    UniformBuffer<UniformBlocks::Camera> cameraBuffer(UniformBlocks::CAMERA_BINDING);
+    UniformBuffer<UniformBlocks::Lights> lightsBuffer(UniformBlocks::LIGHTS_BINDING);
+    Camera camera;
+
+    const int frames = 20000;
+    glm::mat4 matrix(1.0f);
+    const Uniform modelUniform = earthShader.GetUniform("model");
+    const Uniform shininess = earthShader.GetUniform("material.shininess");
+    const Uniform specular = earthShader.GetUniform("material.specular");
+    const Uniform exposure = bloomShader.GetUniform("exposure");
+
+    const char *uniformMethods[] = {"glGetUniformLocation", "Shader by name", "Shader handles"};
+    for (int method = 0; method < 3; method++) {
+        glFinish();
+        auto start = std::chrono::steady_clock::now();
+        for (int frame = 0; frame < frames; frame++) {
+            earthShader.use();
+            if (method == 0) {
+                glUniformMatrix4fv(glGetUniformLocation(earthShader.ID, "model"), 1, GL_FALSE, &matrix[0][0]);
+                glUniform1f(glGetUniformLocation(earthShader.ID, "material.shininess"), 32.0f);
+                glUniform3f(glGetUniformLocation(earthShader.ID, "material.specular"), 0.05f, 0.05f, 0.05f);
+            } else if (method == 1) {
+                earthShader.setMat4("model", matrix);
+                earthShader.setFloat("material.shininess", 32.0f);
+                earthShader.setVec3("material.specular", 0.05f);
+            } else {
+                earthShader.setMat4(modelUniform, matrix);
+                earthShader.setFloat(shininess, 32.0f);
+                earthShader.setVec3(specular, 0.05f);
+            }
+            bloomShader.use();
+            if (method == 0)
+                glUniform1f(glGetUniformLocation(bloomShader.ID, "exposure"), 1.0f);
+            else if (method == 1)
+                bloomShader.setFloat("exposure", 1.0f);
+            else
+                bloomShader.setFloat(exposure, 1.0f);
+        }
+        glFinish();
+        double microseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        std::cout << uniformMethods[method] << ": " << microseconds / frames << " us per frame" << std::endl;
+    }
+
+    const char *blockMethods[] = {"blocks, animated lights", "blocks, still lights"};
+    for (int method = 0; method < 2; method++) {
+        UniformBuffer<UniformBlocks::Lights>::Stats before = lightsBuffer.GetStats();
+        glFinish();
+        auto start = std::chrono::steady_clock::now();
+        for (int frame = 0; frame < frames; frame++) {
+            double time = method == 0 ? frame * 0.016 : 0.0;
+            cameraBuffer.Update(cameraBlock(camera));
+            lightsBuffer.Update(lightsBlock(time));
+        }
+        glFinish();
+        double microseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        const UniformBuffer<UniformBlocks::Lights>::Stats &after = lightsBuffer.GetStats();
+        std::cout << blockMethods[method] << ": " << microseconds / frames << " us per frame, lights block uploaded "
+                  << after.uploads - before.uploads << " times, " << (after.bytes - before.bytes) / (double)frames
+                  << " bytes per frame" << std::endl;
+    }
+    return 0;
+}
+
+// sort time and state changes of the render queue on synthetic scenes of 1k to 100k items: 8 programs, 64
+// materials and 1024 vertex arrays drawn in random order at random depths. std::stable_sort on the same items for
+// reference
+int benchmarkRenderQueue()
+{
+    std::mt19937 random(1234);
+    for (unsigned int itemCount : {1000u, 10000u, 100000u}) {
+        std::vector<uint64_t> keys(itemCount);
+        for (uint64_t &key : keys)
+            key = RenderQueue::MakeKey(RenderQueue::Opaque, 1 + random() % 8, 1 + random() % 64, 1 + random() % 1024,
+                                       (random() % 10000) / 100.0f, FAR_PLANE);
+        const int repeats = itemCount >= 100000 ? 20 : 200;
+        RenderQueue queue;
+        auto start = std::chrono::steady_clock::now();
+        for (int repeat = 0; repeat < repeats; repeat++) {
+            queue.Clear();
+            for (uint32_t i = 0; i < itemCount; i++)
+                queue.Submit(keys[i], i);
+            queue.Sort();
+        }
+        double radixMicroseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / repeats;
+
+        std::vector<RenderQueue::Item> items;
+        start = std::chrono::steady_clock::now();
+        for (int repeat = 0; repeat < repeats; repeat++) {
+            items.clear();
+            for (uint32_t i = 0; i < itemCount; i++)
+                items.push_back(RenderQueue::Item{keys[i], i});
+            std::stable_sort(items.begin(), items.end(), [](const RenderQueue::Item &a, const RenderQueue::Item &b) {
+                return a.key < b.key;
+            });
+        }
+        double stdMicroseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / repeats;
+
+        const RenderQueue::Stats &stats = queue.GetStats();
+        std::cout << itemCount << " items: radix sort " << radixMicroseconds << " us, std::stable_sort " << stdMicroseconds
+                  << " us; changes of program " << stats.submittedChanges[0] << " -> " << stats.sortedChanges[0]
+                  << ", material " << stats.submittedChanges[1] << " -> " << stats.sortedChanges[1]
+                  << ", vertex array " << stats.submittedChanges[2] << " -> " << stats.sortedChanges[2]
+                  << " (" << stats.Submitted() - stats.Sorted() << " saved)" << std::endl;
+    }
+    return 0;
+}
+
+// frame time of N birds drawn one by one (a setMat4 and a Model::Draw each, the way the scene draws its models) and
+// of the same birds in one Model::DrawInstanced, for N from 1 to 100k. The birds fill a cube in front of the camera
+int benchmarkInstancing()
+{
+    Shader birdShader("resources/shaders/bird.vs", "resources/shaders/bird.fs");
+    Shader instancedShader("resources/shaders/bird_instanced.vs", "resources/shaders/bird.fs");
+    const Uniform modelUniform = birdShader.GetUniform("model");
+    Model bird("resources/objects/bird/bird.obj");
+    bird.SetShaderTextureNamePrefix("material.");
+    bird.SetVertexFormat(VertexFormat::PackedHalf);
+
+    // the scene draws into a floating point framebuffer, so do the birds
+    unsigned int framebuffer, colorBuffer, depthBuffer;
+    glGenFramebuffers(1, &framebuffer);
+    GLState &glState = GLState::Instance();
+    glState.BindFramebuffer(framebuffer);
+    glGenTextures(1, &colorBuffer);
+    glState.BindTexture(0, GL_TEXTURE_2D, colorBuffer);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorBuffer, 0);
+    glGenRenderbuffers(1, &depthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, SCR_WIDTH, SCR_HEIGHT);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+
+    Camera camera;
+    UniformBuffer<UniformBlocks::Camera> cameraBuffer(UniformBlocks::CAMERA_BINDING);
+    cameraBuffer.Update(cameraBlock(camera));
+    std::mt19937 random(1234);
+    InstanceBuffer instanceBuffer;
+    for (unsigned int count : {1u, 10u, 100u, 1000u, 10000u, 100000u}) {
+        std::vector<InstanceData> instances(count);
+        int side = (int)std::ceil(std::cbrt((double)count));
+        glm::vec3 corner = camera.Position + camera.Front * 3.0f - glm::vec3(side * 0.025f);
+        for (unsigned int i = 0; i < count; i++) {
+            glm::vec3 position = corner + glm::vec3(i % side, (i / side) % side, i / (side * side)) * 0.05f;
+            instances[i].model = glm::scale(glm::translate(glm::mat4(1.0f), position), glm::vec3(0.002f));
+            instances[i].tint = glm::vec4((random() % 256) / 255.0f, (random() % 256) / 255.0f, (random() % 256) / 255.0f, 1.0f);
+        }
+        instanceBuffer.Update(instances);
+
+        const int frames = count >= 10000 ? 10 : 50;
+        double milliseconds[2];
+        for (int method = 0; method < 2; method++) {
+            // the first frame resolves the materials and points the vertex arrays at the instances
+            for (int frame = -1; frame < frames; frame++) {
+                if (frame == 0) {
+                    glFinish();
+                    milliseconds[method] = glfwGetTime() * 1000.0;
+                }
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                if (method == 0) {
+                    birdShader.use();
+                    for (const InstanceData &instance : instances) {
+                        birdShader.setMat4(modelUniform, instance.model);
+                        bird.Draw(birdShader);
+                    }
+                } else {
+                    instancedShader.use();
+                    bird.DrawInstanced(instancedShader, instanceBuffer);
+                }
+            }
+            glFinish();
+            milliseconds[method] = (glfwGetTime() * 1000.0 - milliseconds[method]) / frames;
+        }
+        std::cout << count << " birds: " << milliseconds[0] << " ms per frame one by one, " << milliseconds[1]
+                  << " ms instanced (" << milliseconds[0] / milliseconds[1] << "x)" << std::endl;
+    }
+    glState.BindFramebuffer(0);
+    glState.ForgetTexture(colorBuffer);
+    glDeleteTextures(1, &colorBuffer);
+    glDeleteRenderbuffers(1, &depthBuffer);
+    glDeleteFramebuffers(1, &framebuffer);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    std::string benchmark = argc > 1 ? argv[1] : "";
+    if (benchmark == "obj_loader")
+        return benchmarkObjLoader();
+    if (benchmark == "render_queue")
+        return benchmarkRenderQueue();
+    if (benchmark != "uniforms" && benchmark != "instancing") {
+        std::cout << "ERROR::BENCH:: unknown benchmark " << benchmark
+                  << ", one of: obj_loader, render_queue, uniforms, instancing" << std::endl;
+        return 1;
+    }
+    if (!createContext()) {
+        glfwTerminate();
+        return 1;
+    }
+    int exitCode = benchmark == "uniforms" ? benchmarkUniforms() : benchmarkInstancing();
+    glfwTerminate();
+    return exitCode;
+}
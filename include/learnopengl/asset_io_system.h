@@ -0,0 +1,99 @@
+#ifndef ASSET_IO_SYSTEM_H
+#define ASSET_IO_SYSTEM_H
+
+#include <assimp/IOStream.hpp>
+#include <assimp/IOSystem.hpp>
+
+#include <learnopengl/asset_pack.h>
+
+#include <sys/stat.h>
+
+#include <cstring>
+#include <string>
+#include <utility>
+
+// Assimp reader of an AssetFile, so models and the files they reference (.mtl and friends) come out of the
+// asset pack as well. Read-only: writes fail.
+class AssetIOStream : public Assimp::IOStream
+{
+public:
+    explicit AssetIOStream(AssetFile file) : file(std::move(file))
+    {
+    }
+
+    size_t Read(void *buffer, size_t size, size_t count) override
+    {
+        if (size == 0)
+            return 0;
+        size_t available = (file.Size() - position) / size;
+        count = count < available ? count : available;
+        memcpy(buffer, file.Data() + position, size * count);
+        position += size * count;
+        return count;
+    }
+
+    size_t Write(const void*, size_t, size_t) override
+    {
+        return 0;
+    }
+
+    aiReturn Seek(size_t offset, aiOrigin origin) override
+    {
+        size_t target = origin == aiOrigin_SET ? offset : origin == aiOrigin_CUR ? position + offset : file.Size() + offset;
+        if (target > file.Size())
+            return aiReturn_FAILURE;
+        position = target;
+        return aiReturn_SUCCESS;
+    }
+
+    size_t Tell() const override
+    {
+        return position;
+    }
+
+    size_t FileSize() const override
+    {
+        return file.Size();
+    }
+
+    void Flush() override
+    {
+    }
+
+private:
+    AssetFile file;
+    size_t position = 0;
+};
+
+// Assimp file system over AssetFile: packed files first, loose files otherwise
+class AssetIOSystem : public Assimp::IOSystem
+{
+public:
+    bool Exists(const char *path) const override
+    {
+        struct stat st;
+        return AssetPack::Instance().Find(path) != nullptr || stat(path, &st) == 0;
+    }
+
+    char getOsSeparator() const override
+    {
+        return '/';
+    }
+
+    Assimp::IOStream* Open(const char *path, const char *mode = "rb") override
+    {
+        // the pack is read-only, and so are the loose files as far as models are concerned
+        if (strchr(mode, 'w') || strchr(mode, 'a') || strchr(mode, '+'))
+            return nullptr;
+        AssetFile file;
+        if (!file.Open(path))
+            return nullptr;
+        return new AssetIOStream(std::move(file));
+    }
+
+    void Close(Assimp::IOStream *stream) override
+    {
+        delete stream;
+    }
+};
+#endif
@@ -0,0 +1,161 @@
+#ifndef ASSET_LOADER_H
+#define ASSET_LOADER_H
+
+#include <learnopengl/texture_uploader.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Worker pool for asset loading. File I/O, model parsing and image decoding run as jobs on the
+// background threads, everything that needs the GL context is queued with QueueUpload and executed
+// on the context thread by ProcessUploads, typically once per frame.
+//
+// jobs and uploads capture whatever they load into, so those objects have to outlive the loader
+// or at least every ProcessUploads call made after they were submitted.
+class AssetLoader
+{
+public:
+    // decoded textures are streamed through here, see TextureUploader::frameBudgetMilliseconds
+    TextureUploader Textures;
+
+    // workerCount 0 uses one worker per hardware thread, leaving one for the render thread
+    explicit AssetLoader(unsigned int workerCount = 0)
+    {
+        if (workerCount == 0)
+        {
+            unsigned int hardwareThreads = std::thread::hardware_concurrency();
+            workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+        }
+        for (unsigned int i = 0; i < workerCount; i++)
+            workers.emplace_back(&AssetLoader::workerLoop, this);
+    }
+
+    ~AssetLoader()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        jobAvailable.notify_all();
+        for (std::thread &worker : workers)
+            worker.join();
+    }
+
+    AssetLoader(const AssetLoader&) = delete;
+    AssetLoader& operator=(const AssetLoader&) = delete;
+
+    // runs job on one of the worker threads
+    void Submit(std::function<void()> job)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.push_back(std::move(job));
+            pendingJobs++;
+        }
+        jobAvailable.notify_one();
+    }
+
+    // queues a GL call sequence to be run on the context thread, safe to call from any thread
+    void QueueUpload(std::function<void()> upload)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            uploads.push_back(std::move(upload));
+        }
+        jobDone.notify_all();
+    }
+
+    // runs queued uploads on the calling thread, which must own the GL context. Stops once budgetMilliseconds
+    // are spent (at least one upload always runs), a negative budget drains the whole queue.
+    // texture transfers continue afterwards within their own budget.
+    // returns the number of uploads executed
+    unsigned int ProcessUploads(double budgetMilliseconds = -1.0)
+    {
+        auto start = std::chrono::steady_clock::now();
+        unsigned int executed = 0;
+        while (true)
+        {
+            std::function<void()> upload;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (uploads.empty())
+                    break;
+                upload = std::move(uploads.front());
+                uploads.pop_front();
+            }
+            upload();
+            executed++;
+
+            double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            if (budgetMilliseconds >= 0.0 && elapsed >= budgetMilliseconds)
+                break;
+        }
+        Textures.Process();
+        return executed;
+    }
+
+    // true while jobs are running or uploads are waiting for the context thread. Call from the context thread.
+    bool Busy()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return pendingJobs > 0 || !uploads.empty() || !Textures.Idle();
+    }
+
+    // blocks the context thread until everything submitted so far is loaded and uploaded
+    void Finish()
+    {
+        while (true)
+        {
+            ProcessUploads();
+            std::unique_lock<std::mutex> lock(mutex);
+            if (pendingJobs == 0 && uploads.empty() && Textures.Idle())
+                return;
+            // streaming textures keep the loop spinning, they progress as the GPU frees the PBOs
+            if (uploads.empty() && Textures.Idle())
+                jobDone.wait(lock, [this]() { return pendingJobs == 0 || !uploads.empty(); });
+        }
+    }
+
+    unsigned int WorkerCount() const
+    {
+        return (unsigned int)workers.size();
+    }
+
+private:
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> jobs;
+    std::deque<std::function<void()>> uploads;
+    std::mutex mutex;
+    std::condition_variable jobAvailable;
+    std::condition_variable jobDone;
+    unsigned int pendingJobs = 0;
+    bool stopping = false;
+
+    void workerLoop()
+    {
+        while (true)
+        {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                jobAvailable.wait(lock, [this]() { return stopping || !jobs.empty(); });
+                if (stopping && jobs.empty())
+                    return;
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+            job();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                pendingJobs--;
+            }
+            jobDone.notify_all();
+        }
+    }
+};
+#endif
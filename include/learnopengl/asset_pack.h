@@ -0,0 +1,384 @@
+#ifndef ASSET_PACK_H
+#define ASSET_PACK_H
+
+#include <learnopengl/mapped_file.h>
+
+#include <dirent.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Read-only archive of the resources tree in one file, mapped once at startup so loading the assets is one
+// sequential read instead of dozens of opens. Files in it are addressed by their path relative to the directory
+// the pack lies in ("resources/shaders/models.vs"), readers get pointers straight into the mapping.
+//
+// layout (all values little endian):
+//   Header, Entry[entryCount] sorted by path, the paths (not terminated), then the contents of every entry,
+//   each at a 64-byte aligned offset
+class AssetPack
+{
+public:
+    static const uint32_t MAGIC = 0x4B504C47; // "GLPK"
+    static const uint32_t VERSION = 1;
+    static const size_t ALIGNMENT = 64;
+
+    struct Header
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t entryCount;
+        uint32_t pathBytes;
+    };
+
+    struct Entry
+    {
+        uint64_t offset;
+        uint64_t size;
+        // 64-bit FNV-1a of the contents, the same as TextureCache::HashFile
+        uint64_t hash;
+        // size and mtime of the source file the entry was packed from, derived caches validate against them
+        int64_t  mtime;
+        uint32_t pathOffset;
+        uint32_t pathLength;
+    };
+
+    static AssetPack& Instance()
+    {
+        static AssetPack pack;
+        return pack;
+    }
+
+    AssetPack(const AssetPack&) = delete;
+    AssetPack& operator=(const AssetPack&) = delete;
+
+    // maps the pack at packPath and asks the kernel to read all of it ahead in one go. Not thread safe, mount
+    // before any asset is loaded
+    bool Mount(const std::string &packPath)
+    {
+        Unmount();
+        if (!file.Open(packPath))
+            return false;
+        Header header;
+        if (file.Size() < sizeof(header))
+            return fail(packPath);
+        memcpy(&header, file.Data(), sizeof(header));
+        size_t pathsOffset = sizeof(header) + (size_t)header.entryCount * sizeof(Entry);
+        if (header.magic != MAGIC || header.version != VERSION || pathsOffset + header.pathBytes > file.Size())
+            return fail(packPath);
+        entries = (const Entry*)(file.Data() + sizeof(header));
+        entryCount = header.entryCount;
+        paths = (const char*)file.Data() + pathsOffset;
+        for (size_t i = 0; i < entryCount; i++)
+        {
+            if (entries[i].offset + entries[i].size > file.Size() || entries[i].pathOffset + entries[i].pathLength > header.pathBytes)
+                return fail(packPath);
+        }
+
+        madvise((void*)file.Data(), file.Size(), MADV_WILLNEED);
+        char resolved[PATH_MAX];
+        std::string directory = packPath.substr(0, packPath.find_last_of('/') == std::string::npos ? 0 : packPath.find_last_of('/'));
+        root = realpath(directory.empty() ? "." : directory.c_str(), resolved) ? resolved : directory;
+        return true;
+    }
+
+    void Unmount()
+    {
+        file.Close();
+        entries = nullptr;
+        entryCount = 0;
+        paths = nullptr;
+        root.clear();
+    }
+
+    bool Mounted() const
+    {
+        return file.IsOpen();
+    }
+
+    size_t Size() const
+    {
+        return file.Size();
+    }
+
+    // the entry of the file at path (relative, or absolute below the pack's directory), null if it isn't packed
+    const Entry* Find(const std::string &path) const
+    {
+        if (!Mounted())
+            return nullptr;
+        std::string name = Normalize(path);
+        if (name.empty())
+            return nullptr;
+        const Entry *end = entries + entryCount;
+        const Entry *it = std::lower_bound(entries, end, name, [this](const Entry &entry, const std::string &key) {
+            return compare(entry, key) < 0;
+        });
+        return it != end && compare(*it, name) == 0 ? it : nullptr;
+    }
+
+    // the entry to read path from: like Find, but null as well when a loose file at path has a size or mtime other
+    // than the one that was packed. Sources edited since the pack was built and caches rewritten since (a version
+    // bump, another compression key) are then read from disk instead of being shadowed by their packed copy
+    const Entry* Resolve(const std::string &path) const
+    {
+        const Entry *entry = Find(path);
+        if (!entry)
+            return nullptr;
+        struct stat st;
+        if (::stat(path.c_str(), &st) == 0 && ((uint64_t)st.st_size != entry->size || (int64_t)st.st_mtime != entry->mtime))
+            return nullptr;
+        return entry;
+    }
+
+    const unsigned char* Data(const Entry &entry) const
+    {
+        return file.Data() + entry.offset;
+    }
+
+    // path as it is stored in the pack: relative to the pack's directory, without "." and ".." components.
+    // empty for absolute paths outside of it
+    std::string Normalize(const std::string &path) const
+    {
+        std::string relative = path;
+        if (!relative.empty() && relative[0] == '/')
+        {
+            if (root.empty() || relative.compare(0, root.size(), root) != 0 || relative.size() <= root.size() || relative[root.size()] != '/')
+                return std::string();
+            relative = relative.substr(root.size() + 1);
+        }
+        std::vector<std::string> components;
+        std::stringstream stream(relative);
+        std::string component;
+        while (std::getline(stream, component, '/'))
+        {
+            if (component.empty() || component == ".")
+                continue;
+            if (component == "..")
+            {
+                if (components.empty())
+                    return std::string();
+                components.pop_back();
+            }
+            else
+                components.push_back(component);
+        }
+        std::string result;
+        for (const std::string &c : components)
+            result += (result.empty() ? "" : "/") + c;
+        return result;
+    }
+
+    // packs every file below root/directory (skipping temporary files and program binaries) into packPath, returns the number of files
+    static unsigned int Build(const std::string &root, const std::string &directory, const std::string &packPath)
+    {
+        std::vector<std::string> names;
+        collect(root, directory, names);
+        std::sort(names.begin(), names.end());
+
+        Header header = {MAGIC, VERSION, (uint32_t)names.size(), 0};
+        std::vector<Entry> index(names.size());
+        std::string pathData;
+        for (size_t i = 0; i < names.size(); i++)
+        {
+            index[i].pathOffset = (uint32_t)pathData.size();
+            index[i].pathLength = (uint32_t)names[i].size();
+            pathData += names[i];
+        }
+        header.pathBytes = (uint32_t)pathData.size();
+
+        std::ostringstream tmpName;
+        tmpName << packPath << ".tmp" << std::this_thread::get_id();
+        std::string tmpPath = tmpName.str();
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!out)
+        {
+            std::cout << "ERROR::ASSET_PACK:: can't write " << tmpPath << std::endl;
+            return 0;
+        }
+        // the index is written again once the offsets are known
+        size_t offset = sizeof(header) + index.size() * sizeof(Entry) + pathData.size();
+        out.write((const char*)&header, sizeof(header));
+        out.write((const char*)index.data(), index.size() * sizeof(Entry));
+        out.write(pathData.data(), pathData.size());
+
+        static const char zeros[ALIGNMENT] = {};
+        for (size_t i = 0; i < names.size(); i++)
+        {
+            std::string path = root + '/' + names[i];
+            struct stat st;
+            MappedFile source;
+            if (stat(path.c_str(), &st) != 0)
+            {
+                std::cout << "ERROR::ASSET_PACK:: can't read " << path << std::endl;
+                std::remove(tmpPath.c_str());
+                return 0;
+            }
+            // empty files can't be mapped, they are packed empty
+            source.Open(path);
+            size_t aligned = align(offset);
+            out.write(zeros, aligned - offset);
+            index[i].offset = aligned;
+            index[i].size = source.Size();
+            index[i].hash = Hash(source.Data(), source.Size());
+            index[i].mtime = (int64_t)st.st_mtime;
+            out.write((const char*)source.Data(), source.Size());
+            offset = aligned + source.Size();
+        }
+        out.seekp(sizeof(header));
+        out.write((const char*)index.data(), index.size() * sizeof(Entry));
+        out.close();
+        if (!out || std::rename(tmpPath.c_str(), packPath.c_str()) != 0)
+        {
+            std::remove(tmpPath.c_str());
+            std::cout << "ERROR::ASSET_PACK:: failed to write " << packPath << std::endl;
+            return 0;
+        }
+        return (unsigned int)names.size();
+    }
+
+    // 64-bit FNV-1a
+    static uint64_t Hash(const unsigned char *data, size_t size)
+    {
+        uint64_t value = 14695981039346656037ULL;
+        for (size_t i = 0; i < size; i++)
+        {
+            value ^= data[i];
+            value *= 1099511628211ULL;
+        }
+        return value;
+    }
+
+private:
+    MappedFile file;
+    const Entry *entries = nullptr;
+    size_t entryCount = 0;
+    const char *paths = nullptr;
+    // absolute directory of the pack, absolute paths below it are looked up relative to it
+    std::string root;
+
+    AssetPack() = default;
+
+    bool fail(const std::string &packPath)
+    {
+        std::cout << "ERROR::ASSET_PACK:: " << packPath << " is not a valid asset pack" << std::endl;
+        Unmount();
+        return false;
+    }
+
+    int compare(const Entry &entry, const std::string &name) const
+    {
+        size_t length = std::min<size_t>(entry.pathLength, name.size());
+        int result = memcmp(paths + entry.pathOffset, name.data(), length);
+        if (result != 0)
+            return result;
+        return entry.pathLength < name.size() ? -1 : entry.pathLength > name.size() ? 1 : 0;
+    }
+
+    static size_t align(size_t n)
+    {
+        return (n + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    }
+
+    static void collect(const std::string &root, const std::string &directory, std::vector<std::string> &names)
+    {
+        DIR *dir = opendir((root + '/' + directory).c_str());
+        if (!dir)
+            return;
+        while (dirent *entry = readdir(dir))
+        {
+            std::string name = entry->d_name;
+            // program binaries are specific to the driver that wrote them, they stay loose
+            if (name == "." || name == ".." || name.find(".tmp") != std::string::npos || name.find(".progcache") != std::string::npos)
+                continue;
+            std::string relative = directory + '/' + name;
+            struct stat st;
+            if (stat((root + '/' + relative).c_str(), &st) != 0)
+                continue;
+            if (S_ISDIR(st.st_mode))
+                collect(root, relative, names);
+            else if (S_ISREG(st.st_mode))
+                names.push_back(relative);
+        }
+        closedir(dir);
+    }
+};
+
+// Contents of a file, from the mounted AssetPack if it's in there and mapped from disk otherwise, or when the loose
+// file changed since it was packed (see AssetPack::Resolve). Either way
+// Data() points at the file's bytes without copying them; they stay valid as long as the AssetFile.
+class AssetFile
+{
+public:
+    AssetFile() = default;
+
+    AssetFile(const AssetFile&) = delete;
+    AssetFile& operator=(const AssetFile&) = delete;
+
+    AssetFile(AssetFile &&other) noexcept : file(std::move(other.file)), data(other.data), size(other.size), packed(other.packed)
+    {
+        other.data = nullptr;
+        other.size = 0;
+    }
+
+    AssetFile& operator=(AssetFile &&other) noexcept
+    {
+        if (this != &other)
+        {
+            file = std::move(other.file);
+            data = other.data;
+            size = other.size;
+            packed = other.packed;
+            other.data = nullptr;
+            other.size = 0;
+        }
+        return *this;
+    }
+
+    bool Open(const std::string &path)
+    {
+        Close();
+        if (const AssetPack::Entry *entry = AssetPack::Instance().Resolve(path))
+        {
+            data = AssetPack::Instance().Data(*entry);
+            size = (size_t)entry->size;
+            packed = true;
+            return true;
+        }
+        if (!file.Open(path))
+            return false;
+        data = file.Data();
+        size = file.Size();
+        return true;
+    }
+
+    void Close()
+    {
+        file.Close();
+        data = nullptr;
+        size = 0;
+        packed = false;
+    }
+
+    bool IsOpen() const { return data != nullptr; }
+    const unsigned char* Data() const { return data; }
+    size_t Size() const { return size; }
+    bool Packed() const { return packed; }
+
+private:
+    MappedFile file;
+    const unsigned char *data = nullptr;
+    size_t size = 0;
+    bool packed = false;
+};
+#endif
@@ -0,0 +1,526 @@
+#ifndef BLOCK_COMPRESSION_H
+#define BLOCK_COMPRESSION_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+// CPU encoder for the BC1 (DXT1), BC3 (DXT5) and BC7 block compressed formats, plus the matching decoders
+// used to measure the quality of an encoding. Every format stores 4x4 pixel blocks; BC1 uses 8 bytes per
+// block, BC3 and BC7 16 bytes. The BC7 encoder only emits mode 6 (one subset, RGBA endpoints with p-bits,
+// 4-bit indices), which is the mode that suits smooth photographic textures best.
+//
+// all functions take and return tightly packed 8-bit RGBA pixels.
+enum class BlockFormat
+{
+    None,
+    BC1,
+    BC3,
+    BC7
+};
+
+namespace BlockCompression
+{
+    inline const char* Name(BlockFormat format)
+    {
+        switch (format)
+        {
+            case BlockFormat::BC1: return "BC1";
+            case BlockFormat::BC3: return "BC3";
+            case BlockFormat::BC7: return "BC7";
+            default: return "uncompressed";
+        }
+    }
+
+    inline size_t BlockBytes(BlockFormat format)
+    {
+        return format == BlockFormat::BC1 ? 8 : 16;
+    }
+
+    inline size_t CompressedSize(BlockFormat format, int width, int height)
+    {
+        return (size_t)((width + 3) / 4) * ((height + 3) / 4) * BlockBytes(format);
+    }
+
+    // 4x4 block at (bx, by), pixels outside the image repeat the last row/column
+    inline void fetchBlock(const unsigned char *rgba, int width, int height, int bx, int by, unsigned char block[16][4])
+    {
+        for (int y = 0; y < 4; y++)
+        {
+            int sy = std::min(by * 4 + y, height - 1);
+            for (int x = 0; x < 4; x++)
+            {
+                int sx = std::min(bx * 4 + x, width - 1);
+                memcpy(block[y * 4 + x], rgba + ((size_t)sy * width + sx) * 4, 4);
+            }
+        }
+    }
+
+    // ------------------------------------------------------------------------
+    // BC1
+    // ------------------------------------------------------------------------
+    inline uint16_t pack565(const float color[3])
+    {
+        int r = (int)std::lround(std::min(std::max(color[0], 0.0f), 255.0f) * 31.0f / 255.0f);
+        int g = (int)std::lround(std::min(std::max(color[1], 0.0f), 255.0f) * 63.0f / 255.0f);
+        int b = (int)std::lround(std::min(std::max(color[2], 0.0f), 255.0f) * 31.0f / 255.0f);
+        return (uint16_t)((r << 11) | (g << 5) | b);
+    }
+
+    inline void unpack565(uint16_t packed, int color[3])
+    {
+        int r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+        color[0] = (r << 3) | (r >> 2);
+        color[1] = (g << 2) | (g >> 4);
+        color[2] = (b << 3) | (b >> 2);
+    }
+
+    // principal axis of the block colors, endpoints are the extreme projections onto it
+    inline void principalEndpoints(const unsigned char block[16][4], int channels, float start[4], float end[4])
+    {
+        float mean[4] = {0, 0, 0, 0};
+        for (int i = 0; i < 16; i++)
+            for (int c = 0; c < channels; c++)
+                mean[c] += block[i][c] / 16.0f;
+
+        float covariance[4][4] = {};
+        for (int i = 0; i < 16; i++)
+            for (int a = 0; a < channels; a++)
+                for (int b = 0; b < channels; b++)
+                    covariance[a][b] += (block[i][a] - mean[a]) * (block[i][b] - mean[b]);
+
+        // power iteration, starting along the diagonal
+        float axis[4] = {1, 1, 1, 1};
+        for (int iteration = 0; iteration < 8; iteration++)
+        {
+            float next[4] = {0, 0, 0, 0};
+            for (int a = 0; a < channels; a++)
+                for (int b = 0; b < channels; b++)
+                    next[a] += covariance[a][b] * axis[b];
+            float length = 0.0f;
+            for (int c = 0; c < channels; c++)
+                length = std::max(length, std::fabs(next[c]));
+            if (length < 1e-6f)
+                break;
+            for (int c = 0; c < channels; c++)
+                axis[c] = next[c] / length;
+        }
+        float axisLength = 0.0f;
+        for (int c = 0; c < channels; c++)
+            axisLength += axis[c] * axis[c];
+        axisLength = std::sqrt(axisLength);
+        for (int c = 0; c < channels; c++)
+            axis[c] /= axisLength;
+
+        float minT = 1e30f, maxT = -1e30f;
+        for (int i = 0; i < 16; i++)
+        {
+            float t = 0.0f;
+            for (int c = 0; c < channels; c++)
+                t += (block[i][c] - mean[c]) * axis[c];
+            minT = std::min(minT, t);
+            maxT = std::max(maxT, t);
+        }
+        for (int c = 0; c < channels; c++)
+        {
+            start[c] = mean[c] + axis[c] * minT;
+            end[c] = mean[c] + axis[c] * maxT;
+        }
+    }
+
+    inline int colorDistance(const int a[3], const unsigned char b[4])
+    {
+        int dr = a[0] - b[0], dg = a[1] - b[1], db = a[2] - b[2];
+        return dr * dr + dg * dg + db * db;
+    }
+
+    // 8 byte color block. BC1 proper may use the 3 color + transparent mode, BC3 color blocks never do,
+    // so this always writes the 4 color mode (color0 > color1)
+    inline void encodeColorBlock(const unsigned char block[16][4], unsigned char *out)
+    {
+        float start[4], end[4];
+        principalEndpoints(block, 3, start, end);
+        uint16_t color0 = pack565(end), color1 = pack565(start);
+        if (color0 < color1)
+            std::swap(color0, color1);
+
+        uint32_t indices = 0;
+        if (color0 != color1)
+        {
+            int palette[4][3];
+            unpack565(color0, palette[0]);
+            unpack565(color1, palette[1]);
+            for (int c = 0; c < 3; c++)
+            {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+            }
+            for (int i = 0; i < 16; i++)
+            {
+                int best = 0, bestDistance = colorDistance(palette[0], block[i]);
+                for (int p = 1; p < 4; p++)
+                {
+                    int distance = colorDistance(palette[p], block[i]);
+                    if (distance < bestDistance)
+                    {
+                        best = p;
+                        bestDistance = distance;
+                    }
+                }
+                indices |= (uint32_t)best << (2 * i);
+            }
+        }
+        out[0] = color0 & 0xFF;
+        out[1] = color0 >> 8;
+        out[2] = color1 & 0xFF;
+        out[3] = color1 >> 8;
+        for (int i = 0; i < 4; i++)
+            out[4 + i] = (indices >> (8 * i)) & 0xFF;
+    }
+
+    inline void decodeColorBlock(const unsigned char *in, unsigned char block[16][4])
+    {
+        uint16_t color0 = in[0] | (in[1] << 8), color1 = in[2] | (in[3] << 8);
+        int palette[4][4];
+        unpack565(color0, palette[0]);
+        unpack565(color1, palette[1]);
+        for (int p = 0; p < 4; p++)
+            palette[p][3] = 255;
+        for (int c = 0; c < 3; c++)
+        {
+            if (color0 > color1)
+            {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+            }
+            else
+            {
+                palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+                palette[3][c] = 0;
+            }
+        }
+        if (color0 <= color1)
+            palette[3][3] = 0;
+        uint32_t indices = in[4] | (in[5] << 8) | (in[6] << 16) | ((uint32_t)in[7] << 24);
+        for (int i = 0; i < 16; i++)
+            for (int c = 0; c < 4; c++)
+                block[i][c] = (unsigned char)palette[(indices >> (2 * i)) & 3][c];
+    }
+
+    // ------------------------------------------------------------------------
+    // BC3 alpha block (same as BC4)
+    // ------------------------------------------------------------------------
+    inline void alphaPalette(int alpha0, int alpha1, int palette[8])
+    {
+        palette[0] = alpha0;
+        palette[1] = alpha1;
+        if (alpha0 > alpha1)
+        {
+            for (int i = 1; i < 7; i++)
+                palette[i + 1] = ((7 - i) * alpha0 + i * alpha1) / 7;
+        }
+        else
+        {
+            for (int i = 1; i < 5; i++)
+                palette[i + 1] = ((5 - i) * alpha0 + i * alpha1) / 5;
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+    }
+
+    inline void encodeAlphaBlock(const unsigned char block[16][4], unsigned char *out)
+    {
+        int minAlpha = 255, maxAlpha = 0;
+        for (int i = 0; i < 16; i++)
+        {
+            minAlpha = std::min(minAlpha, (int)block[i][3]);
+            maxAlpha = std::max(maxAlpha, (int)block[i][3]);
+        }
+        out[0] = (unsigned char)maxAlpha;
+        out[1] = (unsigned char)minAlpha;
+        uint64_t indices = 0;
+        if (maxAlpha != minAlpha)
+        {
+            int palette[8];
+            alphaPalette(maxAlpha, minAlpha, palette);
+            for (int i = 0; i < 16; i++)
+            {
+                int best = 0;
+                for (int p = 1; p < 8; p++)
+                {
+                    if (std::abs(palette[p] - block[i][3]) < std::abs(palette[best] - block[i][3]))
+                        best = p;
+                }
+                indices |= (uint64_t)best << (3 * i);
+            }
+        }
+        for (int i = 0; i < 6; i++)
+            out[2 + i] = (indices >> (8 * i)) & 0xFF;
+    }
+
+    inline void decodeAlphaBlock(const unsigned char *in, unsigned char block[16][4])
+    {
+        int palette[8];
+        alphaPalette(in[0], in[1], palette);
+        uint64_t indices = 0;
+        for (int i = 0; i < 6; i++)
+            indices |= (uint64_t)in[2 + i] << (8 * i);
+        for (int i = 0; i < 16; i++)
+            block[i][3] = (unsigned char)palette[(indices >> (3 * i)) & 7];
+    }
+
+    // ------------------------------------------------------------------------
+    // BC7 mode 6
+    // ------------------------------------------------------------------------
+    static const int BC7_WEIGHTS4[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+    // little endian bit writer/reader over a 16 byte block
+    struct BitStream
+    {
+        unsigned char *bytes;
+        int position;
+
+        void Write(uint32_t value, int bits)
+        {
+            for (int i = 0; i < bits; i++, position++)
+            {
+                if ((value >> i) & 1)
+                    bytes[position >> 3] |= (unsigned char)(1 << (position & 7));
+            }
+        }
+
+        uint32_t Read(int bits)
+        {
+            uint32_t value = 0;
+            for (int i = 0; i < bits; i++, position++)
+                value |= (uint32_t)((bytes[position >> 3] >> (position & 7)) & 1) << i;
+            return value;
+        }
+    };
+
+    // 7 bit endpoint plus shared p-bit that reconstructs closest to color
+    inline void quantizeEndpoint(const float color[4], int quantized[4], int &pbit)
+    {
+        int bestError = -1;
+        for (int p = 0; p < 2; p++)
+        {
+            int candidate[4], error = 0;
+            for (int c = 0; c < 4; c++)
+            {
+                float value = std::min(std::max(color[c], 0.0f), 255.0f);
+                candidate[c] = std::min(std::max((int)std::lround((value - p) / 2.0f), 0), 127);
+                int reconstructed = (candidate[c] << 1) | p;
+                error += (int)((reconstructed - value) * (reconstructed - value));
+            }
+            if (bestError < 0 || error < bestError)
+            {
+                bestError = error;
+                pbit = p;
+                memcpy(quantized, candidate, sizeof(candidate));
+            }
+        }
+    }
+
+    inline void encodeBC7Block(const unsigned char block[16][4], unsigned char *out)
+    {
+        float start[4], end[4];
+        principalEndpoints(block, 4, start, end);
+        int endpoint[2][4], pbit[2];
+        quantizeEndpoint(start, endpoint[0], pbit[0]);
+        quantizeEndpoint(end, endpoint[1], pbit[1]);
+
+        int palette[16][4];
+        for (int c = 0; c < 4; c++)
+        {
+            int e0 = (endpoint[0][c] << 1) | pbit[0], e1 = (endpoint[1][c] << 1) | pbit[1];
+            for (int i = 0; i < 16; i++)
+                palette[i][c] = ((64 - BC7_WEIGHTS4[i]) * e0 + BC7_WEIGHTS4[i] * e1 + 32) >> 6;
+        }
+        int indices[16];
+        for (int i = 0; i < 16; i++)
+        {
+            int best = 0, bestError = -1;
+            for (int p = 0; p < 16; p++)
+            {
+                int error = 0;
+                for (int c = 0; c < 4; c++)
+                    error += (palette[p][c] - block[i][c]) * (palette[p][c] - block[i][c]);
+                if (bestError < 0 || error < bestError)
+                {
+                    best = p;
+                    bestError = error;
+                }
+            }
+            indices[i] = best;
+        }
+        // the anchor (first) index is stored without its top bit, so it has to be below 8
+        if (indices[0] & 8)
+        {
+            std::swap(endpoint[0], endpoint[1]);
+            std::swap(pbit[0], pbit[1]);
+            for (int i = 0; i < 16; i++)
+                indices[i] = 15 - indices[i];
+        }
+
+        memset(out, 0, 16);
+        BitStream stream{out, 0};
+        stream.Write(1 << 6, 7);
+        for (int c = 0; c < 4; c++)
+        {
+            stream.Write(endpoint[0][c], 7);
+            stream.Write(endpoint[1][c], 7);
+        }
+        stream.Write(pbit[0], 1);
+        stream.Write(pbit[1], 1);
+        stream.Write(indices[0], 3);
+        for (int i = 1; i < 16; i++)
+            stream.Write(indices[i], 4);
+    }
+
+    // decodes mode 6 blocks only, which is all encodeBC7Block produces
+    inline void decodeBC7Block(const unsigned char *in, unsigned char block[16][4])
+    {
+        BitStream stream{const_cast<unsigned char*>(in), 0};
+        if (stream.Read(7) != (1 << 6))
+        {
+            memset(block, 0, 16 * 4);
+            return;
+        }
+        int endpoint[2][4];
+        for (int c = 0; c < 4; c++)
+        {
+            endpoint[0][c] = stream.Read(7);
+            endpoint[1][c] = stream.Read(7);
+        }
+        int pbit0 = stream.Read(1), pbit1 = stream.Read(1);
+        for (int c = 0; c < 4; c++)
+        {
+            endpoint[0][c] = (endpoint[0][c] << 1) | pbit0;
+            endpoint[1][c] = (endpoint[1][c] << 1) | pbit1;
+        }
+        for (int i = 0; i < 16; i++)
+        {
+            int index = stream.Read(i == 0 ? 3 : 4);
+            for (int c = 0; c < 4; c++)
+                block[i][c] = (unsigned char)(((64 - BC7_WEIGHTS4[index]) * endpoint[0][c] + BC7_WEIGHTS4[index] * endpoint[1][c] + 32) >> 6);
+        }
+    }
+
+    // ------------------------------------------------------------------------
+
+    // threads one Compress spreads its block rows over, 0 for one per core. 1 keeps them on the calling thread, which
+    // is what the AssetLoader workers need: they already compress one texture each, more threads per texture would
+    // only oversubscribe the cores. Offline baking goes through the textures one at a time and uses every core
+    inline unsigned int& Threads()
+    {
+        static unsigned int threads = 1;
+        return threads;
+    }
+
+    // runs rowJob(blockRow) for every block row, spread over Threads() threads
+    template<typename RowJob>
+    void forEachBlockRow(int blockRows, RowJob rowJob)
+    {
+        unsigned int threadCount = Threads() == 0 ? std::max(1u, std::thread::hardware_concurrency()) : Threads();
+        threadCount = std::min(threadCount, (unsigned int)std::max(blockRows, 1));
+        if (threadCount <= 1)
+        {
+            for (int row = 0; row < blockRows; row++)
+                rowJob(row);
+            return;
+        }
+        std::vector<std::thread> threads;
+        for (unsigned int t = 0; t < threadCount; t++)
+        {
+            threads.emplace_back([t, threadCount, blockRows, &rowJob]() {
+                for (int row = (int)t; row < blockRows; row += (int)threadCount)
+                    rowJob(row);
+            });
+        }
+        for (std::thread &thread : threads)
+            thread.join();
+    }
+
+    // compresses an RGBA image into CompressedSize(format, width, height) bytes at out
+    inline void Compress(BlockFormat format, const unsigned char *rgba, int width, int height, unsigned char *out)
+    {
+        int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+        size_t blockBytes = BlockBytes(format);
+        forEachBlockRow(blocksY, [&](int by) {
+            unsigned char block[16][4];
+            for (int bx = 0; bx < blocksX; bx++)
+            {
+                unsigned char *dst = out + ((size_t)by * blocksX + bx) * blockBytes;
+                fetchBlock(rgba, width, height, bx, by, block);
+                if (format == BlockFormat::BC1)
+                    encodeColorBlock(block, dst);
+                else if (format == BlockFormat::BC3)
+                {
+                    encodeAlphaBlock(block, dst);
+                    encodeColorBlock(block, dst + 8);
+                }
+                else
+                    encodeBC7Block(block, dst);
+            }
+        });
+    }
+
+    inline void Decompress(BlockFormat format, const unsigned char *blocks, int width, int height, unsigned char *rgba)
+    {
+        int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+        size_t blockBytes = BlockBytes(format);
+        for (int by = 0; by < blocksY; by++)
+        {
+            for (int bx = 0; bx < blocksX; bx++)
+            {
+                const unsigned char *src = blocks + ((size_t)by * blocksX + bx) * blockBytes;
+                unsigned char block[16][4];
+                if (format == BlockFormat::BC1)
+                    decodeColorBlock(src, block);
+                else if (format == BlockFormat::BC3)
+                {
+                    decodeColorBlock(src + 8, block);
+                    decodeAlphaBlock(src, block);
+                }
+                else
+                    decodeBC7Block(src, block);
+                for (int y = 0; y < 4 && by * 4 + y < height; y++)
+                    for (int x = 0; x < 4 && bx * 4 + x < width; x++)
+                        memcpy(rgba + ((size_t)(by * 4 + y) * width + bx * 4 + x) * 4, block[y * 4 + x], 4);
+            }
+        }
+    }
+
+    // peak signal to noise ratio in dB over the first channels of two RGBA images, higher is better
+    inline double PSNR(const unsigned char *a, const unsigned char *b, int width, int height, int channels)
+    {
+        double squaredError = 0.0;
+        size_t pixels = (size_t)width * height;
+        for (size_t i = 0; i < pixels; i++)
+        {
+            for (int c = 0; c < channels; c++)
+            {
+                double difference = (double)a[i * 4 + c] - (double)b[i * 4 + c];
+                squaredError += difference * difference;
+            }
+        }
+        double meanSquaredError = squaredError / (double)(pixels * channels);
+        if (meanSquaredError <= 0.0)
+            return 99.0;
+        return 10.0 * std::log10(255.0 * 255.0 / meanSquaredError);
+    }
+
+    // compresses the image and returns the PSNR of the result against the source
+    inline double CompressWithPSNR(BlockFormat format, const unsigned char *rgba, int width, int height, int channels, std::vector<unsigned char> &out)
+    {
+        out.resize(CompressedSize(format, width, height));
+        Compress(format, rgba, width, height, out.data());
+        std::vector<unsigned char> decoded((size_t)width * height * 4);
+        Decompress(format, out.data(), width, height, decoded.data());
+        return PSNR(rgba, decoded.data(), width, height, channels);
+    }
+}
+#endif
@@ -2,9 +2,14 @@
 #define FILESYSTEM_H
 
 #include <string>
+#include <cstdint>
 #include <cstdlib>
+#include <climits>
+#include <sys/stat.h>
 #include "root_directory.h" // This is a configuration file generated by CMake.
 
+#include <learnopengl/asset_pack.h>
+
 class FileSystem
 {
 private:
@@ -17,6 +22,49 @@ public:
     return (*pathBuilder)(path);
   }
 
+  // mounts the asset pack at packPath: files in it are read from the pack from now on (see AssetFile),
+  // everything else still from disk
+  static bool mountPack(const std::string& packPath)
+  {
+    return AssetPack::Instance().Mount(packPath);
+  }
+
+  // true if path is in the mounted pack or a file on disk
+  static bool exists(const std::string& path)
+  {
+    uint64_t size;
+    int64_t mtime;
+    return stat(path, size, mtime);
+  }
+
+  // size and modification time of path, for packed files those of the file that was packed unless the loose
+  // file changed since (see AssetPack::Resolve)
+  static bool stat(const std::string& path, uint64_t& size, int64_t& mtime)
+  {
+    if (const AssetPack::Entry* entry = AssetPack::Instance().Resolve(path))
+    {
+      size = entry->size;
+      mtime = entry->mtime;
+      return true;
+    }
+    struct ::stat st;
+    if (::stat(path.c_str(), &st) != 0)
+      return false;
+    size = (uint64_t)st.st_size;
+    mtime = (int64_t)st.st_mtime;
+    return true;
+  }
+
+  // one name per file however it is reached: the path inside the pack for packed files, the real path for
+  // files on disk, an empty string if there is no such file
+  static std::string canonical(const std::string& path)
+  {
+    if (AssetPack::Instance().Resolve(path))
+      return AssetPack::Instance().Normalize(path);
+    char resolved[PATH_MAX];
+    return realpath(path.c_str(), resolved) ? std::string(resolved) : std::string();
+  }
+
 private:
   static std::string const & getRoot()
   {
@@ -0,0 +1,219 @@
+#ifndef FRAME_RING_BUFFER_H
+#define FRAME_RING_BUFFER_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/gl_extensions.h>
+#include <learnopengl/gl_object.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+// Buffer the CPU writes per-frame data into while the GPU still reads what earlier frames wrote. It is split into
+// FRAMES sections, a frame writes into the next one and BeginFrame waits on the fence EndFrame left behind when that
+// section was last used, so frame N+1 is written while the GPU consumes frame N. Write hands out ranges of the
+// current section, to bind with glBindBufferRange or point attributes at.
+//
+// Where the context has glBufferStorage (GL 4.4 or ARB_buffer_storage, loaded by LoadFunctions) the buffer is mapped
+// once, persistent and coherent, and Write is a memcpy. Otherwise there is a single section that BeginFrame orphans
+// and Write uploads with glBufferSubData, the driver then keeps the storage the GPU reads alive instead of the fences.
+class FrameRingBuffer
+{
+public:
+    static const unsigned int FRAMES = 3;
+
+    // a range written this frame, a size of 0 when the section was full
+    struct Range
+    {
+        GLuint buffer = 0;
+        GLintptr offset = 0;
+        GLsizeiptr size = 0;
+
+        explicit operator bool() const
+        {
+            return size > 0;
+        }
+    };
+
+    struct Stats
+    {
+        // bytes written last frame, and the most any frame wrote
+        size_t frameBytes = 0;
+        size_t peakBytes = 0;
+        // frames that found their section still in use by the GPU, and the time they waited for it
+        unsigned int waits = 0;
+        double waitMilliseconds = 0.0;
+        double lastWaitMilliseconds = 0.0;
+        // writes that didn't fit their section
+        unsigned int overflows = 0;
+    };
+
+    // loads glBufferStorage, call once the context is current. Returns false without it, buffers then orphan
+    static bool LoadFunctions(GLADloadproc load)
+    {
+        bufferStorage() = nullptr;
+        if (GLExtensions::Version(4, 4) || GLExtensions::Has("GL_ARB_buffer_storage"))
+            bufferStorage() = (BufferStorage)load("glBufferStorage");
+        return bufferStorage() != nullptr;
+    }
+
+    // false orphans even where persistent mapping is available (--no-persistent-mapping), for buffers created after
+    static bool& PersistentEnabled()
+    {
+        static bool enabled = true;
+        return enabled;
+    }
+
+    // target is what the buffer is bound to for creation and orphaning, sectionBytes what a frame may write
+    FrameRingBuffer(GLenum target, size_t sectionBytes) : target(target), sectionBytes(sectionBytes), buffer(GLBuffer::Create())
+    {
+        glBindBuffer(target, buffer.Get());
+        if (bufferStorage() && PersistentEnabled())
+        {
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            bufferStorage()(target, sectionBytes * FRAMES, nullptr, flags);
+            mapped = (unsigned char*)glMapBufferRange(target, 0, sectionBytes * FRAMES, flags);
+            if (!mapped)
+                std::cout << "ERROR::FRAME_RING_BUFFER:: persistent mapping failed, orphaning instead" << std::endl;
+        }
+        if (!mapped)
+        {
+            // a persistent buffer's storage is immutable, start over with a fresh one
+            buffer = GLBuffer::Create();
+            glBindBuffer(target, buffer.Get());
+            glBufferData(target, sectionBytes, nullptr, GL_STREAM_DRAW);
+        }
+        glBindBuffer(target, 0);
+    }
+
+    ~FrameRingBuffer()
+    {
+        for (GLsync &fence : fences)
+        {
+            if (fence)
+                glDeleteSync(fence);
+        }
+        if (mapped)
+        {
+            glBindBuffer(target, buffer.Get());
+            glUnmapBuffer(target);
+            glBindBuffer(target, 0);
+        }
+    }
+
+    FrameRingBuffer(const FrameRingBuffer&) = delete;
+    FrameRingBuffer& operator=(const FrameRingBuffer&) = delete;
+
+    bool Persistent() const
+    {
+        return mapped != nullptr;
+    }
+
+    // moves on to the next section, waiting until the GPU is done with it
+    void BeginFrame()
+    {
+        stats.frameBytes = used;
+        used = 0;
+        stats.lastWaitMilliseconds = 0.0;
+        if (!mapped)
+        {
+            glBindBuffer(target, buffer.Get());
+            glBufferData(target, sectionBytes, nullptr, GL_STREAM_DRAW);
+            glBindBuffer(target, 0);
+            return;
+        }
+        section = (section + 1) % FRAMES;
+        GLsync &fence = fences[section];
+        if (!fence)
+            return;
+        GLenum result = glClientWaitSync(fence, 0, 0);
+        if (result == GL_TIMEOUT_EXPIRED)
+        {
+            auto start = std::chrono::steady_clock::now();
+            // the flush makes sure the fence gets signaled at all
+            do
+                result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+            while (result == GL_TIMEOUT_EXPIRED);
+            stats.lastWaitMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            stats.waitMilliseconds += stats.lastWaitMilliseconds;
+            stats.waits++;
+        }
+        if (result == GL_WAIT_FAILED)
+            std::cout << "ERROR::FRAME_RING_BUFFER:: waiting on the fence of section " << section << " failed" << std::endl;
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    // fences the section after the last command reading it was issued
+    void EndFrame()
+    {
+        if (mapped)
+            fences[section] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    // copies bytes of data into the current section at a multiple of alignment
+    Range Write(const void *data, size_t bytes, size_t alignment = 1)
+    {
+        size_t offset = (used + alignment - 1) / alignment * alignment;
+        if (offset + bytes > sectionBytes)
+        {
+            if (stats.overflows++ == 0)
+                std::cout << "ERROR::FRAME_RING_BUFFER:: " << offset + bytes << " bytes written in a frame, the buffer holds "
+                          << sectionBytes << std::endl;
+            return Range();
+        }
+        used = offset + bytes;
+        stats.peakBytes = std::max(stats.peakBytes, used);
+        Range range;
+        range.buffer = buffer.Get();
+        range.size = (GLsizeiptr)bytes;
+        if (mapped)
+        {
+            range.offset = (GLintptr)(section * sectionBytes + offset);
+            memcpy(mapped + range.offset, data, bytes);
+        }
+        else
+        {
+            range.offset = (GLintptr)offset;
+            glBindBuffer(target, buffer.Get());
+            glBufferSubData(target, range.offset, range.size, data);
+            glBindBuffer(target, 0);
+        }
+        return range;
+    }
+
+    const Stats& GetStats() const
+    {
+        return stats;
+    }
+
+    // GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, the alignment of ranges bound as uniform blocks
+    static size_t UniformAlignment()
+    {
+        static GLint alignment = 0;
+        if (alignment == 0)
+            glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        return alignment > 0 ? (size_t)alignment : 256;
+    }
+
+private:
+    typedef void (APIENTRYP BufferStorage)(GLenum target, GLsizeiptr size, const void *data, GLbitfield flags);
+
+    GLenum target;
+    size_t sectionBytes;
+    GLBuffer buffer;
+    unsigned char *mapped = nullptr;
+    unsigned int section = 0;
+    size_t used = 0;
+    GLsync fences[FRAMES] = {};
+    Stats stats;
+
+    static BufferStorage& bufferStorage()
+    {
+        static BufferStorage function = nullptr;
+        return function;
+    }
+};
+#endif
@@ -0,0 +1,518 @@
+#ifndef GEOMETRY_ARENA_H
+#define GEOMETRY_ARENA_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/gl_extensions.h>
+#include <learnopengl/gl_object.h>
+#include <learnopengl/gl_state.h>
+#include <learnopengl/vertex_format.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <vector>
+
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+
+// First fit allocator of ranges in [0, capacity), free ranges are merged with their neighbours as they are freed
+class RangeAllocator
+{
+public:
+    static const size_t NONE = (size_t)-1;
+
+    explicit RangeAllocator(size_t capacity = 0)
+    {
+        Reset(capacity, 0);
+    }
+
+    // everything below used is taken, the rest is one free range
+    void Reset(size_t capacity, size_t used)
+    {
+        this->capacity = capacity;
+        freeRanges.clear();
+        if (used < capacity)
+            freeRanges[used] = capacity - used;
+    }
+
+    // offset of size free units aligned to alignment, NONE if no free range has room
+    size_t Allocate(size_t size, size_t alignment)
+    {
+        for (auto it = freeRanges.begin(); it != freeRanges.end(); ++it)
+        {
+            size_t start = (it->first + alignment - 1) / alignment * alignment;
+            size_t end = it->first + it->second;
+            if (start + size > end)
+                continue;
+            size_t rangeStart = it->first;
+            freeRanges.erase(it);
+            // the alignment gap before and whatever is left after stay free
+            if (start > rangeStart)
+                freeRanges[rangeStart] = start - rangeStart;
+            if (start + size < end)
+                freeRanges[start + size] = end - start - size;
+            return start;
+        }
+        return NONE;
+    }
+
+    void Free(size_t offset, size_t size)
+    {
+        auto next = freeRanges.lower_bound(offset);
+        if (next != freeRanges.end() && offset + size == next->first)
+        {
+            size += next->second;
+            next = freeRanges.erase(next);
+        }
+        if (next != freeRanges.begin())
+        {
+            auto previous = std::prev(next);
+            if (previous->first + previous->second == offset)
+            {
+                previous->second += size;
+                return;
+            }
+        }
+        freeRanges[offset] = size;
+    }
+
+    size_t Capacity() const
+    {
+        return capacity;
+    }
+
+    size_t FreeUnits() const
+    {
+        size_t total = 0;
+        for (const auto &range : freeRanges)
+            total += range.second;
+        return total;
+    }
+
+    size_t LargestFree() const
+    {
+        size_t largest = 0;
+        for (const auto &range : freeRanges)
+            largest = std::max(largest, range.second);
+        return largest;
+    }
+
+    size_t FreeRanges() const
+    {
+        return freeRanges.size();
+    }
+
+private:
+    size_t capacity = 0;
+    std::map<size_t, size_t> freeRanges;
+};
+
+// Shared vertex and index storage of every mesh. There is one vertex buffer and one vertex array per vertex
+// format and one index buffer bound to all of them, so drawing meshes of the same format needs no vertex array
+// switch: a mesh is a range of vertices (drawn with its first vertex as the base vertex) and a range of index bytes.
+//
+// A buffer that is full is rebuilt: the live ranges are copied, packed, into a new buffer of at least twice the
+// size, or of the same size when packing frees enough room (a compaction). Ranges are referenced through Blocks, whose
+// offsets follow them when they move. Only the context thread may use the arena.
+//
+// Where the context has glMultiDrawElementsIndirect (GL 4.3 or ARB_multi_draw_indirect, loaded by LoadFunctions)
+// MeshBatch submits runs of meshes sharing program, material and format with one call through DrawIndirect.
+class GeometryArena
+{
+public:
+    struct BufferStats
+    {
+        size_t capacityBytes = 0;
+        size_t usedBytes = 0;
+        size_t freeRanges = 0;
+        size_t largestFreeBytes = 0;
+        unsigned int blocks = 0;
+        unsigned int grows = 0;
+        unsigned int compactions = 0;
+        size_t movedBytes = 0;
+
+        // share of the free space that is not in the largest free range, 0 when the free space is in one piece
+        double Fragmentation() const
+        {
+            size_t freeBytes = capacityBytes - usedBytes;
+            return freeBytes ? 1.0 - (double)largestFreeBytes / freeBytes : 0.0;
+        }
+    };
+
+    // one GL buffer shared by ranges of units (vertices of a format, or bytes of indices)
+    class Buffer
+    {
+    public:
+        Buffer(size_t unitBytes, size_t capacity) : unitBytes(unitBytes)
+        {
+            buffer = GLBuffer::Create();
+            glBindBuffer(GL_COPY_WRITE_BUFFER, buffer.Get());
+            glBufferData(GL_COPY_WRITE_BUFFER, capacity * unitBytes, nullptr, GL_STATIC_DRAW);
+            ranges.Reset(capacity, 0);
+        }
+
+        // the range of a live block, offset and size in units
+        struct Range
+        {
+            size_t offset;
+            size_t size;
+            size_t alignment;
+        };
+
+        GLuint Id() const
+        {
+            return buffer.Get();
+        }
+
+        size_t UnitBytes() const
+        {
+            return unitBytes;
+        }
+
+        const Range& Get(uint32_t block) const
+        {
+            return blocks[block];
+        }
+
+        // a block of size units, rebuilding the buffer when it has no room
+        uint32_t Allocate(size_t size, size_t alignment)
+        {
+            // a size of 0 marks unused blocks
+            size = std::max<size_t>(size, 1);
+            size_t offset = ranges.Allocate(size, alignment);
+            if (offset == RangeAllocator::NONE)
+            {
+                // packing the live blocks makes room when the free space is there, just in pieces
+                size_t used = usedUnits();
+                size_t capacity = ranges.Capacity();
+                bool compact = capacity - used >= size + alignment;
+                rebuild(compact ? capacity : std::max(capacity * 2, used + size + alignment));
+                offset = ranges.Allocate(size, alignment);
+                // the alignment gaps of the packed blocks can eat the room a compaction counted on
+                if (offset == RangeAllocator::NONE)
+                {
+                    rebuild(std::max(capacity * 2, used + size + alignment));
+                    offset = ranges.Allocate(size, alignment);
+                }
+            }
+            uint32_t block;
+            if (!unusedBlocks.empty())
+            {
+                block = unusedBlocks.back();
+                unusedBlocks.pop_back();
+                blocks[block] = Range{offset, size, alignment};
+            }
+            else
+            {
+                block = (uint32_t)blocks.size();
+                blocks.push_back(Range{offset, size, alignment});
+            }
+            live++;
+            return block;
+        }
+
+        void Free(uint32_t block)
+        {
+            ranges.Free(blocks[block].offset, blocks[block].size);
+            blocks[block].size = 0;
+            unusedBlocks.push_back(block);
+            live--;
+        }
+
+        // writes bytes into block at byteOffset from its start
+        void Upload(uint32_t block, const void *data, size_t bytes, size_t byteOffset = 0)
+        {
+            // the copy target leaves the element array binding of the bound vertex array alone
+            glBindBuffer(GL_COPY_WRITE_BUFFER, buffer.Get());
+            glBufferSubData(GL_COPY_WRITE_BUFFER, blocks[block].offset * unitBytes + byteOffset, bytes, data);
+        }
+
+        BufferStats Stats() const
+        {
+            BufferStats result = stats;
+            result.capacityBytes = ranges.Capacity() * unitBytes;
+            result.usedBytes = usedUnits() * unitBytes;
+            result.freeRanges = ranges.FreeRanges();
+            result.largestFreeBytes = ranges.LargestFree() * unitBytes;
+            result.blocks = live;
+            return result;
+        }
+
+        // called after the buffer was replaced, to point the vertex arrays at the new one
+        std::function<void()> onRebuild;
+
+    private:
+        size_t unitBytes;
+        GLBuffer buffer;
+        RangeAllocator ranges;
+        std::vector<Range> blocks;
+        std::vector<uint32_t> unusedBlocks;
+        unsigned int live = 0;
+        BufferStats stats;
+
+        size_t usedUnits() const
+        {
+            return ranges.Capacity() - ranges.FreeUnits();
+        }
+
+        // copies the live blocks, packed in the order they are in now, to a new buffer of capacity units
+        void rebuild(size_t capacity)
+        {
+            if (capacity > ranges.Capacity())
+                stats.grows++;
+            else
+                stats.compactions++;
+            GLBuffer packed = GLBuffer::Create();
+            glBindBuffer(GL_COPY_WRITE_BUFFER, packed.Get());
+            glBufferData(GL_COPY_WRITE_BUFFER, capacity * unitBytes, nullptr, GL_STATIC_DRAW);
+            glBindBuffer(GL_COPY_READ_BUFFER, buffer.Get());
+
+            std::vector<uint32_t> order;
+            for (uint32_t block = 0; block < blocks.size(); block++)
+            {
+                if (blocks[block].size > 0)
+                    order.push_back(block);
+            }
+            std::sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) { return blocks[a].offset < blocks[b].offset; });
+            size_t end = 0;
+            for (uint32_t block : order)
+            {
+                Range &range = blocks[block];
+                size_t offset = (end + range.alignment - 1) / range.alignment * range.alignment;
+                glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, range.offset * unitBytes,
+                                    offset * unitBytes, range.size * unitBytes);
+                stats.movedBytes += range.size * unitBytes;
+                range.offset = offset;
+                end = offset + range.size;
+            }
+            buffer = std::move(packed);
+            // alignment gaps between packed blocks stay taken until the next rebuild
+            ranges.Reset(capacity, end);
+            if (onRebuild)
+                onRebuild();
+        }
+    };
+
+    // a range of one of the arena's buffers, freed with the block. Offsets change when the buffer is rebuilt, ask
+    // for them at draw time
+    class Block
+    {
+    public:
+        Block() = default;
+
+        Block(Buffer *buffer, uint32_t id) : buffer(buffer), id(id)
+        {
+        }
+
+        ~Block()
+        {
+            Reset();
+        }
+
+        Block(const Block&) = delete;
+        Block& operator=(const Block&) = delete;
+
+        Block(Block &&other) noexcept : buffer(other.buffer), id(other.id)
+        {
+            other.buffer = nullptr;
+        }
+
+        Block& operator=(Block &&other) noexcept
+        {
+            if (this != &other)
+            {
+                Reset();
+                buffer = other.buffer;
+                id = other.id;
+                other.buffer = nullptr;
+            }
+            return *this;
+        }
+
+        void Reset()
+        {
+            if (buffer)
+                buffer->Free(id);
+            buffer = nullptr;
+        }
+
+        explicit operator bool() const
+        {
+            return buffer != nullptr;
+        }
+
+        // in units of the buffer: vertices for vertex blocks, bytes for index blocks
+        size_t Offset() const
+        {
+            return buffer->Get(id).offset;
+        }
+
+        void Upload(const void *data, size_t bytes, size_t byteOffset = 0)
+        {
+            buffer->Upload(id, data, bytes, byteOffset);
+        }
+
+    private:
+        Buffer *buffer = nullptr;
+        uint32_t id = 0;
+    };
+
+    // the vertex buffer and vertex array of a vertex format
+    struct Pool
+    {
+        std::unique_ptr<Buffer> vertices;
+        GLVertexArray vertexArray;
+        // the InstanceBuffer the per-instance attributes of the vertex array read, 0 for none
+        uint64_t instanceSerial = 0;
+    };
+
+    // glMultiDrawElementsIndirect's command layout
+    struct DrawCommand
+    {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint firstIndex;
+        GLint baseVertex;
+        GLuint baseInstance;
+    };
+
+    // never destroyed, its buffers go with the context
+    static GeometryArena& Instance()
+    {
+        static GeometryArena *instance = new GeometryArena();
+        return *instance;
+    }
+
+    // loads glMultiDrawElementsIndirect, call once the context is current. Returns false without it, draws are
+    // then submitted one by one
+    bool LoadFunctions(GLADloadproc load)
+    {
+        multiDrawElementsIndirect = nullptr;
+        if (GLExtensions::Version(4, 3) || GLExtensions::Has("GL_ARB_multi_draw_indirect"))
+            multiDrawElementsIndirect = (decltype(multiDrawElementsIndirect))load("glMultiDrawElementsIndirect");
+        return multiDrawElementsIndirect != nullptr;
+    }
+
+    // false draws one by one even where indirect draws are available (--no-multi-draw)
+    static bool& MultiDrawEnabled()
+    {
+        static bool enabled = true;
+        return enabled;
+    }
+
+    bool MultiDrawSupported() const
+    {
+        return multiDrawElementsIndirect != nullptr && MultiDrawEnabled();
+    }
+
+    // count vertices of format
+    Block AllocateVertices(VertexFormat format, size_t count)
+    {
+        Buffer &buffer = *pool(format).vertices;
+        return Block(&buffer, buffer.Allocate(count, 1));
+    }
+
+    // bytes of indices, aligned so the first index is a whole number of indices in for either index type
+    Block AllocateIndices(size_t bytes)
+    {
+        Buffer &buffer = indexBuffer();
+        return Block(&buffer, buffer.Allocate(bytes, sizeof(unsigned int)));
+    }
+
+    GLuint VertexArray(VertexFormat format)
+    {
+        return pool(format).vertexArray.Get();
+    }
+
+    Pool& GetPool(VertexFormat format)
+    {
+        return pool(format);
+    }
+
+    // one glMultiDrawElementsIndirect of commands with the vertex array of their format bound, MultiDrawSupported only
+    void DrawIndirect(GLenum indexType, const std::vector<DrawCommand> &commands)
+    {
+        if (!indirectBuffer)
+            indirectBuffer = GLBuffer::Create();
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer.Get());
+        size_t bytes = commands.size() * sizeof(DrawCommand);
+        // orphaned every call, the previous commands may still be read by the GPU
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, std::max(bytes, indirectCapacity), nullptr, GL_STREAM_DRAW);
+        indirectCapacity = std::max(bytes, indirectCapacity);
+        glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, bytes, commands.data());
+        multiDrawElementsIndirect(GL_TRIANGLES, indexType, nullptr, (GLsizei)commands.size(), 0);
+    }
+
+    // the index buffer first, then the vertex buffer of each format in use
+    std::vector<std::pair<const char*, BufferStats>> Stats() const
+    {
+        std::vector<std::pair<const char*, BufferStats>> result;
+        if (indices)
+            result.push_back(std::make_pair("indices", indices->Stats()));
+        for (int format = 0; format < FORMAT_COUNT; format++)
+        {
+            if (pools[format].vertices)
+                result.push_back(std::make_pair(VertexPacking::Name((VertexFormat)format), pools[format].vertices->Stats()));
+        }
+        return result;
+    }
+
+private:
+    static const int FORMAT_COUNT = 3;
+    // first sizes of the buffers, they grow as meshes come in
+    static const size_t INITIAL_VERTICES = 1 << 16;
+    static const size_t INITIAL_INDEX_BYTES = 1 << 20;
+
+    Pool pools[FORMAT_COUNT];
+    std::unique_ptr<Buffer> indices;
+    GLBuffer indirectBuffer;
+    size_t indirectCapacity = 0;
+    void (APIENTRYP multiDrawElementsIndirect)(GLenum mode, GLenum type, const void *indirect, GLsizei drawcount, GLsizei stride) = nullptr;
+
+    GeometryArena() = default;
+
+    Buffer& indexBuffer()
+    {
+        if (!indices)
+        {
+            indices.reset(new Buffer(1, INITIAL_INDEX_BYTES));
+            indices->onRebuild = [this]() {
+                for (Pool &existing : pools)
+                {
+                    if (existing.vertices)
+                        bindIndices(existing);
+                }
+            };
+        }
+        return *indices;
+    }
+
+    Pool& pool(VertexFormat format)
+    {
+        Pool &result = pools[(int)format];
+        if (result.vertices)
+            return result;
+        result.vertices.reset(new Buffer(VertexPacking::Stride(format), INITIAL_VERTICES));
+        result.vertexArray = GLVertexArray::Create();
+        Pool *created = &result;
+        result.vertices->onRebuild = [created, format]() {
+            GLState::Instance().BindVertexArray(created->vertexArray.Get());
+            glBindBuffer(GL_ARRAY_BUFFER, created->vertices->Id());
+            VertexPacking::SetupAttributes(format);
+        };
+        result.vertices->onRebuild();
+        bindIndices(result);
+        return result;
+    }
+
+    void bindIndices(Pool &target)
+    {
+        GLState::Instance().BindVertexArray(target.vertexArray.Get());
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer().Id());
+    }
+};
+#endif
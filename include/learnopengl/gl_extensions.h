@@ -0,0 +1,60 @@
+#ifndef GL_EXTENSIONS_H
+#define GL_EXTENSIONS_H
+
+#include <glad/glad.h>
+
+#include <string>
+#include <unordered_set>
+
+// glad is generated for core 3.3 without extensions, the enums of the optional features we use are defined here
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
+#endif
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+
+// queries of the context's version and extension string, needs a current context
+class GLExtensions
+{
+public:
+    static bool Has(const std::string &extension)
+    {
+        return names().count(extension) != 0;
+    }
+
+    // true if the context is at least major.minor
+    static bool Version(int major, int minor)
+    {
+        GLint contextMajor = 0, contextMinor = 0;
+        glGetIntegerv(GL_MAJOR_VERSION, &contextMajor);
+        glGetIntegerv(GL_MINOR_VERSION, &contextMinor);
+        return contextMajor > major || (contextMajor == major && contextMinor >= minor);
+    }
+
+private:
+    static const std::unordered_set<std::string>& names()
+    {
+        static std::unordered_set<std::string> extensions;
+        static bool queried = false;
+        if (!queried)
+        {
+            GLint count = 0;
+            glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+            for (GLint i = 0; i < count; i++)
+                extensions.insert((const char*)glGetStringi(GL_EXTENSIONS, i));
+            queried = true;
+        }
+        return extensions;
+    }
+};
+#endif
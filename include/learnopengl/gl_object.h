@@ -0,0 +1,94 @@
+#ifndef GL_OBJECT_H
+#define GL_OBJECT_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/gl_state.h>
+
+#include <utility>
+
+// Owning, move-only handle of a GL object: the object is deleted with the handle, so GL objects follow the
+// lifetime of their C++ owner. Deleting needs the GL context, owners must be destroyed before glfwTerminate.
+template <typename Traits>
+class GLObject
+{
+public:
+    GLObject() = default;
+
+    explicit GLObject(GLuint id) : id(id)
+    {
+    }
+
+    ~GLObject()
+    {
+        Reset();
+    }
+
+    GLObject(const GLObject&) = delete;
+    GLObject& operator=(const GLObject&) = delete;
+
+    GLObject(GLObject &&other) noexcept : id(other.id)
+    {
+        other.id = 0;
+    }
+
+    GLObject& operator=(GLObject &&other) noexcept
+    {
+        if (this != &other)
+        {
+            Reset(other.id);
+            other.id = 0;
+        }
+        return *this;
+    }
+
+    // a new object of this type
+    static GLObject Create()
+    {
+        return GLObject(Traits::Create());
+    }
+
+    GLuint Get() const
+    {
+        return id;
+    }
+
+    explicit operator bool() const
+    {
+        return id != 0;
+    }
+
+    // deletes the object and takes ownership of newId instead
+    void Reset(GLuint newId = 0)
+    {
+        if (id != 0)
+            Traits::Delete(id);
+        id = newId;
+    }
+
+private:
+    GLuint id = 0;
+};
+
+struct GLBufferTraits
+{
+    static GLuint Create() { GLuint id; glGenBuffers(1, &id); return id; }
+    static void Delete(GLuint id) { glDeleteBuffers(1, &id); }
+};
+
+struct GLVertexArrayTraits
+{
+    static GLuint Create() { GLuint id; glGenVertexArrays(1, &id); return id; }
+    static void Delete(GLuint id) { GLState::Instance().ForgetVertexArray(id); glDeleteVertexArrays(1, &id); }
+};
+
+struct GLTextureTraits
+{
+    static GLuint Create() { GLuint id; glGenTextures(1, &id); return id; }
+    static void Delete(GLuint id) { GLState::Instance().ForgetTexture(id); glDeleteTextures(1, &id); }
+};
+
+typedef GLObject<GLBufferTraits> GLBuffer;
+typedef GLObject<GLVertexArrayTraits> GLVertexArray;
+typedef GLObject<GLTextureTraits> GLTexture;
+#endif
@@ -0,0 +1,315 @@
+#ifndef GL_STATE_H
+#define GL_STATE_H
+
+#include <glad/glad.h>
+
+#include <iostream>
+
+// Shadow copy of the GL state the renderer changes all the time: the program, the vertex array, the framebuffer,
+// the 2D and cube map texture of every unit, and the depth, blend and cull state. Every setter compares with the
+// shadow first, so only real changes reach the driver. The active texture unit is switched only when a texture has
+// to be bound on another unit.
+//
+// The shadow is only right as long as everything goes through here, texture uploads bind through BindTexture too.
+// ImGui changes state behind its back but puts all of it back when it is done. Code that can't be tracked has to
+// call Invalidate after it, which makes the next call of each setter go to the driver. Deleting a vertex array or
+// texture through GLObject or the TextureRegistry forgets it.
+//
+// With Debug() on every setter first checks its shadow against glGet and reports mismatches, which are missing
+// Invalidate or Forget calls. Needs the GL context, like every GL call.
+class GLState
+{
+public:
+    enum Call { Program, VertexArray, Framebuffer, ActiveTexture, Texture, Capability, Depth, Blend, Cull, CALL_COUNT };
+
+    // calls made to the driver and calls skipped because the state was already set, per kind of call
+    struct Counters
+    {
+        unsigned int issued[CALL_COUNT] = {};
+        unsigned int skipped[CALL_COUNT] = {};
+
+        unsigned int Issued() const
+        {
+            unsigned int total = 0;
+            for (unsigned int count : issued)
+                total += count;
+            return total;
+        }
+
+        unsigned int Skipped() const
+        {
+            unsigned int total = 0;
+            for (unsigned int count : skipped)
+                total += count;
+            return total;
+        }
+    };
+
+    static const unsigned int MAX_TEXTURE_UNITS = 16;
+
+    static GLState& Instance()
+    {
+        static GLState instance;
+        return instance;
+    }
+
+    // checks the shadow against glGet on every call (--gl-state-debug)
+    static bool& Debug()
+    {
+        static bool debug = false;
+        return debug;
+    }
+
+    static const char* Name(Call call)
+    {
+        static const char *names[CALL_COUNT] = {"program", "vertex array", "framebuffer", "active texture", "texture",
+                                                "enable/disable", "depth", "blend", "cull"};
+        return names[call];
+    }
+
+    GLState(const GLState&) = delete;
+    GLState& operator=(const GLState&) = delete;
+
+    // forgets everything, the next call of every setter goes to the driver
+    void Invalidate()
+    {
+        program = vertexArray = framebuffer = UNKNOWN;
+        activeUnit = UNKNOWN;
+        for (TextureUnit &unit : units)
+            unit.texture2D = unit.textureCubeMap = UNKNOWN;
+        depthTest = blend = cullFace = depthMask = UNKNOWN_FLAG;
+        depthFunc = blendSource = blendDestination = cullMode = UNKNOWN;
+    }
+
+    // starts the counters of a new frame, LastFrame returns the ones of the frame before
+    void BeginFrame()
+    {
+        lastFrame = current;
+        current = Counters();
+    }
+
+    const Counters& LastFrame() const
+    {
+        return lastFrame;
+    }
+
+    void UseProgram(GLuint id)
+    {
+        if (Debug())
+            check(program, GL_CURRENT_PROGRAM, "program");
+        if (!changed(program, id, Program))
+            return;
+        glUseProgram(id);
+    }
+
+    void BindVertexArray(GLuint id)
+    {
+        if (Debug())
+            check(vertexArray, GL_VERTEX_ARRAY_BINDING, "vertex array");
+        if (!changed(vertexArray, id, VertexArray))
+            return;
+        glBindVertexArray(id);
+    }
+
+    // binds id as both the draw and the read framebuffer
+    void BindFramebuffer(GLuint id)
+    {
+        if (Debug())
+        {
+            check(framebuffer, GL_DRAW_FRAMEBUFFER_BINDING, "draw framebuffer");
+            check(framebuffer, GL_READ_FRAMEBUFFER_BINDING, "read framebuffer");
+        }
+        if (!changed(framebuffer, id, Framebuffer))
+            return;
+        glBindFramebuffer(GL_FRAMEBUFFER, id);
+    }
+
+    // binds texture to target (GL_TEXTURE_2D or GL_TEXTURE_CUBE_MAP) of unit, the unit's number not GL_TEXTURE0 + unit
+    void BindTexture(unsigned int unit, GLenum target, GLuint texture)
+    {
+        if (unit >= MAX_TEXTURE_UNITS || (target != GL_TEXTURE_2D && target != GL_TEXTURE_CUBE_MAP))
+        {
+            // not tracked
+            activateUnit(unit);
+            glBindTexture(target, texture);
+            current.issued[Texture]++;
+            return;
+        }
+        GLuint &bound = target == GL_TEXTURE_2D ? units[unit].texture2D : units[unit].textureCubeMap;
+        if (Debug())
+            checkTexture(unit, target, bound);
+        if (!changed(bound, texture, Texture))
+            return;
+        activateUnit(unit);
+        glBindTexture(target, texture);
+    }
+
+    // GL_DEPTH_TEST, GL_BLEND or GL_CULL_FACE, other capabilities go straight to the driver
+    void Enable(GLenum capability, bool enabled = true)
+    {
+        int *flag = capability == GL_DEPTH_TEST ? &depthTest : capability == GL_BLEND ? &blend
+                  : capability == GL_CULL_FACE ? &cullFace : nullptr;
+        if (flag && Debug())
+            checkFlag(*flag, glIsEnabled(capability), "enable/disable");
+        if (flag && !changed(*flag, enabled ? 1 : 0, Capability))
+            return;
+        if (!flag)
+            current.issued[Capability]++;
+        if (enabled)
+            glEnable(capability);
+        else
+            glDisable(capability);
+    }
+
+    void Disable(GLenum capability)
+    {
+        Enable(capability, false);
+    }
+
+    void DepthMask(bool write)
+    {
+        if (Debug())
+        {
+            GLboolean value = GL_FALSE;
+            glGetBooleanv(GL_DEPTH_WRITEMASK, &value);
+            checkFlag(depthMask, value, "depth mask");
+        }
+        if (!changed(depthMask, write ? 1 : 0, Depth))
+            return;
+        glDepthMask(write ? GL_TRUE : GL_FALSE);
+    }
+
+    void DepthFunc(GLenum function)
+    {
+        if (Debug())
+            check(depthFunc, GL_DEPTH_FUNC, "depth function");
+        if (!changed(depthFunc, function, Depth))
+            return;
+        glDepthFunc(function);
+    }
+
+    // the same factors for color and alpha
+    void BlendFunc(GLenum source, GLenum destination)
+    {
+        if (Debug())
+        {
+            check(blendSource, GL_BLEND_SRC_RGB, "blend source");
+            check(blendSource, GL_BLEND_SRC_ALPHA, "blend source alpha");
+            check(blendDestination, GL_BLEND_DST_RGB, "blend destination");
+            check(blendDestination, GL_BLEND_DST_ALPHA, "blend destination alpha");
+        }
+        if (blendSource == source && blendDestination == destination)
+        {
+            current.skipped[Blend]++;
+            return;
+        }
+        blendSource = source;
+        blendDestination = destination;
+        current.issued[Blend]++;
+        glBlendFunc(source, destination);
+    }
+
+    void CullFace(GLenum mode)
+    {
+        if (Debug())
+            check(cullMode, GL_CULL_FACE_MODE, "cull face");
+        if (!changed(cullMode, mode, Cull))
+            return;
+        glCullFace(mode);
+    }
+
+    // the vertex array or texture id is being deleted, GL falls back to 0 wherever it was bound
+    void ForgetVertexArray(GLuint id)
+    {
+        if (vertexArray == id)
+            vertexArray = 0;
+    }
+
+    void ForgetTexture(GLuint id)
+    {
+        for (TextureUnit &unit : units)
+        {
+            if (unit.texture2D == id)
+                unit.texture2D = 0;
+            if (unit.textureCubeMap == id)
+                unit.textureCubeMap = 0;
+        }
+    }
+
+private:
+    static const GLuint UNKNOWN = 0xFFFFFFFFu;
+    static const int UNKNOWN_FLAG = -1;
+
+    struct TextureUnit
+    {
+        GLuint texture2D = UNKNOWN;
+        GLuint textureCubeMap = UNKNOWN;
+    };
+
+    GLuint program, vertexArray, framebuffer, activeUnit;
+    TextureUnit units[MAX_TEXTURE_UNITS];
+    int depthTest, blend, cullFace, depthMask;
+    GLenum depthFunc, blendSource, blendDestination, cullMode;
+    Counters current, lastFrame;
+
+    GLState()
+    {
+        Invalidate();
+    }
+
+    // updates shadow and counts the call, false if it was already set
+    template <typename T>
+    bool changed(T &shadow, T value, Call call)
+    {
+        if (shadow == value)
+        {
+            current.skipped[call]++;
+            return false;
+        }
+        shadow = value;
+        current.issued[call]++;
+        return true;
+    }
+
+    void activateUnit(unsigned int unit)
+    {
+        if (Debug())
+            check(activeUnit == UNKNOWN ? UNKNOWN : GL_TEXTURE0 + activeUnit, GL_ACTIVE_TEXTURE, "active texture");
+        if (!changed(activeUnit, (GLuint)unit, ActiveTexture))
+            return;
+        glActiveTexture(GL_TEXTURE0 + unit);
+    }
+
+    void check(GLuint shadow, GLenum name, const char *what) const
+    {
+        if (shadow == UNKNOWN)
+            return;
+        GLint value = 0;
+        glGetIntegerv(name, &value);
+        if ((GLuint)value != shadow)
+            std::cout << "ERROR::GL_STATE:: " << what << " is " << value << ", the shadow has " << shadow << std::endl;
+    }
+
+    void checkFlag(int shadow, GLboolean value, const char *what) const
+    {
+        if (shadow != UNKNOWN_FLAG && shadow != (value ? 1 : 0))
+            std::cout << "ERROR::GL_STATE:: " << what << " is " << (value ? "on" : "off") << ", the shadow has "
+                      << (shadow ? "on" : "off") << std::endl;
+    }
+
+    // switches the active unit to read the binding back and restores it, debug only
+    void checkTexture(unsigned int unit, GLenum target, GLuint shadow) const
+    {
+        if (shadow == UNKNOWN)
+            return;
+        GLint active = 0, value = 0;
+        glGetIntegerv(GL_ACTIVE_TEXTURE, &active);
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glGetIntegerv(target == GL_TEXTURE_2D ? GL_TEXTURE_BINDING_2D : GL_TEXTURE_BINDING_CUBE_MAP, &value);
+        glActiveTexture((GLenum)active);
+        if ((GLuint)value != shadow)
+            std::cout << "ERROR::GL_STATE:: texture unit " << unit << (target == GL_TEXTURE_2D ? " 2D" : " cube map")
+                      << " is " << value << ", the shadow has " << shadow << std::endl;
+    }
+};
+#endif
@@ -0,0 +1,88 @@
+#ifndef INSTANCE_BUFFER_H
+#define INSTANCE_BUFFER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <learnopengl/gl_object.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// what the instanced shaders read per instance (see models_instanced.vs): the model matrix in locations 6 to 9, a
+// column each, and a color the fragment shader multiplies with, in location 10
+struct InstanceData {
+    glm::mat4 model;
+    glm::vec4 tint = glm::vec4(1.0f);
+};
+
+// Vertex buffer of per-instance attributes for Model::DrawInstanced. A mesh points its vertex array at the buffer
+// the first time it is drawn with it; Serial tells buffers apart, a new buffer may get the id of a deleted one.
+class InstanceBuffer
+{
+public:
+    static const GLuint FIRST_LOCATION = 6;
+    static const GLuint TINT_LOCATION = 10;
+
+    InstanceBuffer() : buffer(GLBuffer::Create()), serial(nextSerial()++)
+    {
+    }
+
+    // replaces the instances. Grows the buffer when they don't fit, otherwise orphans it, so a draw still reading
+    // the previous instances doesn't stall the upload
+    void Update(const InstanceData *instances, size_t count)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, buffer.Get());
+        if (count > capacity)
+            capacity = count;
+        glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(InstanceData), nullptr, GL_STREAM_DRAW);
+        if (count > 0)
+            glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(InstanceData), instances);
+        this->count = count;
+    }
+
+    void Update(const std::vector<InstanceData> &instances)
+    {
+        Update(instances.data(), instances.size());
+    }
+
+    size_t Count() const
+    {
+        return count;
+    }
+
+    uint64_t Serial() const
+    {
+        return serial;
+    }
+
+    // points the per-instance attributes of the bound vertex array at this buffer
+    void SetupAttributes() const
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, buffer.Get());
+        for (GLuint column = 0; column < 4; column++)
+        {
+            glEnableVertexAttribArray(FIRST_LOCATION + column);
+            glVertexAttribPointer(FIRST_LOCATION + column, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+                                  (void*)(offsetof(InstanceData, model) + column * sizeof(glm::vec4)));
+            glVertexAttribDivisor(FIRST_LOCATION + column, 1);
+        }
+        glEnableVertexAttribArray(TINT_LOCATION);
+        glVertexAttribPointer(TINT_LOCATION, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)offsetof(InstanceData, tint));
+        glVertexAttribDivisor(TINT_LOCATION, 1);
+    }
+
+private:
+    GLBuffer buffer;
+    uint64_t serial;
+    size_t capacity = 0;
+    size_t count = 0;
+
+    static uint64_t& nextSerial()
+    {
+        static uint64_t serial = 1;
+        return serial;
+    }
+};
+#endif
@@ -0,0 +1,89 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <string>
+
+// read-only memory mapping of a whole file. The mapping is released when the object goes out of scope.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+
+    explicit MappedFile(const std::string &path)
+    {
+        Open(path);
+    }
+
+    ~MappedFile()
+    {
+        Close();
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile &&other) noexcept : data(other.data), size(other.size)
+    {
+        other.data = nullptr;
+        other.size = 0;
+    }
+
+    MappedFile& operator=(MappedFile &&other) noexcept
+    {
+        if (this != &other)
+        {
+            Close();
+            data = other.data;
+            size = other.size;
+            other.data = nullptr;
+            other.size = 0;
+        }
+        return *this;
+    }
+
+    // maps the file at path, returns false if it doesn't exist or can't be mapped
+    bool Open(const std::string &path)
+    {
+        Close();
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size <= 0)
+        {
+            close(fd);
+            return false;
+        }
+        void *mapped = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        // the mapping keeps its own reference to the file, so the descriptor isn't needed anymore
+        close(fd);
+        if (mapped == MAP_FAILED)
+            return false;
+        data = (const unsigned char*)mapped;
+        size = (size_t)st.st_size;
+        return true;
+    }
+
+    void Close()
+    {
+        if (data)
+            munmap((void*)data, size);
+        data = nullptr;
+        size = 0;
+    }
+
+    bool IsOpen() const { return data != nullptr; }
+    const unsigned char* Data() const { return data; }
+    size_t Size() const { return size; }
+
+private:
+    const unsigned char *data = nullptr;
+    size_t size = 0;
+};
+#endif
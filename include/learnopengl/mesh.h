@@ -6,131 +6,491 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <learnopengl/geometry_arena.h>
+#include <learnopengl/gl_object.h>
+#include <learnopengl/gl_state.h>
+#include <learnopengl/instance_buffer.h>
 #include <learnopengl/shader.h>
+#include <learnopengl/vertex_format.h>
 
+#include <algorithm>
+#include <iostream>
 #include <string>
+#include <utility>
 #include <vector>
 using namespace std;
 
-struct Vertex {
-    // position
-    glm::vec3 Position;
-    // normal
-    glm::vec3 Normal;
-    // texCoords
-    glm::vec2 TexCoords;
-    // tangent
-    glm::vec3 Tangent;
-    // bitangent
-    glm::vec3 Bitangent;
-};
-
-
-
 struct Texture {
     unsigned int id;
     string type;
     string path;
 };
 
+// a coarser version of a mesh: triangles over the same vertices, and the object space distance by which
+// they may be off the full mesh
+struct MeshLod {
+    vector<unsigned int> indices;
+    float error = 0.0f;
+};
+
+// triangles and draw calls submitted by Mesh::Draw and MeshBatch, reset by the application every frame
+struct DrawStatistics {
+    size_t triangles = 0;
+    // what the same draws would have cost at full detail
+    size_t fullTriangles = 0;
+    // GL draw calls, and the meshes they drew: a multi-draw draws several
+    unsigned int drawCalls = 0;
+    unsigned int meshes = 0;
+};
+
+inline DrawStatistics& FrameDrawStatistics()
+{
+    static DrawStatistics statistics;
+    return statistics;
+}
+
+// the textures of a mesh as one program samples them, resolved on the first draw with that program: where each
+// sampler is, which unit it reads and which texture goes there. Drawing is a loop over slots, no lookups
+struct MaterialBinding {
+    struct Slot {
+        GLint location;
+        GLuint unit;
+        GLuint texture;
+    };
+
+    GLuint program = 0;
+    Uniform packedVertices;
+    unsigned int slotCount = 0;
+    Slot slots[GLState::MAX_TEXTURE_UNITS];
+};
+
+// CPU-side mesh as produced by the importer (or read back from the mesh cache), before anything is uploaded.
+// textures only carry type and path here, ids are resolved by the Model that owns the mesh.
+struct MeshData {
+    vector<Vertex>       vertices;
+    vector<unsigned int> indices;
+    vector<Texture>      textures;
+    // coarser levels of detail, finest first (indices is the full one)
+    vector<MeshLod>      lods;
+    // object space bounding box
+    glm::vec3 boundsMin = glm::vec3(0.0f);
+    glm::vec3 boundsMax = glm::vec3(0.0f);
+
+    void ComputeBounds()
+    {
+        if (vertices.empty())
+            return;
+        boundsMin = boundsMax = vertices[0].Position;
+        for (const Vertex &vertex : vertices)
+        {
+            boundsMin = glm::min(boundsMin, vertex.Position);
+            boundsMax = glm::max(boundsMax, vertex.Position);
+        }
+    }
+};
+
+// Owns its vertices and indices in the GeometryArena, so it can be moved but not copied. vertices and indices stay
+// in memory for SetVertexFormat and CPU side use unless ReleaseGeometry drops them after the upload.
 class Mesh {
+    friend class MeshBatch;
 public:
     // mesh Data
     vector<Vertex>       vertices;
     vector<unsigned int> indices;
     vector<Texture>      textures;
 
-    unsigned int VAO;
+    // GL_UNSIGNED_SHORT when every index fits into 16 bits, GL_UNSIGNED_INT otherwise
+    GLenum indexType = GL_UNSIGNED_INT;
+    // prepended to the sampler names, set it with SetTextureNamePrefix
     std::string glslIdentifierPrefix;
-    // constructor
-    Mesh(const vector<Vertex> &vertices, const vector<unsigned int> &indices, const vector<Texture> &textures)
-    : vertices(vertices), indices(indices), textures(textures)
+    // object space bounding box
+    glm::vec3 boundsMin = glm::vec3(0.0f);
+    glm::vec3 boundsMax = glm::vec3(0.0f);
+    // levels of detail in the index buffer, level 0 is indices
+    struct LodRange {
+        size_t indexOffset;
+        unsigned int indexCount;
+        float error;
+    };
+    vector<LodRange> lods;
+    // layout of the vertex buffer, and how far it is off the vertices for the packed layouts
+    VertexFormat vertexFormat = VertexFormat::Full;
+    VertexPacking::PackingError packingError;
+    // constructor, pass the vectors with std::move to avoid copying them
+    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures)
+    : vertices(std::move(vertices)), indices(std::move(indices)), textures(std::move(textures))
     {
         // now that we have all the required data, set the vertex buffers and its attribute pointers.
-        setupMesh();
+        setupMesh(vector<MeshLod>());
+        resolveSamplerNames();
+    }
+
+    Mesh(MeshData data, VertexFormat format = VertexFormat::Full)
+    : vertices(std::move(data.vertices)), indices(std::move(data.indices)), textures(std::move(data.textures)),
+      boundsMin(data.boundsMin), boundsMax(data.boundsMax), vertexFormat(format)
+    {
+        setupMesh(data.lods);
+        resolveSamplerNames();
+    }
+
+    Mesh(const Mesh&) = delete;
+    Mesh& operator=(const Mesh&) = delete;
+    Mesh(Mesh&&) = default;
+    Mesh& operator=(Mesh&&) = default;
+
+    // samplers are named prefix + type + number, e.g. "material.texture_diffuse1"
+    void SetTextureNamePrefix(const std::string &prefix)
+    {
+        glslIdentifierPrefix = prefix;
+        resolveSamplerNames();
+    }
+
+    // replaces the texture id of textures[index], e.g. once a streamed texture is uploaded
+    void SetTexture(size_t index, unsigned int id)
+    {
+        textures[index].id = id;
+        for (MaterialBinding &material : materials)
+        {
+            if (index < material.slotCount)
+                material.slots[index].texture = id;
+        }
+    }
+
+    // re-uploads the vertices in another layout
+    void SetVertexFormat(VertexFormat format)
+    {
+        if (format == vertexFormat)
+            return;
+        if (GeometryReleased())
+        {
+            std::cout << "WARNING::MESH:: can't change the vertex format, the vertices were released" << std::endl;
+            return;
+        }
+        // moves the vertices to the arena's buffer of the new format, the indices stay where they are
+        vertexFormat = format;
+        uploadVertices();
+    }
+
+    // the arena's vertex array of the mesh's format, shared with every mesh of that format
+    GLuint VertexArray() const
+    {
+        return GeometryArena::Instance().VertexArray(vertexFormat);
+    }
+
+    // frees vertices and indices, the mesh keeps drawing from its buffers
+    void ReleaseGeometry()
+    {
+        vector<Vertex>().swap(vertices);
+        vector<unsigned int>().swap(indices);
+    }
+
+    bool GeometryReleased() const
+    {
+        return vertices.empty() && vertexCount > 0;
+    }
+
+    size_t VertexCount() const
+    {
+        return vertexCount;
+    }
+
+    size_t VertexBytes() const
+    {
+        return vertexCount * VertexPacking::Stride(vertexFormat);
+    }
+
+    // memory of the vertex and index buffers
+    size_t GpuBytes() const
+    {
+        return VertexBytes() + indexBufferBytes;
+    }
+
+    // memory of vertices and indices
+    size_t CpuBytes() const
+    {
+        return vertices.capacity() * sizeof(Vertex) + indices.capacity() * sizeof(unsigned int);
+    }
+
+    // coarsest level of detail whose error stays below pixelError pixels when one object space unit covers
+    // pixelsPerUnit pixels
+    unsigned int SelectLod(float pixelsPerUnit, float pixelError) const
+    {
+        unsigned int lod = 0;
+        while (lod + 1 < lods.size() && lods[lod + 1].error * pixelsPerUnit <= pixelError)
+            lod++;
+        return lod;
+    }
+
+    // render the mesh. Allocates only the first time it is drawn with a program, to resolve its material
+    void Draw(Shader &shader, unsigned int lod = 0)
+    {
+        bind(shader);
+        const LodRange &range = lods[std::min<size_t>(lod, lods.size() - 1)];
+        glDrawElementsBaseVertex(GL_TRIANGLES, range.indexCount, indexType, indexOffset(range), baseVertex());
+        countDraw(range, 1);
+        FrameDrawStatistics().drawCalls++;
+    }
+
+    // renders an instance of the mesh for every instance in instances, with a shader reading the per-instance
+    // attributes (see InstanceBuffer)
+    void DrawInstanced(Shader &shader, const InstanceBuffer &instances, unsigned int lod = 0)
+    {
+        if (instances.Count() == 0)
+            return;
+        bind(shader);
+        // the vertex array is bound by bind and shared by the meshes of the format, point it at these
+        // instances once
+        GeometryArena::Pool &pool = GeometryArena::Instance().GetPool(vertexFormat);
+        if (pool.instanceSerial != instances.Serial())
+        {
+            instances.SetupAttributes();
+            pool.instanceSerial = instances.Serial();
+        }
+        const LodRange &range = lods[std::min<size_t>(lod, lods.size() - 1)];
+        glDrawElementsInstancedBaseVertex(GL_TRIANGLES, range.indexCount, indexType, indexOffset(range),
+                                          (GLsizei)instances.Count(), baseVertex());
+        countDraw(range, instances.Count());
+        FrameDrawStatistics().drawCalls++;
+    }
+
+    // the material of this mesh for shader's program, resolved the first time it is asked for
+    const MaterialBinding& Material(Shader &shader)
+    {
+        for (const MaterialBinding &material : materials)
+        {
+            if (material.program == shader.ID)
+                return material;
+        }
+        MaterialBinding material;
+        material.program = shader.ID;
+        material.packedVertices = shader.GetUniform("packedVertices");
+        if (textures.size() > GLState::MAX_TEXTURE_UNITS)
+            std::cout << "WARNING::MESH:: " << textures.size() << " textures, only the first "
+                      << GLState::MAX_TEXTURE_UNITS << " are bound" << std::endl;
+        material.slotCount = (unsigned int)std::min<size_t>(textures.size(), GLState::MAX_TEXTURE_UNITS);
+        // the program keeps its sampler units, every mesh drawn with it reads a sampler from the same unit
+        for (unsigned int i = 0; i < material.slotCount; i++)
+        {
+            Uniform sampler = shader.GetUniform(samplerNames[i]);
+            GLuint unit = sampler.Valid() ? shader.SamplerUnit(sampler) : 0;
+            material.slots[i] = MaterialBinding::Slot{sampler.location, unit, textures[i].id};
+        }
+        materials.push_back(material);
+        return materials.back();
+    }
+
+private:
+    // render data, ranges of the arena's buffers
+    GeometryArena::Block vertexBlock, indexBlock;
+    // name of the sampler of every texture
+    vector<UniformName> samplerNames;
+    // one per program the mesh was drawn with, usually just one
+    vector<MaterialBinding> materials;
+
+    // binds the textures of the mesh's material for shader's program and its vertex array
+    void bind(Shader &shader)
+    {
+        GLState &state = GLState::Instance();
+        const MaterialBinding &material = Material(shader);
+        // bind every texture at the unit of its sampler, set in the program when the material was resolved. Meshes
+        // sharing a texture leave it bound for each other; textures the program doesn't sample aren't bound
+        for (unsigned int i = 0; i < material.slotCount; i++)
+        {
+            const MaterialBinding::Slot &slot = material.slots[i];
+            if (slot.location >= 0)
+                state.BindTexture(slot.unit, GL_TEXTURE_2D, slot.texture);
+        }
+
+        // the shaders decode the normal from the tangent frame attribute in the packed layouts
+        shader.setBool(material.packedVertices, vertexFormat != VertexFormat::Full);
+
+        // the vertex array stays bound: whatever draws next binds its own
+        state.BindVertexArray(VertexArray());
+    }
+
+    size_t indexSize() const
+    {
+        return indexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int);
+    }
+
+    // in the arena's index buffer, in bytes
+    void* indexOffset(const LodRange &range) const
+    {
+        return (void*)(indexBlock.Offset() + range.indexOffset * indexSize());
+    }
+
+    GLint baseVertex() const
+    {
+        return (GLint)vertexBlock.Offset();
+    }
+
+    // the indirect draw command of a level of detail
+    GeometryArena::DrawCommand command(unsigned int lod) const
+    {
+        const LodRange &range = lods[std::min<size_t>(lod, lods.size() - 1)];
+        return GeometryArena::DrawCommand{range.indexCount, 1, (GLuint)(indexBlock.Offset() / indexSize() + range.indexOffset),
+                                          baseVertex(), 0};
+    }
+
+    void countDraw(const LodRange &range, size_t instances) const
+    {
+        DrawStatistics &statistics = FrameDrawStatistics();
+        statistics.triangles += range.indexCount / 3 * instances;
+        statistics.fullTriangles += lods[0].indexCount / 3 * instances;
+        statistics.meshes++;
     }
 
-    // render the mesh
-    void Draw(Shader &shader)
+    size_t vertexCount = 0;
+    size_t indexBufferBytes = 0;
+
+    // names the sampler of each texture, prefix + type + number (the N in texture_diffuseN)
+    void resolveSamplerNames()
     {
-        // bind appropriate textures
         unsigned int diffuseNr  = 1;
         unsigned int specularNr = 1;
         unsigned int normalNr   = 1;
         unsigned int heightNr   = 1;
-        for(unsigned int i = 0; i < textures.size(); i++)
+        samplerNames.clear();
+        for (const Texture &texture : textures)
         {
-            glActiveTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
-            // retrieve texture number (the N in diffuse_textureN)
             string number;
-            string name = textures[i].type;
+            const string &name = texture.type;
             if(name == "texture_diffuse")
                 number = std::to_string(diffuseNr++);
             else if(name == "texture_specular")
-                number = std::to_string(specularNr++); // transfer unsigned int to stream
+                number = std::to_string(specularNr++);
             else if(name == "texture_normal")
-                number = std::to_string(normalNr++); // transfer unsigned int to stream
+                number = std::to_string(normalNr++);
             else if(name == "texture_height")
-                number = std::to_string(heightNr++); // transfer unsigned int to stream
+                number = std::to_string(heightNr++);
+            samplerNames.push_back(UniformName(glslIdentifierPrefix + name + number));
+        }
+        // the sampler locations depend on the names
+        materials.clear();
+    }
 
-            // now set the sampler to the correct texture unit
-            glUniform1i(glGetUniformLocation(shader.ID, (glslIdentifierPrefix + name + number).c_str()), i);
-            // and finally bind the texture
-            glBindTexture(GL_TEXTURE_2D, textures[i].id);
+    // puts vertices and indices into the arena, the index block holds indices followed by the indices of every lod
+    void setupMesh(const vector<MeshLod> &lodData)
+    {
+        vertexCount = vertices.size();
+        // load data into vertex buffers
+        uploadVertices();
+
+        lods.clear();
+        lods.push_back(LodRange{0, (unsigned int)indices.size(), 0.0f});
+        vector<unsigned int> allIndices(indices);
+        for (const MeshLod &lod : lodData)
+        {
+            lods.push_back(LodRange{allIndices.size(), (unsigned int)lod.indices.size(), lod.error});
+            allIndices.insert(allIndices.end(), lod.indices.begin(), lod.indices.end());
         }
 
+        // half the index memory and bandwidth for meshes with at most 65536 vertices, the base vertex keeps the
+        // indices relative to the mesh
+        if (vertices.size() <= 65536)
+        {
+            vector<unsigned short> shortIndices(allIndices.begin(), allIndices.end());
+            indexType = GL_UNSIGNED_SHORT;
+            indexBufferBytes = shortIndices.size() * sizeof(unsigned short);
+            indexBlock = GeometryArena::Instance().AllocateIndices(indexBufferBytes);
+            indexBlock.Upload(shortIndices.data(), indexBufferBytes);
+        }
+        else
+        {
+            indexType = GL_UNSIGNED_INT;
+            indexBufferBytes = allIndices.size() * sizeof(unsigned int);
+            indexBlock = GeometryArena::Instance().AllocateIndices(indexBufferBytes);
+            indexBlock.Upload(allIndices.data(), indexBufferBytes);
+        }
+    }
 
+    // (re)places the vertices in the arena's buffer of vertexFormat, the vertex array of the format already has
+    // its attribute pointers
+    void uploadVertices()
+    {
+        GeometryArena::Block block = GeometryArena::Instance().AllocateVertices(vertexFormat, vertices.size());
+        if (vertexFormat == VertexFormat::Full)
+        {
+            // A great thing about structs is that their memory layout is sequential for all its items.
+            // The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
+            // again translates to 3/2 floats which translates to a byte array.
+            block.Upload(vertices.data(), vertices.size() * sizeof(Vertex));
+            packingError = VertexPacking::PackingError();
+        }
+        else
+        {
+            vector<unsigned char> packed;
+            VertexPacking::Pack(vertices, vertexFormat, packed, &packingError);
+            block.Upload(packed.data(), packed.size());
+        }
+        // frees the block in the old format's buffer, if there was one
+        vertexBlock = std::move(block);
+    }
+};
 
-        // draw mesh
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
+// Draws of meshes sharing program, material, vertex format and index type, submitted together: with one
+// glMultiDrawElementsIndirect where the context has it (see GeometryArena), otherwise with a base vertex draw each.
+// Add flushes when the mesh doesn't fit the open batch; flush before changing a uniform the batched draws read.
+// Allocates only while the command list grows to the longest batch seen
+class MeshBatch {
+public:
+    void Add(Mesh &mesh, Shader &shader, unsigned int lod = 0)
+    {
+        if (!commands.empty() && !fits(mesh, shader))
+            Flush();
+        if (commands.empty())
+        {
+            first = &mesh;
+            program = shader.ID;
+            mesh.bind(shader);
+        }
+        commands.push_back(mesh.command(lod));
+        mesh.countDraw(mesh.lods[std::min<size_t>(lod, mesh.lods.size() - 1)], 1);
+    }
 
-        // always good practice to set everything back to defaults once configured.
-        glActiveTexture(GL_TEXTURE0);
+    void Flush()
+    {
+        if (commands.empty())
+            return;
+        GeometryArena &arena = GeometryArena::Instance();
+        DrawStatistics &statistics = FrameDrawStatistics();
+        if (commands.size() > 1 && arena.MultiDrawSupported())
+        {
+            arena.DrawIndirect(first->indexType, commands);
+            statistics.drawCalls++;
+        }
+        else
+        {
+            size_t indexSize = first->indexSize();
+            for (const GeometryArena::DrawCommand &command : commands)
+                glDrawElementsBaseVertex(GL_TRIANGLES, command.count, first->indexType,
+                                         (void*)(command.firstIndex * indexSize), command.baseVertex);
+            statistics.drawCalls += (unsigned int)commands.size();
+        }
+        commands.clear();
+        first = nullptr;
     }
 
 private:
-    // render data
-    unsigned int VBO, EBO;
+    vector<GeometryArena::DrawCommand> commands;
+    Mesh *first = nullptr;
+    GLuint program = 0;
 
-    // initializes all the buffer objects/arrays
-    void setupMesh()
+    // same program, vertex array and index type, and the same textures on the same samplers
+    bool fits(Mesh &mesh, Shader &shader) const
     {
-        // create buffers/arrays
-        glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &VBO);
-        glGenBuffers(1, &EBO);
-
-        glBindVertexArray(VAO);
-        // load data into vertex buffers
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        // A great thing about structs is that their memory layout is sequential for all its items.
-        // The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
-        // again translates to 3/2 floats which translates to a byte array.
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
-
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
-
-        // set the vertex attribute pointers
-        // vertex Positions
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-        // vertex normals
-        glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
-        // vertex texture coords
-        glEnableVertexAttribArray(2);
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
-        // vertex tangent
-        glEnableVertexAttribArray(3);
-        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Tangent));
-        // vertex bitangent
-        glEnableVertexAttribArray(4);
-        glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
-
-        glBindVertexArray(0);
+        if (shader.ID != program || mesh.vertexFormat != first->vertexFormat || mesh.indexType != first->indexType)
+            return false;
+        const MaterialBinding &a = first->Material(shader);
+        const MaterialBinding &b = mesh.Material(shader);
+        if (a.slotCount != b.slotCount)
+            return false;
+        for (unsigned int i = 0; i < a.slotCount; i++)
+        {
+            if (a.slots[i].location != b.slots[i].location || a.slots[i].texture != b.slots[i].texture)
+                return false;
+        }
+        return true;
     }
 };
 #endif
\ No newline at end of file
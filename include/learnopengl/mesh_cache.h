@@ -0,0 +1,263 @@
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include <learnopengl/asset_pack.h>
+#include <learnopengl/filesystem.h>
+#include <learnopengl/mesh.h>
+
+#include <sys/stat.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Versioned binary cache for imported models. After the first Assimp import the meshes are written to
+// <model path>.meshcache; later runs map that file and build the meshes straight from it.
+// A cache file is only used when the source path, size, mtime, the importer and the post-process flags it was
+// created with all match, otherwise the model is imported again and the cache rewritten.
+//
+// layout (all values little endian, every block 4-byte aligned):
+//   FileHeader, source path
+//   for each mesh: MeshHeader, vertices, indices, for each lod: index count, error, indices,
+//                  for each texture: type length, path length, type, path
+namespace MeshCache
+{
+    const uint32_t MAGIC = 0x48534D45; // "EMSH"
+    // bump whenever Vertex or the layout below changes
+    const uint32_t VERSION = 4;
+
+    struct FileHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t postProcessFlags;
+        uint32_t meshCount;
+        uint64_t sourceSize;
+        int64_t  sourceMtime;
+        uint32_t vertexSize;
+        uint32_t pathLength;
+        // importers produce equivalent but not identical meshes (vertex sharing), so each has its own cache
+        uint32_t importer;
+        uint32_t reserved;
+    };
+
+    struct MeshHeader {
+        uint32_t vertexCount;
+        uint32_t indexCount;
+        uint32_t textureCount;
+        uint32_t lodCount;
+        float    boundsMin[3];
+        float    boundsMax[3];
+    };
+
+    inline std::string CachePath(const std::string &sourcePath)
+    {
+        return sourcePath + ".meshcache";
+    }
+
+    // size and mtime of the source, packed sources report those of the file that was packed
+    inline bool sourceStat(const std::string &sourcePath, uint64_t &size, int64_t &mtime)
+    {
+        return FileSystem::stat(sourcePath, size, mtime);
+    }
+
+    inline size_t align4(size_t n)
+    {
+        return (n + 3) & ~(size_t)3;
+    }
+
+    // bounds-checked reader over the mapped file
+    struct Reader {
+        const unsigned char *data;
+        size_t size;
+        size_t offset;
+
+        // true if count elements of elementSize bytes are left to read. Counts come from the file, check them
+        // before sizing anything after them, so a corrupt cache is a miss instead of a huge allocation
+        bool Fits(uint64_t count, size_t elementSize) const
+        {
+            return count <= (size - offset) / elementSize;
+        }
+
+        bool Read(void *out, size_t n)
+        {
+            if (n > size - offset)
+                return false;
+            memcpy(out, data + offset, n);
+            offset += n;
+            return true;
+        }
+
+        bool ReadString(std::string &out, size_t n)
+        {
+            if (n > size - offset)
+                return false;
+            out.assign((const char*)data + offset, n);
+            offset = align4(offset + n);
+            return true;
+        }
+    };
+
+    // fills meshes from the cache of sourcePath, returns false (leaving meshes empty) on a miss or a stale cache
+    inline bool Load(const std::string &sourcePath, uint32_t postProcessFlags, uint32_t importer, std::vector<MeshData> &meshes)
+    {
+        uint64_t sourceSize;
+        int64_t sourceMtime;
+        if (!sourceStat(sourcePath, sourceSize, sourceMtime))
+            return false;
+
+        AssetFile file;
+        if (!file.Open(CachePath(sourcePath)))
+            return false;
+
+        Reader reader{file.Data(), file.Size(), 0};
+        FileHeader header;
+        if (!reader.Read(&header, sizeof(header)))
+            return false;
+        if (header.magic != MAGIC || header.version != VERSION || header.vertexSize != sizeof(Vertex)
+            || header.postProcessFlags != postProcessFlags || header.importer != importer
+            || header.sourceSize != sourceSize || header.sourceMtime != sourceMtime)
+            return false;
+        std::string cachedPath;
+        if (!reader.ReadString(cachedPath, header.pathLength) || cachedPath != sourcePath)
+            return false;
+
+        if (!reader.Fits(header.meshCount, sizeof(MeshHeader)))
+            return false;
+        std::vector<MeshData> result(header.meshCount);
+        for (MeshData &mesh : result)
+        {
+            MeshHeader meshHeader;
+            if (!reader.Read(&meshHeader, sizeof(meshHeader)))
+                return false;
+            mesh.boundsMin = glm::vec3(meshHeader.boundsMin[0], meshHeader.boundsMin[1], meshHeader.boundsMin[2]);
+            mesh.boundsMax = glm::vec3(meshHeader.boundsMax[0], meshHeader.boundsMax[1], meshHeader.boundsMax[2]);
+
+            if (!reader.Fits(meshHeader.vertexCount, sizeof(Vertex)))
+                return false;
+            mesh.vertices.resize(meshHeader.vertexCount);
+            if (!reader.Read(mesh.vertices.data(), meshHeader.vertexCount * sizeof(Vertex)) ||
+                !reader.Fits(meshHeader.indexCount, sizeof(unsigned int)))
+                return false;
+            mesh.indices.resize(meshHeader.indexCount);
+            if (!reader.Read(mesh.indices.data(), meshHeader.indexCount * sizeof(unsigned int)))
+                return false;
+
+            // every level starts with its index count and error
+            if (!reader.Fits(meshHeader.lodCount, sizeof(uint32_t) + sizeof(float)))
+                return false;
+            mesh.lods.resize(meshHeader.lodCount);
+            for (MeshLod &lod : mesh.lods)
+            {
+                uint32_t indexCount;
+                if (!reader.Read(&indexCount, sizeof(indexCount)) || !reader.Read(&lod.error, sizeof(lod.error)))
+                    return false;
+                if (!reader.Fits(indexCount, sizeof(unsigned int)))
+                    return false;
+                lod.indices.resize(indexCount);
+                if (!reader.Read(lod.indices.data(), indexCount * sizeof(unsigned int)))
+                    return false;
+            }
+
+            // every texture starts with the lengths of its type and path
+            if (!reader.Fits(meshHeader.textureCount, 2 * sizeof(uint32_t)))
+                return false;
+            mesh.textures.resize(meshHeader.textureCount);
+            for (Texture &texture : mesh.textures)
+            {
+                uint32_t lengths[2];
+                if (!reader.Read(lengths, sizeof(lengths)) ||
+                    !reader.ReadString(texture.type, lengths[0]) ||
+                    !reader.ReadString(texture.path, lengths[1]))
+                    return false;
+                texture.id = 0;
+            }
+        }
+
+        meshes.swap(result);
+        return true;
+    }
+
+    inline void writePadded(std::ofstream &out, const std::string &s)
+    {
+        static const char zeros[4] = {0, 0, 0, 0};
+        out.write(s.data(), s.size());
+        out.write(zeros, align4(s.size()) - s.size());
+    }
+
+    // writes the cache for sourcePath. The file is written under a temporary name first and then renamed,
+    // so a crash mid-write never leaves a truncated cache behind. Safe to call from worker threads.
+    inline bool Store(const std::string &sourcePath, uint32_t postProcessFlags, uint32_t importer, const std::vector<MeshData> &meshes)
+    {
+        FileHeader header;
+        header.magic = MAGIC;
+        header.version = VERSION;
+        header.postProcessFlags = postProcessFlags;
+        header.meshCount = (uint32_t)meshes.size();
+        header.vertexSize = sizeof(Vertex);
+        header.pathLength = (uint32_t)sourcePath.size();
+        header.importer = importer;
+        header.reserved = 0;
+        if (!sourceStat(sourcePath, header.sourceSize, header.sourceMtime))
+            return false;
+
+        std::string cachePath = CachePath(sourcePath);
+        // models can be imported on several threads at once, keep their temporary files apart
+        std::ostringstream tmpName;
+        tmpName << cachePath << ".tmp" << std::this_thread::get_id();
+        std::string tmpPath = tmpName.str();
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!out)
+        {
+            std::cout << "WARNING::MESH_CACHE:: can't write " << tmpPath << std::endl;
+            return false;
+        }
+
+        out.write((const char*)&header, sizeof(header));
+        writePadded(out, sourcePath);
+        for (const MeshData &mesh : meshes)
+        {
+            MeshHeader meshHeader;
+            meshHeader.vertexCount = (uint32_t)mesh.vertices.size();
+            meshHeader.indexCount = (uint32_t)mesh.indices.size();
+            meshHeader.textureCount = (uint32_t)mesh.textures.size();
+            meshHeader.lodCount = (uint32_t)mesh.lods.size();
+            for (int i = 0; i < 3; i++)
+            {
+                meshHeader.boundsMin[i] = mesh.boundsMin[i];
+                meshHeader.boundsMax[i] = mesh.boundsMax[i];
+            }
+            out.write((const char*)&meshHeader, sizeof(meshHeader));
+            out.write((const char*)mesh.vertices.data(), mesh.vertices.size() * sizeof(Vertex));
+            out.write((const char*)mesh.indices.data(), mesh.indices.size() * sizeof(unsigned int));
+            for (const MeshLod &lod : mesh.lods)
+            {
+                uint32_t indexCount = (uint32_t)lod.indices.size();
+                out.write((const char*)&indexCount, sizeof(indexCount));
+                out.write((const char*)&lod.error, sizeof(lod.error));
+                out.write((const char*)lod.indices.data(), lod.indices.size() * sizeof(unsigned int));
+            }
+            for (const Texture &texture : mesh.textures)
+            {
+                uint32_t lengths[2] = {(uint32_t)texture.type.size(), (uint32_t)texture.path.size()};
+                out.write((const char*)lengths, sizeof(lengths));
+                writePadded(out, texture.type);
+                writePadded(out, texture.path);
+            }
+        }
+        out.close();
+        if (!out || std::rename(tmpPath.c_str(), cachePath.c_str()) != 0)
+        {
+            std::remove(tmpPath.c_str());
+            std::cout << "WARNING::MESH_CACHE:: failed to write " << cachePath << std::endl;
+            return false;
+        }
+        return true;
+    }
+}
+#endif
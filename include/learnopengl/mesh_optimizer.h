@@ -0,0 +1,339 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/mesh.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+// Load time optimization of imported meshes, run before they are written to the mesh cache:
+//   1. Weld merges bit identical vertices (the Assimp path emits one vertex per face corner)
+//   2. OptimizeVertexCache orders the triangles for the post-transform cache with Tipsify
+//      (Sander, Nehab, Barczak: "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw", 2007)
+//   3. OptimizeOverdraw reorders clusters of those triangles so outward facing ones are drawn first,
+//      as long as the cache efficiency stays within a threshold
+//   4. OptimizeVertexFetch numbers the vertices in order of first use, so they're fetched front to back
+namespace MeshOptimizer
+{
+    // size of the simulated FIFO post-transform cache
+    const unsigned int CACHE_SIZE = 16;
+
+    struct CacheStats
+    {
+        // average cache miss ratio (transformed vertices per triangle, 0.5 is ideal for large grids, 3 is the worst)
+        float acmr = 0.0f;
+        // average transform to vertex ratio (transformed vertices per vertex, 1 is ideal)
+        float atvr = 0.0f;
+    };
+
+    // simulates a FIFO cache of cacheSize vertices over the index buffer
+    inline CacheStats AnalyzeVertexCache(const std::vector<unsigned int> &indices, size_t vertexCount, unsigned int cacheSize = CACHE_SIZE)
+    {
+        CacheStats stats;
+        if (indices.empty() || vertexCount == 0)
+            return stats;
+        // a vertex is in the cache if it was transformed less than cacheSize misses ago
+        std::vector<size_t> transformedAt(vertexCount, 0);
+        size_t misses = 0;
+        for (unsigned int index : indices)
+        {
+            if (transformedAt[index] == 0 || misses - transformedAt[index] >= cacheSize)
+                transformedAt[index] = ++misses;
+        }
+        stats.acmr = (float)misses / (indices.size() / 3);
+        stats.atvr = (float)misses / vertexCount;
+        return stats;
+    }
+
+    // merges vertices whose attributes are bit identical, returns the new vertex count
+    inline size_t Weld(MeshData &mesh)
+    {
+        struct VertexHash
+        {
+            size_t operator()(const Vertex &vertex) const
+            {
+                const unsigned char *bytes = (const unsigned char*)&vertex;
+                uint64_t hash = 14695981039346656037ULL;
+                for (size_t i = 0; i < sizeof(Vertex); i++)
+                {
+                    hash ^= bytes[i];
+                    hash *= 1099511628211ULL;
+                }
+                return (size_t)hash;
+            }
+        };
+        struct VertexEqual
+        {
+            bool operator()(const Vertex &a, const Vertex &b) const
+            {
+                return memcmp(&a, &b, sizeof(Vertex)) == 0;
+            }
+        };
+
+        std::unordered_map<Vertex, unsigned int, VertexHash, VertexEqual> unique;
+        unique.reserve(mesh.vertices.size());
+        std::vector<unsigned int> remap(mesh.vertices.size());
+        std::vector<Vertex> vertices;
+        vertices.reserve(mesh.vertices.size());
+        for (size_t i = 0; i < mesh.vertices.size(); i++)
+        {
+            auto inserted = unique.insert(std::make_pair(mesh.vertices[i], (unsigned int)vertices.size()));
+            if (inserted.second)
+                vertices.push_back(mesh.vertices[i]);
+            remap[i] = inserted.first->second;
+        }
+        for (unsigned int &index : mesh.indices)
+            index = remap[index];
+        mesh.vertices.swap(vertices);
+        return mesh.vertices.size();
+    }
+
+    // triangles of every vertex
+    struct Adjacency
+    {
+        std::vector<unsigned int> offsets;
+        std::vector<unsigned int> triangles;
+
+        Adjacency(const std::vector<unsigned int> &indices, size_t vertexCount) : offsets(vertexCount + 1, 0), triangles(indices.size())
+        {
+            for (unsigned int index : indices)
+                offsets[index + 1]++;
+            for (size_t i = 0; i < vertexCount; i++)
+                offsets[i + 1] += offsets[i];
+            std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+            for (size_t i = 0; i < indices.size(); i++)
+                triangles[fill[indices[i]]++] = (unsigned int)(i / 3);
+        }
+    };
+
+    // Tipsify: fans around a vertex, then continues with the adjacent vertex that will still be in the cache
+    // after its remaining triangles are emitted. Returns the new index buffer; clusterStarts receives the first
+    // triangle of every run that had to jump to a vertex outside the cache (hard boundaries for OptimizeOverdraw).
+    inline std::vector<unsigned int> OptimizeVertexCache(const std::vector<unsigned int> &indices, size_t vertexCount,
+                                                         std::vector<size_t> *clusterStarts = nullptr, unsigned int cacheSize = CACHE_SIZE)
+    {
+        size_t triangleCount = indices.size() / 3;
+        std::vector<unsigned int> result;
+        result.reserve(indices.size());
+        if (clusterStarts)
+            clusterStarts->clear();
+        if (triangleCount == 0)
+            return result;
+
+        Adjacency adjacency(indices, vertexCount);
+        // unemitted triangles per vertex
+        std::vector<unsigned int> live(vertexCount);
+        for (size_t i = 0; i < vertexCount; i++)
+            live[i] = adjacency.offsets[i + 1] - adjacency.offsets[i];
+        std::vector<size_t> cacheTime(vertexCount, 0);
+        std::vector<bool> emitted(triangleCount, false);
+        std::vector<unsigned int> deadEnd;
+        std::vector<unsigned int> candidates;
+        size_t time = cacheSize + 1;
+        size_t cursor = 0;
+
+        long long fan = indices[0];
+        bool jumped = true;
+        while (fan >= 0)
+        {
+            if (jumped && clusterStarts)
+                clusterStarts->push_back(result.size() / 3);
+            candidates.clear();
+            for (unsigned int i = adjacency.offsets[fan]; i < adjacency.offsets[fan + 1]; i++)
+            {
+                unsigned int triangle = adjacency.triangles[i];
+                if (emitted[triangle])
+                    continue;
+                for (int corner = 0; corner < 3; corner++)
+                {
+                    unsigned int vertex = indices[triangle * 3 + corner];
+                    result.push_back(vertex);
+                    deadEnd.push_back(vertex);
+                    candidates.push_back(vertex);
+                    live[vertex]--;
+                    if (time - cacheTime[vertex] > cacheSize)
+                        cacheTime[vertex] = time++;
+                }
+                emitted[triangle] = true;
+            }
+
+            // the candidate that stays longest in the cache once its remaining triangles are emitted
+            long long next = -1;
+            size_t bestPriority = 0;
+            for (unsigned int vertex : candidates)
+            {
+                if (live[vertex] == 0)
+                    continue;
+                size_t priority = 0;
+                if (time - cacheTime[vertex] + 2 * live[vertex] <= cacheSize)
+                    priority = time - cacheTime[vertex];
+                if (next < 0 || priority > bestPriority)
+                {
+                    next = vertex;
+                    bestPriority = priority;
+                }
+            }
+            jumped = false;
+            if (next < 0)
+            {
+                // dead end: the most recently used vertex with triangles left, or else the next one in input order
+                jumped = true;
+                while (!deadEnd.empty() && next < 0)
+                {
+                    unsigned int vertex = deadEnd.back();
+                    deadEnd.pop_back();
+                    if (live[vertex] > 0)
+                        next = vertex;
+                }
+                while (next < 0 && cursor < vertexCount)
+                {
+                    if (live[cursor] > 0)
+                        next = (long long)cursor;
+                    cursor++;
+                }
+            }
+            fan = next;
+        }
+        return result;
+    }
+
+    // Splits the cache optimized triangles into clusters and sorts them so the ones facing away from the mesh
+    // center (likely occluders) are drawn first. Clusters start at the hard boundaries of OptimizeVertexCache and
+    // are split further wherever a cold cache costs at most threshold times the mesh's ACMR.
+    inline void OptimizeOverdraw(std::vector<unsigned int> &indices, const std::vector<Vertex> &vertices,
+                                 const std::vector<size_t> &hardBoundaries, float threshold = 1.05f, unsigned int cacheSize = CACHE_SIZE)
+    {
+        size_t triangleCount = indices.size() / 3;
+        if (triangleCount < 2 || hardBoundaries.empty())
+            return;
+        float acmr = AnalyzeVertexCache(indices, vertices.size(), cacheSize).acmr;
+
+        // soft boundaries: inside each hard cluster, simulate a cache that starts cold and cut wherever the
+        // cluster so far is as efficient as the whole mesh
+        std::vector<size_t> starts;
+        std::vector<size_t> transformedAt(vertices.size(), 0);
+        size_t misses = 0;
+        for (size_t c = 0; c < hardBoundaries.size(); c++)
+        {
+            size_t end = c + 1 < hardBoundaries.size() ? hardBoundaries[c + 1] : triangleCount;
+            size_t start = hardBoundaries[c];
+            size_t clusterStart = start, clusterMisses = 0;
+            starts.push_back(start);
+            misses += cacheSize + 1;  // flush
+            for (size_t t = start; t < end; t++)
+            {
+                for (int corner = 0; corner < 3; corner++)
+                {
+                    unsigned int index = indices[t * 3 + corner];
+                    if (transformedAt[index] == 0 || misses - transformedAt[index] >= cacheSize)
+                    {
+                        transformedAt[index] = ++misses;
+                        clusterMisses++;
+                    }
+                }
+                size_t clusterTriangles = t + 1 - clusterStart;
+                if (t + 1 < end && clusterTriangles >= 8 && (float)clusterMisses / clusterTriangles <= threshold * acmr)
+                {
+                    clusterStart = t + 1;
+                    clusterMisses = 0;
+                    starts.push_back(clusterStart);
+                    misses += cacheSize + 1;
+                }
+            }
+        }
+
+        // sort key: how much the cluster faces away from the mesh center
+        glm::vec3 meshCenter(0.0f);
+        for (const Vertex &vertex : vertices)
+            meshCenter += vertex.Position;
+        meshCenter /= (float)vertices.size();
+        struct Cluster
+        {
+            size_t start, end;
+            float key;
+        };
+        std::vector<Cluster> clusters;
+        for (size_t c = 0; c < starts.size(); c++)
+        {
+            Cluster cluster;
+            cluster.start = starts[c];
+            cluster.end = c + 1 < starts.size() ? starts[c + 1] : triangleCount;
+            glm::vec3 center(0.0f), normal(0.0f);
+            float area = 0.0f;
+            for (size_t t = cluster.start; t < cluster.end; t++)
+            {
+                const glm::vec3 &a = vertices[indices[t * 3]].Position;
+                const glm::vec3 &b = vertices[indices[t * 3 + 1]].Position;
+                const glm::vec3 &d = vertices[indices[t * 3 + 2]].Position;
+                glm::vec3 areaNormal = glm::cross(b - a, d - a);
+                float triangleArea = glm::length(areaNormal);
+                center += (a + b + d) * (triangleArea / 3.0f);
+                normal += areaNormal;
+                area += triangleArea;
+            }
+            float normalLength = glm::length(normal);
+            cluster.key = area > 0.0f && normalLength > 0.0f ? glm::dot(center / area - meshCenter, normal / normalLength) : 0.0f;
+            clusters.push_back(cluster);
+        }
+        std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster &a, const Cluster &b) { return a.key > b.key; });
+
+        std::vector<unsigned int> result;
+        result.reserve(indices.size());
+        for (const Cluster &cluster : clusters)
+            result.insert(result.end(), indices.begin() + cluster.start * 3, indices.begin() + cluster.end * 3);
+        // the cold cache at every cluster start may cost more than allowed, keep the cache order then
+        if (AnalyzeVertexCache(result, vertices.size(), cacheSize).acmr <= threshold * acmr)
+            indices.swap(result);
+    }
+
+    // renumbers the vertices in order of first use and drops unused ones
+    inline void OptimizeVertexFetch(MeshData &mesh)
+    {
+        const unsigned int UNUSED = 0xFFFFFFFFu;
+        std::vector<unsigned int> remap(mesh.vertices.size(), UNUSED);
+        std::vector<Vertex> vertices;
+        vertices.reserve(mesh.vertices.size());
+        for (unsigned int &index : mesh.indices)
+        {
+            if (remap[index] == UNUSED)
+            {
+                remap[index] = (unsigned int)vertices.size();
+                vertices.push_back(mesh.vertices[index]);
+            }
+            index = remap[index];
+        }
+        mesh.vertices.swap(vertices);
+    }
+
+    struct Report
+    {
+        CacheStats before, after;
+        size_t verticesBefore = 0, verticesAfter = 0;
+        size_t triangles = 0;
+    };
+
+    // runs every stage on mesh, returns the cache efficiency before and after
+    inline Report Optimize(MeshData &mesh)
+    {
+        Report report;
+        report.before = AnalyzeVertexCache(mesh.indices, mesh.vertices.size());
+        report.verticesBefore = mesh.vertices.size();
+        report.triangles = mesh.indices.size() / 3;
+
+        Weld(mesh);
+        std::vector<size_t> clusters;
+        mesh.indices = OptimizeVertexCache(mesh.indices, mesh.vertices.size(), &clusters);
+        OptimizeOverdraw(mesh.indices, mesh.vertices, clusters);
+        OptimizeVertexFetch(mesh);
+
+        report.after = AnalyzeVertexCache(mesh.indices, mesh.vertices.size());
+        report.verticesAfter = mesh.vertices.size();
+        return report;
+    }
+}
+#endif
@@ -0,0 +1,314 @@
+#ifndef MESH_SIMPLIFIER_H
+#define MESH_SIMPLIFIER_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/mesh.h>
+#include <learnopengl/mesh_optimizer.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+// Level of detail generation by edge collapse with quadric error metrics
+// (Garland, Heckbert: "Surface Simplification Using Quadric Error Metrics", 1997).
+// Vertices only ever collapse onto other existing vertices, so every level of detail is just another index buffer
+// over the vertices of the original mesh. Vertices on a seam (one position with several vertices, e.g. a uv seam or a
+// hard edge) stay where they are, vertices on an open border only move along it.
+namespace MeshSimplifier
+{
+    // levels are generated down to this many triangles
+    const size_t MIN_TRIANGLES = 64;
+    const size_t MAX_LODS = 6;
+
+    // sum of squared distances to a set of planes, weighted by triangle area
+    struct Quadric
+    {
+        double a2 = 0, ab = 0, ac = 0, ad = 0, b2 = 0, bc = 0, bd = 0, c2 = 0, cd = 0, d2 = 0;
+        double weight = 0;
+
+        void AddPlane(const glm::vec3 &normal, float d, double w)
+        {
+            double a = normal.x, b = normal.y, c = normal.z;
+            a2 += w * a * a; ab += w * a * b; ac += w * a * c; ad += w * a * d;
+            b2 += w * b * b; bc += w * b * c; bd += w * b * d;
+            c2 += w * c * c; cd += w * c * d;
+            d2 += w * d * d;
+            weight += w;
+        }
+
+        void Add(const Quadric &q)
+        {
+            a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad; b2 += q.b2; bc += q.bc; bd += q.bd; c2 += q.c2; cd += q.cd; d2 += q.d2;
+            weight += q.weight;
+        }
+
+        // weighted mean squared distance of p to the planes
+        double Error(const glm::vec3 &p) const
+        {
+            double x = p.x, y = p.y, z = p.z;
+            double sum = a2 * x * x + b2 * y * y + c2 * z * z + 2 * (ab * x * y + ac * x * z + bc * y * z)
+                       + 2 * (ad * x + bd * y + cd * z) + d2;
+            return weight > 0 ? std::max(0.0, sum / weight) : 0.0;
+        }
+    };
+
+    inline uint64_t edgeKey(unsigned int a, unsigned int b)
+    {
+        return a < b ? ((uint64_t)a << 32) | b : ((uint64_t)b << 32) | a;
+    }
+
+    // Simplifies the triangles in indices step by step towards each of the decreasing targetIndexCounts, collapsing
+    // no edge that moves the surface by more than maxError. Returns one level per target that could be reached
+    // (plus the last, smaller result if one couldn't); the error of a level is its largest collapse error, an
+    // estimate of the object space distance between it and the original.
+    inline std::vector<MeshLod> Simplify(const std::vector<Vertex> &vertices, const std::vector<unsigned int> &indices,
+                                         const std::vector<size_t> &targetIndexCounts, float maxError)
+    {
+        size_t vertexCount = vertices.size();
+        // one group per distinct position, the groups carry the topology
+        std::vector<unsigned int> group(vertexCount);
+        {
+            std::unordered_map<uint64_t, std::vector<unsigned int>> byHash;
+            for (unsigned int i = 0; i < vertexCount; i++)
+            {
+                const glm::vec3 &p = vertices[i].Position;
+                uint32_t bits[3];
+                memcpy(bits, &p, sizeof(bits));
+                uint64_t hash = ((uint64_t)bits[0] * 73856093u) ^ ((uint64_t)bits[1] * 19349663u) ^ ((uint64_t)bits[2] * 83492791u);
+                std::vector<unsigned int> &bucket = byHash[hash];
+                group[i] = i;
+                for (unsigned int other : bucket)
+                {
+                    if (vertices[other].Position == p)
+                    {
+                        group[i] = other;
+                        break;
+                    }
+                }
+                if (group[i] == i)
+                    bucket.push_back(i);
+            }
+        }
+
+        // vertices of positions that are used by more than one vertex can't move
+        std::vector<unsigned int> wedge(vertexCount, 0xFFFFFFFFu);
+        std::vector<bool> locked(vertexCount, false);
+        for (unsigned int index : indices)
+        {
+            unsigned int g = group[index];
+            if (wedge[g] == 0xFFFFFFFFu)
+                wedge[g] = index;
+            else if (wedge[g] != index)
+                locked[g] = true;
+        }
+
+        std::vector<Quadric> quadrics(vertexCount);
+        for (size_t i = 0; i + 2 < indices.size(); i += 3)
+        {
+            const glm::vec3 &p0 = vertices[indices[i]].Position;
+            glm::vec3 normal = glm::cross(vertices[indices[i + 1]].Position - p0, vertices[indices[i + 2]].Position - p0);
+            float length = glm::length(normal);
+            if (length == 0.0f)
+                continue;
+            normal /= length;
+            float d = -glm::dot(normal, p0);
+            for (int k = 0; k < 3; k++)
+                quadrics[group[indices[i + k]]].AddPlane(normal, d, length * 0.5);
+        }
+
+        std::vector<unsigned int> result(indices);
+        std::unordered_map<uint64_t, unsigned int> edgeUses;
+        std::vector<bool> border(vertexCount, false);
+        std::vector<bool> touched(vertexCount, false);
+        // candidate collapses of the current pass
+        struct Collapse
+        {
+            unsigned int from, to, toVertex;
+            double cost;
+        };
+        std::vector<Collapse> collapses;
+        std::vector<unsigned int> remap(vertexCount);
+        double largest = 0.0;
+        double maxCost = (double)maxError * maxError;
+        bool bordersAdded = false;
+
+        std::vector<MeshLod> lods;
+        size_t next = 0;
+        while (next < targetIndexCounts.size())
+        {
+            if (result.size() <= targetIndexCounts[next])
+            {
+                lods.push_back(MeshLod{result, (float)std::sqrt(largest)});
+                while (next < targetIndexCounts.size() && result.size() <= targetIndexCounts[next])
+                    next++;
+                continue;
+            }
+            size_t targetIndexCount = targetIndexCounts[next];
+
+            // edges used by one triangle only are on an open border
+            edgeUses.clear();
+            for (size_t i = 0; i < result.size(); i += 3)
+            {
+                for (int k = 0; k < 3; k++)
+                    edgeUses[edgeKey(group[result[i + k]], group[result[i + (k + 1) % 3]])]++;
+            }
+            std::fill(border.begin(), border.end(), false);
+            for (size_t i = 0; i < result.size(); i += 3)
+            {
+                for (int k = 0; k < 3; k++)
+                {
+                    unsigned int a = group[result[i + k]], b = group[result[i + (k + 1) % 3]];
+                    if (edgeUses[edgeKey(a, b)] != 1)
+                        continue;
+                    border[a] = border[b] = true;
+                    // the original borders get planes perpendicular to their triangles, so they keep their shape
+                    if (bordersAdded)
+                        continue;
+                    const glm::vec3 &pa = vertices[a].Position, &pb = vertices[b].Position;
+                    const glm::vec3 &pc = vertices[group[result[i + (k + 2) % 3]]].Position;
+                    glm::vec3 edge = pb - pa;
+                    glm::vec3 normal = glm::cross(glm::cross(edge, pc - pa), edge);
+                    float length = glm::length(normal);
+                    if (length == 0.0f)
+                        continue;
+                    normal /= length;
+                    double w = glm::dot(edge, edge) * 10.0;
+                    quadrics[a].AddPlane(normal, -glm::dot(normal, pa), w);
+                    quadrics[b].AddPlane(normal, -glm::dot(normal, pa), w);
+                }
+            }
+            bordersAdded = true;
+
+            collapses.clear();
+            for (size_t i = 0; i < result.size(); i += 3)
+            {
+                for (int k = 0; k < 3; k++)
+                {
+                    unsigned int va = result[i + k], vb = result[i + (k + 1) % 3];
+                    unsigned int a = group[va], b = group[vb];
+                    for (int direction = 0; direction < 2; direction++)
+                    {
+                        std::swap(a, b);
+                        std::swap(va, vb);
+                        // a moves onto b: seams don't move, borders only along themselves
+                        if (locked[a] || (border[a] && (!border[b] || edgeUses[edgeKey(a, b)] != 1)))
+                            continue;
+                        Quadric q = quadrics[a];
+                        q.Add(quadrics[b]);
+                        double cost = q.Error(vertices[b].Position);
+                        if (cost <= maxCost)
+                            collapses.push_back(Collapse{a, b, vb, cost});
+                    }
+                }
+            }
+            if (collapses.empty())
+                break;
+            std::sort(collapses.begin(), collapses.end(), [](const Collapse &x, const Collapse &y) { return x.cost < y.cost; });
+
+            MeshOptimizer::Adjacency adjacency(result, vertexCount);
+            // triangles by group: only a group's own vertex (unlocked groups have one) is used by unlocked collapses
+            std::fill(touched.begin(), touched.end(), false);
+            for (unsigned int i = 0; i < vertexCount; i++)
+                remap[i] = i;
+            // every collapse removes about two triangles
+            size_t wanted = (result.size() - targetIndexCount) / 6 + 1;
+            size_t applied = 0;
+            for (const Collapse &collapse : collapses)
+            {
+                if (applied >= wanted)
+                    break;
+                if (touched[collapse.from] || touched[collapse.to])
+                    continue;
+                // the triangles around from must not flip or degenerate into slivers
+                unsigned int fromVertex = wedge[collapse.from];
+                const glm::vec3 &target = vertices[collapse.to].Position;
+                bool valid = true;
+                for (unsigned int t = adjacency.offsets[fromVertex]; t < adjacency.offsets[fromVertex + 1] && valid; t++)
+                {
+                    const unsigned int *triangle = &result[adjacency.triangles[t] * 3];
+                    glm::vec3 before[3], after[3];
+                    bool collapsing = false;
+                    for (int k = 0; k < 3; k++)
+                    {
+                        unsigned int g = group[triangle[k]];
+                        collapsing |= g == collapse.to;
+                        before[k] = vertices[g].Position;
+                        after[k] = g == collapse.from ? target : before[k];
+                        valid &= !touched[g] || g == collapse.from;
+                    }
+                    if (collapsing)
+                        continue;
+                    glm::vec3 n0 = glm::cross(before[1] - before[0], before[2] - before[0]);
+                    glm::vec3 n1 = glm::cross(after[1] - after[0], after[2] - after[0]);
+                    valid &= glm::dot(n0, n1) > 0.25f * glm::length(n0) * glm::length(n1);
+                }
+                if (!valid)
+                    continue;
+
+                for (unsigned int t = adjacency.offsets[fromVertex]; t < adjacency.offsets[fromVertex + 1]; t++)
+                {
+                    const unsigned int *triangle = &result[adjacency.triangles[t] * 3];
+                    for (int k = 0; k < 3; k++)
+                        touched[group[triangle[k]]] = true;
+                }
+                touched[collapse.to] = true;
+                remap[fromVertex] = collapse.toVertex;
+                quadrics[collapse.to].Add(quadrics[collapse.from]);
+                largest = std::max(largest, collapse.cost);
+                applied++;
+            }
+            if (applied == 0)
+                break;
+
+            // drop the triangles that lost an edge
+            size_t write = 0;
+            for (size_t i = 0; i < result.size(); i += 3)
+            {
+                unsigned int a = remap[result[i]], b = remap[result[i + 1]], c = remap[result[i + 2]];
+                if (group[a] == group[b] || group[b] == group[c] || group[a] == group[c])
+                    continue;
+                result[write++] = a;
+                result[write++] = b;
+                result[write++] = c;
+            }
+            result.resize(write);
+            for (unsigned int index : result)
+                wedge[group[index]] = index;
+        }
+
+        if (next < targetIndexCounts.size() && (lods.empty() || result.size() < lods.back().indices.size()))
+            lods.push_back(MeshLod{result, (float)std::sqrt(largest)});
+        return lods;
+    }
+
+    // builds mesh.lods: every level has about half the triangles of the previous one, down to MIN_TRIANGLES,
+    // and is ordered for the vertex cache. Stops early when the mesh can't be simplified any further.
+    inline void BuildLods(MeshData &mesh)
+    {
+        mesh.lods.clear();
+        glm::vec3 extent = mesh.boundsMax - mesh.boundsMin;
+        // no level may be off by more than a tenth of the mesh size
+        float maxError = std::max(extent.x, std::max(extent.y, extent.z)) * 0.1f;
+        std::vector<size_t> targets;
+        for (size_t target = mesh.indices.size() / 6 * 3; target >= MIN_TRIANGLES * 3 && targets.size() < MAX_LODS; target = target / 6 * 3)
+            targets.push_back(target);
+        if (targets.empty())
+            return;
+
+        size_t indexCount = mesh.indices.size();
+        for (MeshLod &lod : Simplify(mesh.vertices, mesh.indices, targets, maxError))
+        {
+            // not worth another index buffer
+            if (lod.indices.empty() || lod.indices.size() > indexCount * 4 / 5)
+                break;
+            lod.indices = MeshOptimizer::OptimizeVertexCache(lod.indices, mesh.vertices.size());
+            indexCount = lod.indices.size();
+            mesh.lods.push_back(std::move(lod));
+        }
+    }
+}
+#endif
@@ -10,69 +10,424 @@
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
+#include <learnopengl/asset_io_system.h>
+#include <learnopengl/asset_loader.h>
 #include <learnopengl/mesh.h>
+#include <learnopengl/mesh_cache.h>
+#include <learnopengl/mesh_optimizer.h>
+#include <learnopengl/mesh_simplifier.h>
+#include <learnopengl/obj_loader.h>
 #include <learnopengl/shader.h>
+#include <learnopengl/texture_cache.h>
+#include <learnopengl/texture_registry.h>
+#include <learnopengl/vertex_format.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <map>
+#include <set>
+#include <memory>
 #include <unordered_map>
 #include <vector>
 using namespace std;
 
 unsigned int TextureFromFile(const char *path, const string &directory, bool gamma = false);
 
+// post-processing applied to every imported model. Part of the mesh cache key, so changing it invalidates all caches.
+// ObjLoader implements the same steps for .obj files.
+const unsigned int MODEL_POST_PROCESS_FLAGS = aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace;
+
+enum class MeshImporter { Assimp, Obj };
+
+// importer used for .obj files, every other format goes through Assimp
+inline MeshImporter& ObjImporter()
+{
+    static MeshImporter importer = MeshImporter::Obj;
+    return importer;
+}
+
+// screen space error, in pixels, up to which Model::Draw picks coarser levels of detail. 0 always draws full detail
+inline float& LodPixelError()
+{
+    static float pixelError = 1.0f;
+    return pixelError;
+}
+
+// Owns its meshes (and through them their GL buffers) and holds references to its textures in the TextureRegistry.
+// Move-only; a model may be moved or destroyed while it is still loading in the background.
 class Model
 {
 public:
+    // memory held by a model, textures are shared with other models using them
+    struct MemoryUsage
+    {
+        size_t cpuGeometry = 0;
+        size_t gpuGeometry = 0;
+        size_t textures = 0;
+    };
+
     // model data
-    unordered_map<string, Texture> loaded_textures_map;
     vector<Mesh>    meshes;
     string directory;
     bool gammaCorrection;
+    // load statistics
+    bool loadedFromCache = false;
+    double loadMilliseconds = 0.0;
 
     // constructor, expects a filepath to a 3D model.
-    Model(string const &path, bool gamma = false) : gammaCorrection(gamma)
+    Model(string const &path, bool gamma = false) : gammaCorrection(gamma), self(make_shared<Model*>(this))
     {
         loadModel(path);
     }
 
-    // draws the model, and thus all its meshes
+    // constructor that loads the model in the background. Parsing and texture decoding run on the loader's
+    // workers, the meshes and textures are uploaded by loader.ProcessUploads on the context thread.
+    // until then the model has no meshes and Draw renders nothing.
+    Model(string const &path, AssetLoader &loader, bool gamma = false) : gammaCorrection(gamma), self(make_shared<Model*>(this))
+    {
+        loadModelAsync(path, loader);
+    }
+
+    // textures are shared through the TextureRegistry, a model holds one reference per texture use
+    ~Model()
+    {
+        releaseTextures();
+    }
+
+    Model(const Model&) = delete;
+    Model& operator=(const Model&) = delete;
+
+    Model(Model &&other) noexcept
+    {
+        takeFrom(other);
+    }
+
+    Model& operator=(Model &&other) noexcept
+    {
+        if (this != &other)
+        {
+            releaseTextures();
+            takeFrom(other);
+        }
+        return *this;
+    }
+
+    // draws the model, and thus all its meshes. Meshes sharing material and format go out together (see MeshBatch)
     void Draw(Shader &shader)
     {
+        MeshBatch &batch = drawBatch();
         for(unsigned int i = 0; i < meshes.size(); i++)
-            meshes[i].Draw(shader);
+            batch.Add(meshes[i], shader);
+        batch.Flush();
+    }
+
+    // draws every mesh at the coarsest level of detail whose error, projected at the mesh's distance from the
+    // camera, stays below LodPixelError(). zoom is the vertical field of view in degrees
+    void Draw(Shader &shader, const glm::mat4 &model, const glm::vec3 &cameraPosition, float zoom, float viewportHeight)
+    {
+        MeshBatch &batch = drawBatch();
+        for (Mesh &mesh : meshes)
+            batch.Add(mesh, shader, SelectLod(mesh, model, cameraPosition, zoom, viewportHeight));
+        batch.Flush();
+    }
+
+    // draws every mesh once for all instances (see InstanceBuffer), with a shader reading the model matrix per
+    // instance such as models_instanced.vs. Every instance gets the same level of detail
+    void DrawInstanced(Shader &shader, const InstanceBuffer &instances, unsigned int lod = 0)
+    {
+        for (Mesh &mesh : meshes)
+            mesh.DrawInstanced(shader, instances, lod);
+    }
+
+    // the level of detail Draw picks for mesh, for callers drawing the meshes one by one (see RenderQueue)
+    static unsigned int SelectLod(const Mesh &mesh, const glm::mat4 &model, const glm::vec3 &cameraPosition, float zoom, float viewportHeight)
+    {
+        if (LodPixelError() <= 0.0f)
+            return 0;
+        float scale = std::max(glm::length(glm::vec3(model[0])), std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+        // pixels per world space unit at distance 1
+        float projection = viewportHeight / (2.0f * std::tan(glm::radians(zoom) * 0.5f));
+        glm::vec3 center = glm::vec3(model * glm::vec4((mesh.boundsMin + mesh.boundsMax) * 0.5f, 1.0f));
+        float radius = glm::length(mesh.boundsMax - mesh.boundsMin) * 0.5f * scale;
+        // the nearest point of the bounding sphere, not closer than the near plane
+        float distance = std::max(glm::length(center - cameraPosition) - radius, 0.1f);
+        return mesh.SelectLod(scale * projection / distance, LodPixelError());
     }
 
     void SetShaderTextureNamePrefix(std::string prefix) {
+        glslIdentifierPrefix = prefix;
         for (Mesh& mesh: meshes) {
-            mesh.glslIdentifierPrefix = prefix;
+            mesh.SetTextureNamePrefix(prefix);
         }
     }
-private:
-    // loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
-    void loadModel(string const &path)
+
+    // layout of the vertex buffers (see VertexFormat), applied to the meshes already there and the ones still loading.
+    // packed layouts print the size and precision of every mesh
+    void SetVertexFormat(VertexFormat format)
+    {
+        vertexFormat = format;
+        for (Mesh &mesh : meshes)
+            mesh.SetVertexFormat(format);
+        reportVertexFormat();
+    }
+
+    // frees the CPU copy of the vertices and indices of every mesh once it is uploaded (see Mesh::ReleaseGeometry).
+    // set the vertex format first, it can't be changed afterwards
+    void SetReleaseGeometry(bool release)
+    {
+        releaseGeometry = release;
+        if (release)
+        {
+            for (Mesh &mesh : meshes)
+                mesh.ReleaseGeometry();
+        }
+    }
+
+    MemoryUsage GetMemoryUsage() const
+    {
+        MemoryUsage usage;
+        for (const Mesh &mesh : meshes)
+        {
+            usage.cpuGeometry += mesh.CpuBytes();
+            usage.gpuGeometry += mesh.GpuBytes();
+        }
+        // each texture once, however many meshes use it
+        set<TextureKey> textures(textureKeys.begin(), textureKeys.end());
+        for (const TextureKey &key : textures)
+            usage.textures += TextureRegistry::Instance().Bytes(key);
+        return usage;
+    }
+
+    bool IsLoaded() const
     {
-        // read file via ASSIMP
-        Assimp::Importer importer;
-        const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+        return loaded;
+    }
+
+    // reads the meshes of the model at path with the given importer, bypassing the mesh cache.
+    // doesn't touch GL, so it is safe to run on a worker thread
+    static bool ImportMeshes(string const &path, vector<MeshData> &meshData, MeshImporter importer)
+    {
+        if (importer == MeshImporter::Obj)
+            return ObjLoader::Load(path, meshData);
+
+        // read file via ASSIMP, through the asset pack when it's mounted. the importer owns the io system
+        Assimp::Importer assimpImporter;
+        assimpImporter.SetIOHandler(new AssetIOSystem);
+        const aiScene* scene = assimpImporter.ReadFile(path, MODEL_POST_PROCESS_FLAGS);
         // check for errors
         if(!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) // if is Not Zero
         {
-            cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << endl;
-            return;
+            cout << "ERROR::ASSIMP:: " << assimpImporter.GetErrorString() << endl;
+            return false;
         }
+        // process ASSIMP's root node recursively
+        processNode(scene->mRootNode, scene, meshData);
+        return true;
+    }
+
+    // the importer ImportMeshes uses for the file at path
+    static MeshImporter ImporterFor(string const &path)
+    {
+        size_t dot = path.find_last_of('.');
+        string extension = dot == string::npos ? "" : path.substr(dot + 1);
+        for (char &c : extension)
+            c = (char)tolower(c);
+        return extension == "obj" ? ObjImporter() : MeshImporter::Assimp;
+    }
+private:
+    // shared by every model, Draw flushes it before returning
+    static MeshBatch& drawBatch()
+    {
+        static MeshBatch batch;
+        return batch;
+    }
+
+    // cpu side result of a (background) load, waiting to be uploaded
+    struct PendingModel
+    {
+        vector<MeshData> meshData;
+        // registry keys by material path, and the texture data of those the registry doesn't have yet
+        unordered_map<string, TextureKey> keys;
+        unordered_map<string, shared_ptr<TextureData>> images;
+        bool fromCache = false;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    std::string glslIdentifierPrefix;
+    VertexFormat vertexFormat = VertexFormat::Full;
+    bool releaseGeometry = false;
+    bool loaded = false;
+    // where the model lives now, for the callbacks of background loads that can outlive a move or the model.
+    // the pointee also identifies the model in the TextureRegistry
+    shared_ptr<Model*> self;
+    // streams the decoded textures of background loads
+    TextureUploader *textureUploader = nullptr;
+    // every texture acquired from the TextureRegistry, released again by the destructor
+    vector<TextureKey> textureKeys;
+
+    // loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
+    // the imported meshes are cached on disk, so later runs of the same file skip ASSIMP completely.
+    void loadModel(string const &path)
+    {
+        PendingModel pending;
+        pending.start = std::chrono::steady_clock::now();
         // retrieve the directory path of the filepath
         directory = path.substr(0, path.find_last_of('/'));
 
-        // process ASSIMP's root node recursively
-        processNode(scene->mRootNode, scene);
+        if (!importMeshes(path, pending.meshData, pending.fromCache))
+            return;
+        finishLoad(pending);
+    }
+
+    void loadModelAsync(string const &path, AssetLoader &loader)
+    {
+        directory = path.substr(0, path.find_last_of('/'));
+        textureUploader = &loader.Textures;
+        shared_ptr<PendingModel> pending = make_shared<PendingModel>();
+        pending->start = std::chrono::steady_clock::now();
+
+        // the job only touches the pending data, the model itself is updated by the upload on the context thread
+        string modelDirectory = directory;
+        shared_ptr<Model*> model = self;
+        loader.Submit([model, path, modelDirectory, pending, &loader]() {
+            if (!importMeshes(path, pending->meshData, pending->fromCache))
+                return;
+            for (const MeshData &data : pending->meshData)
+            {
+                for (const Texture &texture : data.textures)
+                {
+                    if (pending->keys.count(texture.path))
+                        continue;
+                    // textures already shared by another model and missing files need no loading
+                    TextureRegistry &registry = TextureRegistry::Instance();
+                    TextureKey key = registry.Identify(modelDirectory + '/' + texture.path);
+                    pending->keys[texture.path] = key;
+                    if (registry.Contains(key))
+                        continue;
+                    shared_ptr<TextureData> image = make_shared<TextureData>();
+                    TextureCache::Get(key.path, *image, TextureCache::Compression(), key.hash);
+                    pending->images[texture.path] = image;
+                }
+            }
+            loader.QueueUpload([model, pending]() {
+                // the model was destroyed in the meantime
+                if (*model)
+                    (*model)->finishLoad(*pending);
+            });
+        });
+    }
+
+    // reads the meshes of the model at path, from the mesh cache if it is up to date, otherwise through its importer.
+    // doesn't touch the model or GL, so it is safe to run on a worker thread
+    static bool importMeshes(string const &path, vector<MeshData> &meshData, bool &fromCache)
+    {
+        MeshImporter importer = ImporterFor(path);
+        fromCache = MeshCache::Load(path, MODEL_POST_PROCESS_FLAGS, (uint32_t)importer, meshData);
+        if (fromCache)
+            return true;
+
+        if (!ImportMeshes(path, meshData, importer))
+            return false;
+        optimizeMeshes(path, meshData);
+        buildLods(path, meshData);
+        MeshCache::Store(path, MODEL_POST_PROCESS_FLAGS, (uint32_t)importer, meshData);
+        return true;
+    }
+
+    // reorders every mesh for the vertex cache, overdraw and vertex fetch (see MeshOptimizer) and prints the
+    // cache efficiency before and after. Only runs on import, the mesh cache stores the optimized meshes.
+    static void optimizeMeshes(string const &path, vector<MeshData> &meshData)
+    {
+        MeshOptimizer::CacheStats before, after;
+        size_t triangles = 0, verticesBefore = 0, verticesAfter = 0;
+        for (MeshData &data : meshData)
+        {
+            MeshOptimizer::Report report = MeshOptimizer::Optimize(data);
+            // weighted by triangles for ACMR and by vertices for ATVR, so they add up to the model's values
+            before.acmr += report.before.acmr * report.triangles;
+            after.acmr += report.after.acmr * report.triangles;
+            before.atvr += report.before.atvr * report.verticesBefore;
+            after.atvr += report.after.atvr * report.verticesAfter;
+            triangles += report.triangles;
+            verticesBefore += report.verticesBefore;
+            verticesAfter += report.verticesAfter;
+        }
+        if (triangles == 0)
+            return;
+        std::ostringstream message;
+        message.precision(3);
+        message << "Optimized " << path << ": ACMR " << before.acmr / triangles << " -> " << after.acmr / triangles
+                << ", ATVR " << before.atvr / verticesBefore << " -> " << after.atvr / verticesAfter
+                << ", " << verticesBefore << " -> " << verticesAfter << " vertices" << endl;
+        cout << message.str();
+    }
+
+    // simplified levels of detail of every mesh (see MeshSimplifier), stored in the mesh cache with the meshes
+    static void buildLods(string const &path, vector<MeshData> &meshData)
+    {
+        std::ostringstream message;
+        message.precision(3);
+        for (size_t i = 0; i < meshData.size(); i++)
+        {
+            MeshData &data = meshData[i];
+            MeshSimplifier::BuildLods(data);
+            if (data.lods.empty())
+                continue;
+            message << "LODs of " << path << " mesh " << i << ": " << data.indices.size() / 3 << " triangles";
+            for (const MeshLod &lod : data.lods)
+                message << ", " << lod.indices.size() / 3 << " (error " << lod.error << ")";
+            message << endl;
+        }
+        cout << message.str();
+    }
+
+    // the cpu side data is complete, resolve the textures and upload everything. Needs the GL context.
+    void finishLoad(PendingModel &pending)
+    {
+        for (MeshData &data : pending.meshData)
+        {
+            for (Texture &texture : data.textures)
+                texture.id = loadTexture(texture.path, texture.type, pending);
+            meshes.push_back(Mesh(std::move(data), vertexFormat));
+            meshes.back().SetTextureNamePrefix(glslIdentifierPrefix);
+        }
+        pending.meshData.clear();
+        reportVertexFormat();
+        if (releaseGeometry)
+        {
+            for (Mesh &mesh : meshes)
+                mesh.ReleaseGeometry();
+        }
+        loadedFromCache = pending.fromCache;
+        loadMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - pending.start).count();
+        loaded = true;
+    }
+
+    void reportVertexFormat() const
+    {
+        if (vertexFormat == VertexFormat::Full)
+            return;
+        std::ostringstream message;
+        message.precision(3);
+        for (size_t i = 0; i < meshes.size(); i++)
+        {
+            const Mesh &mesh = meshes[i];
+            const VertexPacking::PackingError &error = mesh.packingError;
+            message << "Vertices of " << directory << " mesh " << i << " (" << VertexPacking::Name(vertexFormat) << "): "
+                    << mesh.VertexCount() * sizeof(Vertex) / 1024.0 << " KB -> " << mesh.VertexBytes() / 1024.0 << " KB"
+                    << ", max error position " << error.position << " (" << error.relativePosition * 100.0f << "% of size)"
+                    << ", normal " << error.normal << " deg, tangent " << error.tangent << " deg, uv " << error.texCoords << endl;
+        }
+        cout << message.str();
     }
 
     // processes a node in a recursive fashion. Processes each individual mesh located at the node and repeats this process on its children nodes (if any).
-    void processNode(aiNode *node, const aiScene *scene)
+    static void processNode(aiNode *node, const aiScene *scene, vector<MeshData> &meshData)
     {
         // process each mesh located at the current node
         for(unsigned int i = 0; i < node->mNumMeshes; i++)
@@ -80,22 +435,23 @@ private:
             // the node object only contains indices to index the actual objects in the scene.
             // the scene contains all the data, node is just to keep stuff organized (like relations between nodes).
             aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-            meshes.push_back(processMesh(mesh, scene));
+            meshData.push_back(processMesh(mesh, scene));
         }
         // after we've processed all of the meshes (if any) we then recursively process each of the children nodes
         for(unsigned int i = 0; i < node->mNumChildren; i++)
         {
-            processNode(node->mChildren[i], scene);
+            processNode(node->mChildren[i], scene, meshData);
         }
 
     }
 
-    Mesh processMesh(aiMesh *mesh, const aiScene *scene)
+    static MeshData processMesh(aiMesh *mesh, const aiScene *scene)
     {
         // data to fill
-        vector<Vertex> vertices;
-        vector<unsigned int> indices;
-        vector<Texture> textures;
+        MeshData data;
+        vector<Vertex> &vertices = data.vertices;
+        vector<unsigned int> &indices = data.indices;
+        vector<Texture> &textures = data.textures;
 
         // walk through each of the mesh's vertices
         for(unsigned int i = 0; i < mesh->mNumVertices; i++)
@@ -173,34 +529,89 @@ private:
 
 
 
-        // return a mesh object created from the extracted mesh data
-        return Mesh(vertices, indices, textures);
+        // return the extracted mesh data, it gets uploaded once the whole model is processed
+        data.ComputeBounds();
+        return data;
     }
 
-    // checks all material textures of a given type and loads the textures if they're not loaded yet.
-    // the required info is returned as a Texture struct.
-    void loadMaterialTextures(aiMaterial *mat, aiTextureType type, const string& typeName, vector<Texture> &textures)
+    // collects all material textures of a given type. Only type and path are recorded here,
+    // the textures themselves are loaded by loadTexture once the model is processed.
+    static void loadMaterialTextures(aiMaterial *mat, aiTextureType type, const string& typeName, vector<Texture> &textures)
     {
         for(unsigned int i = 0; i < mat->GetTextureCount(type); i++)
         {
             aiString str;
             mat->GetTexture(type, i, &str);
-            // check if texture was loaded before and if so, continue to next iteration: skip loading a new texture
-            bool skip = false;
-            auto it = loaded_textures_map.find(str.C_Str());
-            if(it != loaded_textures_map.end())
+            Texture texture;
+            texture.id = 0;
+            texture.type = typeName;
+            texture.path = str.C_Str();
+            textures.push_back(texture);
+        }
+    }
+
+    // acquires the texture from the TextureRegistry, which loads it if no other user has it yet, from the already
+    // decoded image when there is one. Decoded images are streamed in the background, the texture is a placeholder
+    // until swapTexture replaces it.
+    unsigned int loadTexture(const string &path, const string &typeName, PendingModel &pending)
+    {
+        TextureRegistry &registry = TextureRegistry::Instance();
+        auto key = pending.keys.find(path);
+        if (key == pending.keys.end())
+            key = pending.keys.insert(make_pair(path, registry.Identify(this->directory + '/' + path))).first;
+
+        shared_ptr<TextureData> image;
+        auto it = pending.images.find(path);
+        if (it != pending.images.end())
+            image = it->second;
+        textureKeys.push_back(key->second);
+        shared_ptr<Model*> model = self;
+        return registry.Acquire(key->second, typeName, image, textureUploader, self.get(),
+                                [model, path](unsigned int textureID) { (*model)->swapTexture(path, textureID); });
+    }
+
+    // gives back this model's reference to every texture it acquired and detaches the self anchor, so uploads
+    // still streaming no longer reach the model
+    void releaseTextures()
+    {
+        if (!self)
+            return;
+        for (const TextureKey &key : textureKeys)
+            TextureRegistry::Instance().Release(key, self.get());
+        textureKeys.clear();
+        *self = nullptr;
+        self.reset();
+    }
+
+    // moves every member of other into this model, other is left empty
+    void takeFrom(Model &other)
+    {
+        meshes = std::move(other.meshes);
+        directory = std::move(other.directory);
+        gammaCorrection = other.gammaCorrection;
+        loadedFromCache = other.loadedFromCache;
+        loadMilliseconds = other.loadMilliseconds;
+        glslIdentifierPrefix = std::move(other.glslIdentifierPrefix);
+        vertexFormat = other.vertexFormat;
+        releaseGeometry = other.releaseGeometry;
+        loaded = other.loaded;
+        textureUploader = other.textureUploader;
+        textureKeys = std::move(other.textureKeys);
+        other.textureKeys.clear();
+        self = std::move(other.self);
+        if (self)
+            *self = this;
+    }
+
+    // replaces the placeholder of a streamed texture once it is completely uploaded
+    void swapTexture(const string &path, unsigned int textureID)
+    {
+        for (Mesh &mesh : meshes)
+        {
+            for (size_t i = 0; i < mesh.textures.size(); i++)
             {
-                skip=true;
-                textures.push_back(it->second);
-            }
-            if(!skip)
-            {   // if texture hasn't been loaded already, load it
-                Texture texture;
-                texture.id = TextureFromFile(str.C_Str(), this->directory);
-                texture.type = typeName;
-                texture.path = str.C_Str();
-                textures.push_back(texture);
-                loaded_textures_map[str.C_Str()] = texture;
+                if (mesh.textures[i].path == path)
+                    mesh.SetTexture(i, textureID);
             }
         }
     }
@@ -212,38 +623,9 @@ unsigned int TextureFromFile(const char *path, const string &directory, bool gam
     string filename = string(path);
     filename = directory + '/' + filename;
 
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-
-    int width, height, nrComponents;
-    unsigned char *data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
-    if (data)
-    {
-        GLenum format;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
-    }
-    else
-    {
-        std::cout << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
-    }
-
-    return textureID;
+    // decoded and mipmapped once, later runs read every level straight from the texture cache
+    TextureData texture;
+    TextureCache::Get(filename, texture);
+    return TextureFromData(texture, path, gamma);
 }
 #endif
@@ -0,0 +1,929 @@
+#ifndef OBJ_LOADER_H
+#define OBJ_LOADER_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/asset_pack.h>
+#include <learnopengl/mesh.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Purpose-built Wavefront OBJ/MTL importer, a faster alternative to Assimp for the .obj models.
+// The file is mapped and split at line boundaries into one chunk per thread. The chunks are parsed in parallel into
+// block arenas and stitched together in file order, identical vertices are merged with a hash table partitioned over
+// the threads. The result matches an Assimp import with MODEL_POST_PROCESS_FLAGS: polygons are triangulated the way
+// aiProcess_Triangulate does it, there is one mesh per object/group and material, missing normals are smoothed per
+// position and tangents are computed before the V flip. Unlike the Assimp path, vertices are shared between faces.
+namespace ObjLoader
+{
+    const size_t ARENA_BLOCK_SIZE = 1 << 16;
+
+    // growable array made of fixed size blocks, storing more never moves what is already there,
+    // so a chunk of unknown size is parsed without reallocation copies
+    template <typename T>
+    class Arena
+    {
+    public:
+        void PushBack(const T &value)
+        {
+            if (count % ARENA_BLOCK_SIZE == 0 && count / ARENA_BLOCK_SIZE == blocks.size())
+                blocks.emplace_back(new T[ARENA_BLOCK_SIZE]);
+            blocks[count / ARENA_BLOCK_SIZE][count % ARENA_BLOCK_SIZE] = value;
+            count++;
+        }
+
+        void PopBack(size_t n)
+        {
+            count -= std::min(n, count);
+        }
+
+        size_t Size() const
+        {
+            return count;
+        }
+
+        // copies everything to out, which has room for Size() elements
+        void CopyTo(T *out) const
+        {
+            for (size_t i = 0; i * ARENA_BLOCK_SIZE < count; i++)
+            {
+                size_t n = std::min(ARENA_BLOCK_SIZE, count - i * ARENA_BLOCK_SIZE);
+                std::copy(blocks[i].get(), blocks[i].get() + n, out + i * ARENA_BLOCK_SIZE);
+            }
+        }
+
+        void Clear()
+        {
+            blocks.clear();
+            count = 0;
+        }
+
+    private:
+        std::vector<std::unique_ptr<T[]>> blocks;
+        size_t count = 0;
+    };
+
+    // one corner of a face. While parsing, indices are 1-based as in the file with 0 for an absent attribute and
+    // negative values for references relative to the chunk (see encodeIndex). After stitching they are 0-based
+    // into the whole file, -1 if absent.
+    struct Corner
+    {
+        int32_t position;
+        int32_t texCoord;
+        int32_t normal;
+    };
+
+    inline bool operator==(const Corner &a, const Corner &b)
+    {
+        return a.position == b.position && a.texCoord == b.texCoord && a.normal == b.normal;
+    }
+
+    // o, g, usemtl and mtllib statements, in order, with the number of faces of the chunk before them
+    struct Event
+    {
+        enum Type { Object, Material, Library } type;
+        std::string name;
+        size_t face;
+    };
+
+    struct Chunk
+    {
+        Arena<glm::vec3> positions;
+        Arena<glm::vec2> texCoords;
+        Arena<glm::vec3> normals;
+        Arena<Corner> corners;
+        Arena<uint32_t> faceSizes;
+        std::vector<Event> events;
+    };
+
+    // ---- parsing ----
+
+    inline bool isSpace(char c)
+    {
+        return c == ' ' || c == '\t';
+    }
+
+    inline bool isLineEnd(char c)
+    {
+        return c == '\n' || c == '\r';
+    }
+
+    inline const char* skipSpace(const char *p, const char *end)
+    {
+        while (p < end && isSpace(*p))
+            p++;
+        return p;
+    }
+
+    inline const char* skipLine(const char *p, const char *end)
+    {
+        while (p < end && *p != '\n')
+            p++;
+        return p < end ? p + 1 : end;
+    }
+
+    // true if the line at p starts with keyword followed by white space
+    inline bool isKeyword(const char *p, const char *end, const char *keyword)
+    {
+        while (*keyword)
+        {
+            if (p == end || *p++ != *keyword++)
+                return false;
+        }
+        return p < end && isSpace(*p);
+    }
+
+    // rest of the line, without surrounding white space
+    inline std::string parseName(const char *p, const char *end)
+    {
+        p = skipSpace(p, end);
+        const char *last = p;
+        while (last < end && !isLineEnd(*last))
+            last++;
+        while (last > p && isSpace(last[-1]))
+            last--;
+        return std::string(p, last);
+    }
+
+    // decimal float with optional sign, fraction and exponent. The 19 leading digits are accumulated exactly and scaled
+    // by an exact power of ten, which gives the correctly rounded float for everything an exporter writes.
+    inline const char* parseFloat(const char *p, const char *end, float &out)
+    {
+        static const double POWERS_OF_TEN[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                               1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+        bool negative = false;
+        if (p < end && (*p == '-' || *p == '+'))
+            negative = *p++ == '-';
+
+        uint64_t mantissa = 0;
+        int digits = 0, exponent = 0;
+        for (; p < end && (unsigned)(*p - '0') < 10; p++)
+        {
+            if (digits < 19)
+            {
+                mantissa = mantissa * 10 + (*p - '0');
+                digits += mantissa != 0;
+            }
+            else
+                exponent++;
+        }
+        if (p < end && *p == '.')
+        {
+            for (p++; p < end && (unsigned)(*p - '0') < 10; p++)
+            {
+                if (digits < 19)
+                {
+                    mantissa = mantissa * 10 + (*p - '0');
+                    digits += mantissa != 0;
+                    exponent--;
+                }
+            }
+        }
+        if (p < end && (*p == 'e' || *p == 'E'))
+        {
+            p++;
+            bool negativeExponent = false;
+            if (p < end && (*p == '-' || *p == '+'))
+                negativeExponent = *p++ == '-';
+            int value = 0;
+            for (; p < end && (unsigned)(*p - '0') < 10; p++)
+                value = std::min(value * 10 + (*p - '0'), 1000);
+            exponent += negativeExponent ? -value : value;
+        }
+
+        double value = (double)mantissa;
+        if (exponent < 0)
+            value = exponent >= -22 ? value / POWERS_OF_TEN[-exponent] : value * std::pow(10.0, exponent);
+        else if (exponent > 0)
+            value = exponent <= 22 ? value * POWERS_OF_TEN[exponent] : value * std::pow(10.0, exponent);
+        out = (float)(negative ? -value : value);
+        return p;
+    }
+
+    // returns p unchanged if there is no number
+    inline const char* parseInt(const char *p, const char *end, int64_t &out)
+    {
+        const char *start = p;
+        bool negative = false;
+        if (p < end && (*p == '-' || *p == '+'))
+            negative = *p++ == '-';
+        const char *digits = p;
+        int64_t value = 0;
+        for (; p < end && (unsigned)(*p - '0') < 10; p++)
+            value = value * 10 + (*p - '0');
+        if (p == digits)
+            return start;
+        out = negative ? -value : value;
+        return p;
+    }
+
+    const int64_t RELATIVE_BIAS = (int64_t)1 << 30;
+
+    // a negative index counts back from the last element before the face. Its target is only known relative to the
+    // start of the chunk here, it's stored as that offset minus RELATIVE_BIAS and resolved by resolveIndex
+    inline int32_t encodeIndex(int64_t index, size_t chunkCount)
+    {
+        if (index > 0)
+            return (int32_t)index;
+        if (index == 0)
+            return 0;
+        return (int32_t)((int64_t)chunkCount + index - RELATIVE_BIAS);
+    }
+
+    inline int32_t resolveIndex(int32_t index, size_t chunkBase)
+    {
+        if (index > 0)
+            return index - 1;
+        if (index == 0)
+            return -1;
+        return (int32_t)((int64_t)chunkBase + index + RELATIVE_BIAS);
+    }
+
+    template <typename Vector>
+    inline const char* parseVector(const char *p, const char *end, int components, Vector &out)
+    {
+        for (int i = 0; i < components; i++)
+            p = parseFloat(skipSpace(p, end), end, out[i]);
+        return p;
+    }
+
+    inline void parseFace(const char *p, const char *end, Chunk &chunk)
+    {
+        uint32_t count = 0;
+        for (;;)
+        {
+            p = skipSpace(p, end);
+            int64_t index;
+            const char *next = parseInt(p, end, index);
+            if (next == p)
+                break;
+            Corner corner = {encodeIndex(index, chunk.positions.Size()), 0, 0};
+            p = next;
+            if (p < end && *p == '/')
+            {
+                next = parseInt(++p, end, index);
+                if (next != p)
+                    corner.texCoord = encodeIndex(index, chunk.texCoords.Size());
+                p = next;
+                if (p < end && *p == '/')
+                {
+                    next = parseInt(++p, end, index);
+                    if (next != p)
+                        corner.normal = encodeIndex(index, chunk.normals.Size());
+                    p = next;
+                }
+            }
+            chunk.corners.PushBack(corner);
+            count++;
+        }
+        // points and lines aren't meshes we can draw
+        if (count < 3)
+            chunk.corners.PopBack(count);
+        else
+            chunk.faceSizes.PushBack(count);
+    }
+
+    inline void parseChunk(const char *p, const char *end, Chunk &chunk)
+    {
+        while (p < end)
+        {
+            p = skipSpace(p, end);
+            if (p == end)
+                break;
+            if (isKeyword(p, end, "v"))
+            {
+                glm::vec3 position(0.0f);
+                parseVector(p + 1, end, 3, position);
+                chunk.positions.PushBack(position);
+            }
+            else if (isKeyword(p, end, "vt"))
+            {
+                glm::vec2 texCoord(0.0f);
+                parseVector(p + 2, end, 2, texCoord);
+                chunk.texCoords.PushBack(texCoord);
+            }
+            else if (isKeyword(p, end, "vn"))
+            {
+                glm::vec3 normal(0.0f);
+                parseVector(p + 2, end, 3, normal);
+                chunk.normals.PushBack(normal);
+            }
+            else if (isKeyword(p, end, "f"))
+                parseFace(p + 1, end, chunk);
+            else if (isKeyword(p, end, "o") || isKeyword(p, end, "g"))
+                chunk.events.push_back({Event::Object, parseName(p + 1, end), chunk.faceSizes.Size()});
+            else if (isKeyword(p, end, "usemtl"))
+                chunk.events.push_back({Event::Material, parseName(p + 6, end), chunk.faceSizes.Size()});
+            else if (isKeyword(p, end, "mtllib"))
+                chunk.events.push_back({Event::Library, parseName(p + 6, end), chunk.faceSizes.Size()});
+            p = skipLine(p, end);
+        }
+    }
+
+    // runs function(0) ... function(count - 1) on count threads
+    template <typename Function>
+    inline void parallelFor(unsigned int count, const Function &function)
+    {
+        std::vector<std::thread> threads;
+        for (unsigned int i = 1; i < count; i++)
+            threads.emplace_back(function, i);
+        function(0);
+        for (std::thread &thread : threads)
+            thread.join();
+    }
+
+    // ---- materials ----
+
+    // texture paths of a material by the sampler type the Model uses for them, as Assimp maps them:
+    // map_Kd diffuse, map_Ks specular, map_Bump (aiTextureType_HEIGHT) normal, map_Ka (aiTextureType_AMBIENT) height
+    struct Material
+    {
+        std::string diffuse, specular, normal, height;
+    };
+
+    // end of the white space separated token at p
+    inline const char* tokenEnd(const char *p, const char *end)
+    {
+        while (p < end && !isSpace(*p) && !isLineEnd(*p))
+            p++;
+        return p;
+    }
+
+    // texture statement options (-bm 0.5, -o u v w, -clamp on, ...) come before the path, skip them
+    inline std::string parseTexturePath(const char *p, const char *end)
+    {
+        // maximum argument count, -o/-s/-t take one to three numbers
+        static const std::unordered_map<std::string, int> OPTION_ARGUMENTS = {
+            {"-blendu", 1}, {"-blendv", 1}, {"-boost", 1}, {"-mm", 2}, {"-o", 3}, {"-s", 3}, {"-t", 3},
+            {"-texres", 1}, {"-clamp", 1}, {"-bm", 1}, {"-imfchan", 1}, {"-type", 1}, {"-cc", 1}};
+        p = skipSpace(p, end);
+        while (p < end && *p == '-')
+        {
+            const char *last = tokenEnd(p, end);
+            auto option = OPTION_ARGUMENTS.find(std::string(p, last));
+            if (option == OPTION_ARGUMENTS.end())
+                break;
+            p = skipSpace(last, end);
+            for (int i = 0; i < option->second && p < end; i++)
+            {
+                // optional arguments are numbers, anything else is the path
+                bool number = (unsigned)(*p - '0') < 10 || *p == '-' || *p == '+' || *p == '.';
+                if (i > 0 && !number)
+                    break;
+                p = skipSpace(tokenEnd(p, end), end);
+            }
+        }
+        return parseName(p, end);
+    }
+
+    // reads the materials of a .mtl file into materials, false if the file can't be opened
+    inline bool parseMaterialLibrary(const std::string &path, std::unordered_map<std::string, Material> &materials)
+    {
+        AssetFile file;
+        if (!file.Open(path))
+            return false;
+        const char *p = (const char*)file.Data();
+        const char *end = p + file.Size();
+        Material *material = nullptr;
+        while (p < end)
+        {
+            p = skipSpace(p, end);
+            if (isKeyword(p, end, "newmtl"))
+                material = &materials[parseName(p + 6, end)];
+            else if (material && isKeyword(p, end, "map_Kd"))
+                material->diffuse = parseTexturePath(p + 6, end);
+            else if (material && isKeyword(p, end, "map_Ks"))
+                material->specular = parseTexturePath(p + 6, end);
+            else if (material && isKeyword(p, end, "map_Ka"))
+                material->height = parseTexturePath(p + 6, end);
+            else if (material && (isKeyword(p, end, "map_Bump") || isKeyword(p, end, "map_bump")))
+                material->normal = parseTexturePath(p + 8, end);
+            else if (material && isKeyword(p, end, "bump"))
+                material->normal = parseTexturePath(p + 4, end);
+            p = skipLine(p, end);
+        }
+        return true;
+    }
+
+    // ---- mesh assembly ----
+
+    // all attributes and faces of the file, indices resolved
+    struct Geometry
+    {
+        std::vector<glm::vec3> positions;
+        std::vector<glm::vec2> texCoords;
+        std::vector<glm::vec3> normals;
+        std::vector<Corner> corners;
+        std::vector<uint32_t> faceSizes;
+        // first corner of every face
+        std::vector<size_t> faceStarts;
+    };
+
+    // a mesh as Assimp's OBJ importer splits them: faces of one object/group using one material
+    struct MeshRange
+    {
+        std::string material;
+        bool hasMaterial = false;
+        // [first, last) face ranges
+        std::vector<std::pair<size_t, size_t>> faces;
+
+        size_t FaceCount() const
+        {
+            size_t count = 0;
+            for (const auto &range : faces)
+                count += range.second - range.first;
+            return count;
+        }
+    };
+
+    inline uint64_t hashCorner(const Corner &corner)
+    {
+        uint64_t hash = (uint64_t)(uint32_t)corner.position * 0x9E3779B97F4A7C15ULL;
+        hash ^= (uint64_t)(uint32_t)corner.texCoord * 0xC2B2AE3D27D4EB4FULL;
+        hash ^= (uint64_t)(uint32_t)corner.normal * 0x165667B19E3779F9ULL;
+        return hash ^ (hash >> 31);
+    }
+
+    // maps every corner to the first corner with the same attributes. Every thread owns the corners whose hash
+    // falls into its partition and dedupes them in its own open addressing table, so no locking is needed and the
+    // result is the same as a sequential pass
+    inline void findFirstCorners(const Corner *corners, size_t count, std::vector<uint32_t> &first, unsigned int threadCount)
+    {
+        const uint32_t EMPTY = 0xFFFFFFFFu;
+        std::vector<uint64_t> hashes(count);
+        first.resize(count);
+        parallelFor(threadCount, [&](unsigned int thread) {
+            for (size_t i = count * thread / threadCount; i < count * (thread + 1) / threadCount; i++)
+                hashes[i] = hashCorner(corners[i]);
+        });
+        parallelFor(threadCount, [&](unsigned int thread) {
+            size_t capacity = 1024;
+            while (capacity < count / threadCount)
+                capacity *= 2;
+            std::vector<uint32_t> table(capacity, EMPTY);
+            size_t used = 0;
+            for (size_t i = 0; i < count; i++)
+            {
+                if (threadCount > 1 && (hashes[i] >> 40) % threadCount != thread)
+                    continue;
+                size_t mask = table.size() - 1;
+                size_t slot = hashes[i] & mask;
+                while (table[slot] != EMPTY && !(corners[table[slot]] == corners[i]))
+                    slot = (slot + 1) & mask;
+                if (table[slot] != EMPTY)
+                {
+                    first[i] = table[slot];
+                    continue;
+                }
+                table[slot] = (uint32_t)i;
+                first[i] = (uint32_t)i;
+                if (++used * 2 > table.size())
+                {
+                    // rehash into a table twice the size
+                    std::vector<uint32_t> grown(table.size() * 2, EMPTY);
+                    size_t grownMask = grown.size() - 1;
+                    for (uint32_t corner : table)
+                    {
+                        if (corner == EMPTY)
+                            continue;
+                        size_t s = hashes[corner] & grownMask;
+                        while (grown[s] != EMPTY)
+                            s = (s + 1) & grownMask;
+                        grown[s] = corner;
+                    }
+                    table.swap(grown);
+                }
+            }
+        });
+    }
+
+    // start corner of the triangle fan of a quad: its concave corner if it has one, like aiProcess_Triangulate.
+    // Assimp tests acos(left . diagonal) + acos(right . diagonal) > pi on normalized vectors, which is the same as
+    // left . diagonal + right . diagonal < 0 and needs neither acos nor the length of the diagonal
+    inline unsigned int quadStart(const glm::vec3 *p[4])
+    {
+        for (unsigned int i = 0; i < 4; i++)
+        {
+            glm::vec3 left = *p[(i + 3) % 4] - *p[i];
+            glm::vec3 diagonal = *p[(i + 2) % 4] - *p[i];
+            glm::vec3 right = *p[(i + 1) % 4] - *p[i];
+            float leftLength = glm::length(left), rightLength = glm::length(right);
+            if (leftLength == 0.0f || rightLength == 0.0f || diagonal == glm::vec3(0.0f))
+                continue;
+            if (glm::dot(left, diagonal) / leftLength + glm::dot(right, diagonal) / rightLength < 0.0f)
+                return i;
+        }
+        return 0;
+    }
+
+    inline bool isFinite(const glm::vec3 &v)
+    {
+        return std::isfinite(v.x) && std::isfinite(v.y) && std::isfinite(v.z);
+    }
+
+    inline void buildMesh(const Geometry &geometry, const MeshRange &range, const Material *material, MeshData &mesh, unsigned int threadCount)
+    {
+        // the corners of the mesh in face order, copied together only if the mesh is made of several face ranges
+        std::vector<Corner> cornerStorage;
+        std::vector<uint32_t> faceSizeStorage;
+        const Corner *cornerData;
+        const uint32_t *faceSizeData;
+        size_t cornerCount, faceCount;
+        auto cornerEnd = [&](size_t face) {
+            return face < geometry.faceStarts.size() ? geometry.faceStarts[face] : geometry.corners.size();
+        };
+        if (range.faces.size() == 1)
+        {
+            size_t first = geometry.faceStarts[range.faces[0].first];
+            cornerData = geometry.corners.data() + first;
+            cornerCount = cornerEnd(range.faces[0].second) - first;
+            faceSizeData = geometry.faceSizes.data() + range.faces[0].first;
+            faceCount = range.faces[0].second - range.faces[0].first;
+        }
+        else
+        {
+            for (const auto &faces : range.faces)
+            {
+                cornerStorage.insert(cornerStorage.end(), geometry.corners.begin() + geometry.faceStarts[faces.first],
+                                     geometry.corners.begin() + cornerEnd(faces.second));
+                faceSizeStorage.insert(faceSizeStorage.end(), geometry.faceSizes.begin() + faces.first, geometry.faceSizes.begin() + faces.second);
+            }
+            cornerData = cornerStorage.data();
+            cornerCount = cornerStorage.size();
+            faceSizeData = faceSizeStorage.data();
+            faceCount = faceSizeStorage.size();
+        }
+        if (cornerCount < 1 << 16)
+            threadCount = 1;
+
+        bool hasTexCoords = false, hasNormals = false;
+        for (size_t i = 0; i < cornerCount; i++)
+        {
+            hasTexCoords |= cornerData[i].texCoord >= 0;
+            hasNormals |= cornerData[i].normal >= 0;
+        }
+
+        // merge identical corners, vertices are numbered in order of first use
+        std::vector<uint32_t> first;
+        findFirstCorners(cornerData, cornerCount, first, threadCount);
+        std::vector<uint32_t> vertexOf(cornerCount);
+        uint32_t vertexCount = 0;
+        for (size_t i = 0; i < cornerCount; i++)
+            vertexOf[i] = first[i] == i ? vertexCount++ : vertexOf[first[i]];
+
+        mesh.vertices.assign(vertexCount, Vertex());
+        parallelFor(threadCount, [&](unsigned int thread) {
+            for (size_t i = cornerCount * thread / threadCount; i < cornerCount * (thread + 1) / threadCount; i++)
+            {
+                if (first[i] != i)
+                    continue;
+                Vertex &vertex = mesh.vertices[vertexOf[i]];
+                const Corner &corner = cornerData[i];
+                vertex.Position = geometry.positions[corner.position];
+                vertex.Normal = corner.normal >= 0 ? geometry.normals[corner.normal] : glm::vec3(0.0f);
+                vertex.TexCoords = corner.texCoord >= 0 ? geometry.texCoords[corner.texCoord] : glm::vec2(0.0f);
+                vertex.Tangent = glm::vec3(0.0f);
+                vertex.Bitangent = glm::vec3(0.0f);
+            }
+        });
+
+        // triangulate: triangles stay, quads are split at their concave corner, larger polygons are fanned
+        size_t indexCount = 0;
+        for (size_t i = 0; i < faceCount; i++)
+            indexCount += (faceSizeData[i] - 2) * 3;
+        mesh.indices.resize(indexCount);
+        size_t corner = 0, index = 0;
+        for (size_t face = 0; face < faceCount; face++)
+        {
+            uint32_t size = faceSizeData[face];
+            unsigned int start = 0;
+            if (size == 4)
+            {
+                const glm::vec3 *p[4];
+                for (int i = 0; i < 4; i++)
+                    p[i] = &mesh.vertices[vertexOf[corner + i]].Position;
+                start = quadStart(p);
+            }
+            for (uint32_t i = 1; i + 1 < size; i++)
+            {
+                mesh.indices[index++] = vertexOf[corner + start];
+                mesh.indices[index++] = vertexOf[corner + (start + i) % size];
+                mesh.indices[index++] = vertexOf[corner + (start + i + 1) % size];
+            }
+            corner += size;
+        }
+
+        // aiProcess_GenSmoothNormals: average the face normals of all faces around a position
+        if (!hasNormals)
+        {
+            std::unordered_map<int32_t, glm::vec3> positionNormals;
+            std::vector<int32_t> positionOf(vertexCount);
+            for (size_t i = 0; i < cornerCount; i++)
+                positionOf[vertexOf[i]] = cornerData[i].position;
+            for (size_t i = 0; i < mesh.indices.size(); i += 3)
+            {
+                const Vertex *v[3] = {&mesh.vertices[mesh.indices[i]], &mesh.vertices[mesh.indices[i + 1]], &mesh.vertices[mesh.indices[i + 2]]};
+                glm::vec3 normal = glm::cross(v[1]->Position - v[0]->Position, v[2]->Position - v[0]->Position);
+                float length = glm::length(normal);
+                if (length == 0.0f)
+                    continue;
+                for (int j = 0; j < 3; j++)
+                    positionNormals[positionOf[mesh.indices[i + j]]] += normal / length;
+            }
+            for (uint32_t i = 0; i < vertexCount; i++)
+            {
+                glm::vec3 normal = positionNormals[positionOf[i]];
+                float length = glm::length(normal);
+                mesh.vertices[i].Normal = length > 0.0f ? normal / length : normal;
+            }
+        }
+
+        // aiProcess_CalcTangentSpace, per triangle as Assimp computes it, projected into each vertex's tangent plane
+        // and averaged over the triangles sharing the vertex
+        if (hasTexCoords)
+        {
+            for (size_t i = 0; i < mesh.indices.size(); i += 3)
+            {
+                Vertex *v[3] = {&mesh.vertices[mesh.indices[i]], &mesh.vertices[mesh.indices[i + 1]], &mesh.vertices[mesh.indices[i + 2]]};
+                glm::vec3 e1 = v[1]->Position - v[0]->Position, e2 = v[2]->Position - v[0]->Position;
+                float sx = v[1]->TexCoords.x - v[0]->TexCoords.x, sy = v[1]->TexCoords.y - v[0]->TexCoords.y;
+                float tx = v[2]->TexCoords.x - v[0]->TexCoords.x, ty = v[2]->TexCoords.y - v[0]->TexCoords.y;
+                float direction = (tx * sy - ty * sx) < 0.0f ? -1.0f : 1.0f;
+                if (sx * ty == sy * tx)
+                {
+                    sx = 0.0f; sy = 1.0f;
+                    tx = 1.0f; ty = 0.0f;
+                }
+                glm::vec3 tangent = (e2 * sy - e1 * ty) * direction;
+                glm::vec3 bitangent = (e2 * sx - e1 * tx) * direction;
+                for (int j = 0; j < 3; j++)
+                {
+                    const glm::vec3 &normal = v[j]->Normal;
+                    glm::vec3 localTangent = glm::normalize(tangent - normal * glm::dot(tangent, normal));
+                    glm::vec3 localBitangent = glm::normalize(bitangent - normal * glm::dot(bitangent, normal));
+                    if (isFinite(localTangent) && isFinite(localBitangent))
+                    {
+                        v[j]->Tangent += localTangent;
+                        v[j]->Bitangent += localBitangent;
+                    }
+                }
+            }
+        }
+        for (Vertex &vertex : mesh.vertices)
+        {
+            float tangentLength = glm::length(vertex.Tangent), bitangentLength = glm::length(vertex.Bitangent);
+            if (tangentLength > 0.0f)
+                vertex.Tangent /= tangentLength;
+            if (bitangentLength > 0.0f)
+                vertex.Bitangent /= bitangentLength;
+            // aiProcess_FlipUVs
+            vertex.TexCoords.y = 1.0f - vertex.TexCoords.y;
+        }
+
+        // in the order Model::processMesh collects them
+        if (material)
+        {
+            const std::pair<const std::string*, const char*> textures[] = {
+                {&material->diffuse, "texture_diffuse"}, {&material->specular, "texture_specular"},
+                {&material->normal, "texture_normal"}, {&material->height, "texture_height"}};
+            for (const auto &texture : textures)
+            {
+                if (!texture.first->empty())
+                    mesh.textures.push_back(Texture{0, texture.second, *texture.first});
+            }
+        }
+        mesh.ComputeBounds();
+    }
+
+    // imports the OBJ file at path into meshes, using threadCount threads (0 for one per core).
+    // returns false if the file can't be read or has no faces
+    inline bool Load(const std::string &path, std::vector<MeshData> &meshes, unsigned int threadCount = 0)
+    {
+        AssetFile file;
+        if (!file.Open(path))
+        {
+            std::cout << "ERROR::OBJ_LOADER:: can't open " << path << std::endl;
+            return false;
+        }
+        const char *data = (const char*)file.Data();
+        size_t size = file.Size();
+
+        // split into chunks of whole lines, at least 64 KB each
+        if (threadCount == 0)
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+        threadCount = (unsigned int)std::max<size_t>(1, std::min<size_t>(threadCount, size / (64 * 1024)));
+        std::vector<size_t> bounds(threadCount + 1, size);
+        bounds[0] = 0;
+        for (unsigned int i = 1; i < threadCount; i++)
+        {
+            size_t bound = std::max(size * i / threadCount, bounds[i - 1]);
+            bounds[i] = skipLine(data + bound, data + size) - data;
+        }
+        std::vector<Chunk> chunks(threadCount);
+        parallelFor(threadCount, [&](unsigned int i) {
+            parseChunk(data + bounds[i], data + bounds[i + 1], chunks[i]);
+        });
+
+        // stitch the chunks: offsets of every chunk's elements in the whole file
+        struct Offsets { size_t positions, texCoords, normals, corners, faces; };
+        std::vector<Offsets> offsets(threadCount + 1);
+        offsets[0] = Offsets{0, 0, 0, 0, 0};
+        for (unsigned int i = 0; i < threadCount; i++)
+        {
+            offsets[i + 1].positions = offsets[i].positions + chunks[i].positions.Size();
+            offsets[i + 1].texCoords = offsets[i].texCoords + chunks[i].texCoords.Size();
+            offsets[i + 1].normals = offsets[i].normals + chunks[i].normals.Size();
+            offsets[i + 1].corners = offsets[i].corners + chunks[i].corners.Size();
+            offsets[i + 1].faces = offsets[i].faces + chunks[i].faceSizes.Size();
+        }
+        Geometry geometry;
+        geometry.positions.resize(offsets[threadCount].positions);
+        geometry.texCoords.resize(offsets[threadCount].texCoords);
+        geometry.normals.resize(offsets[threadCount].normals);
+        geometry.corners.resize(offsets[threadCount].corners);
+        geometry.faceSizes.resize(offsets[threadCount].faces);
+        geometry.faceStarts.resize(offsets[threadCount].faces);
+        int32_t positionCount = (int32_t)geometry.positions.size();
+        int32_t texCoordCount = (int32_t)geometry.texCoords.size();
+        int32_t normalCount = (int32_t)geometry.normals.size();
+        parallelFor(threadCount, [&](unsigned int i) {
+            Chunk &chunk = chunks[i];
+            const Offsets &offset = offsets[i];
+            chunk.positions.CopyTo(geometry.positions.data() + offset.positions);
+            chunk.texCoords.CopyTo(geometry.texCoords.data() + offset.texCoords);
+            chunk.normals.CopyTo(geometry.normals.data() + offset.normals);
+            chunk.faceSizes.CopyTo(geometry.faceSizes.data() + offset.faces);
+            Corner *corners = geometry.corners.data() + offset.corners;
+            chunk.corners.CopyTo(corners);
+            for (size_t j = 0; j < chunk.corners.Size(); j++)
+            {
+                Corner &corner = corners[j];
+                corner.position = resolveIndex(corner.position, offset.positions);
+                corner.texCoord = resolveIndex(corner.texCoord, offset.texCoords);
+                corner.normal = resolveIndex(corner.normal, offset.normals);
+                // out of range references are dropped, a face without positions can't be drawn
+                if (corner.position < 0 || corner.position >= positionCount)
+                    corner.position = 0;
+                if (corner.texCoord >= texCoordCount)
+                    corner.texCoord = -1;
+                if (corner.normal >= normalCount)
+                    corner.normal = -1;
+            }
+            size_t start = offset.corners;
+            for (size_t j = 0; j < chunk.faceSizes.Size(); j++)
+            {
+                geometry.faceStarts[offset.faces + j] = start;
+                start += geometry.faceSizes[offset.faces + j];
+            }
+            chunk.positions.Clear();
+            chunk.texCoords.Clear();
+            chunk.normals.Clear();
+            chunk.corners.Clear();
+            chunk.faceSizes.Clear();
+        });
+        if (geometry.faceSizes.empty() || positionCount == 0)
+        {
+            std::cout << "ERROR::OBJ_LOADER:: no faces in " << path << std::endl;
+            return false;
+        }
+
+        // split the faces into meshes the way Assimp does: a new mesh for every object or group, and for every
+        // change of material once the current mesh has faces
+        std::vector<MeshRange> ranges;
+        std::vector<std::string> libraries;
+        std::string currentMaterial;
+        bool hasCurrentMaterial = false;
+        MeshRange *current = nullptr;
+        size_t face = 0;
+        auto newMesh = [&]() {
+            ranges.push_back(MeshRange());
+            current = &ranges.back();
+            current->material = currentMaterial;
+            current->hasMaterial = hasCurrentMaterial;
+        };
+        auto addFaces = [&](size_t last) {
+            if (last <= face)
+                return;
+            if (!current)
+                newMesh();
+            current->faces.push_back(std::make_pair(face, last));
+            face = last;
+        };
+        for (unsigned int i = 0; i < threadCount; i++)
+        {
+            for (const Event &event : chunks[i].events)
+            {
+                addFaces(offsets[i].faces + event.face);
+                if (event.type == Event::Object)
+                    newMesh();
+                else if (event.type == Event::Library)
+                    libraries.push_back(event.name);
+                else if (!hasCurrentMaterial || event.name != currentMaterial)
+                {
+                    currentMaterial = event.name;
+                    hasCurrentMaterial = true;
+                    if (!current || (current->hasMaterial && current->material != event.name && !current->faces.empty()))
+                        newMesh();
+                    current->material = event.name;
+                    current->hasMaterial = true;
+                }
+            }
+        }
+        addFaces(geometry.faceSizes.size());
+
+        // missing libraries leave their materials without textures, like Assimp's default material
+        std::unordered_map<std::string, Material> materials;
+        std::string directory = path.substr(0, path.find_last_of('/') + 1);
+        for (const std::string &library : libraries)
+        {
+            if (!parseMaterialLibrary(directory + library, materials))
+                std::cout << "WARNING::OBJ_LOADER:: can't open material library " << directory + library << std::endl;
+        }
+
+        std::vector<MeshData> result;
+        for (const MeshRange &range : ranges)
+        {
+            if (range.faces.empty())
+                continue;
+            auto material = range.hasMaterial ? materials.find(range.material) : materials.end();
+            result.push_back(MeshData());
+            buildMesh(geometry, range, material != materials.end() ? &material->second : nullptr, result.back(), threadCount);
+        }
+        meshes.swap(result);
+        return true;
+    }
+
+    // ---- verification ----
+
+    // compares two imports of the same file triangle corner by triangle corner, so differently shared vertices don't
+    // matter. Positions, texture coordinates, normals and textures have to match; tangent frames are smoothed slightly
+    // differently by the importers and only have to agree within 15 degrees on all but 1% of the corners.
+    // writes a line per mesh to report, returns true if everything matches
+    inline bool Compare(const std::vector<MeshData> &expected, const std::vector<MeshData> &actual, std::ostream &report)
+    {
+        if (expected.size() != actual.size())
+        {
+            report << "  mesh count " << actual.size() << ", expected " << expected.size() << std::endl;
+            return false;
+        }
+        bool matches = true;
+        for (size_t m = 0; m < expected.size(); m++)
+        {
+            const MeshData &a = expected[m], &b = actual[m];
+            report << "  mesh " << m << ": " << b.indices.size() / 3 << " triangles, " << b.vertices.size() << " vertices (expected "
+                   << a.vertices.size() << ")";
+            if (a.indices.size() != b.indices.size())
+            {
+                report << ", triangle count differs: expected " << a.indices.size() / 3 << std::endl;
+                matches = false;
+                continue;
+            }
+            bool texturesMatch = a.textures.size() == b.textures.size();
+            for (size_t i = 0; texturesMatch && i < a.textures.size(); i++)
+                texturesMatch = a.textures[i].type == b.textures[i].type && a.textures[i].path == b.textures[i].path;
+
+            size_t geometryErrors = 0, tangentErrors = 0;
+            float maxPositionError = 0.0f, maxTangentAngle = 0.0f;
+            for (size_t i = 0; i < a.indices.size(); i++)
+            {
+                const Vertex &u = a.vertices[a.indices[i]], &v = b.vertices[b.indices[i]];
+                float positionError = glm::length(u.Position - v.Position);
+                maxPositionError = std::max(maxPositionError, positionError);
+                if (positionError > 1e-5f * (1.0f + glm::length(u.Position)) || glm::length(u.TexCoords - v.TexCoords) > 1e-5f ||
+                    glm::length(u.Normal - v.Normal) > 1e-3f)
+                    geometryErrors++;
+                float tangentAngle = 0.0f;
+                if (glm::length(u.Tangent) > 0.0f && glm::length(v.Tangent) > 0.0f)
+                {
+                    float cosine = std::min(glm::dot(glm::normalize(u.Tangent), glm::normalize(v.Tangent)),
+                                            glm::dot(glm::normalize(u.Bitangent), glm::normalize(v.Bitangent)));
+                    tangentAngle = std::acos(std::max(-1.0f, std::min(1.0f, cosine))) * 57.2957795f;
+                }
+                else if (glm::length(u.Tangent) != glm::length(v.Tangent))
+                    tangentAngle = 180.0f;
+                maxTangentAngle = std::max(maxTangentAngle, tangentAngle);
+                tangentErrors += tangentAngle > 15.0f;
+            }
+            bool meshMatches = geometryErrors == 0 && texturesMatch && tangentErrors * 100 <= a.indices.size();
+            report << ", max position error " << maxPositionError << ", max tangent angle " << maxTangentAngle << " deg ("
+                   << tangentErrors << " corners over 15)" << (texturesMatch ? "" : ", textures differ")
+                   << (geometryErrors ? ", geometry differs at " : "");
+            if (geometryErrors)
+                report << geometryErrors << " corners";
+            report << (meshMatches ? " OK" : " MISMATCH") << std::endl;
+            matches &= meshMatches;
+        }
+        return matches;
+    }
+}
+#endif
@@ -0,0 +1,57 @@
+#ifndef PARALLEL_COMPILE_H
+#define PARALLEL_COMPILE_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/gl_extensions.h>
+
+// Background shader compilation. With KHR_parallel_shader_compile (or its ARB twin) the driver compiles and links
+// on threads of its own, and GL_COMPLETION_STATUS_KHR tells whether a shader or program is done without waiting for
+// it. Without the extension asking anything about a program that is still being built blocks until it is done.
+//
+// glad is generated for core 3.3 without extensions, so the entry point is loaded here by LoadFunctions.
+namespace ParallelCompile
+{
+    const GLenum MAX_SHADER_COMPILER_THREADS = 0x91B0;
+    const GLenum COMPLETION_STATUS = 0x91B1;
+
+    struct Functions {
+        void (APIENTRYP maxShaderCompilerThreads)(GLuint count) = nullptr;
+    };
+
+    inline Functions& functions()
+    {
+        static Functions loaded;
+        return loaded;
+    }
+
+    // false never polls the completion status (--no-parallel-compile), programs are waited for when first asked about
+    inline bool& Enabled()
+    {
+        static bool enabled = true;
+        return enabled;
+    }
+
+    // loads the entry point and lets the driver use as many compiler threads as it likes, call once the context is
+    // current. Returns false if the context has no parallel compilation
+    inline bool LoadFunctions(GLADloadproc load)
+    {
+        Functions &f = functions();
+        f = Functions();
+        if (GLExtensions::Has("GL_KHR_parallel_shader_compile"))
+            f.maxShaderCompilerThreads = (decltype(f.maxShaderCompilerThreads))load("glMaxShaderCompilerThreadsKHR");
+        else if (GLExtensions::Has("GL_ARB_parallel_shader_compile"))
+            f.maxShaderCompilerThreads = (decltype(f.maxShaderCompilerThreads))load("glMaxShaderCompilerThreadsARB");
+        // 0xFFFFFFFF is the implementation's own choice of thread count
+        if (f.maxShaderCompilerThreads)
+            f.maxShaderCompilerThreads(0xFFFFFFFFu);
+        return f.maxShaderCompilerThreads != nullptr;
+    }
+
+    // true if GL_COMPLETION_STATUS_KHR can be asked for
+    inline bool Supported()
+    {
+        return Enabled() && functions().maxShaderCompilerThreads != nullptr;
+    }
+}
+#endif
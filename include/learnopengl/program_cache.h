@@ -0,0 +1,238 @@
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/asset_pack.h>
+#include <learnopengl/gl_extensions.h>
+#include <learnopengl/mapped_file.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Cache of linked shader programs. After a program is linked from source its driver binary is written to
+// <vertex shader>+<fragment shader name>.progcache; later runs hand that binary to glProgramBinary and skip compiling
+// and linking. A binary is only used when the key it was stored with matches: the hash of every stage's source, the
+// defines and the GL_VENDOR/GL_RENDERER/GL_VERSION strings. If the driver rejects it anyway (it may after an
+// update that kept the version string) the program is compiled again and the cache rewritten.
+//
+// glad is generated for core 3.3, program binaries are core 4.1 or ARB_get_program_binary, so the entry points are
+// loaded here by LoadFunctions. Without them, or when the driver offers no binary format, every program is compiled.
+//
+// layout (little endian): FileHeader, binary
+namespace ProgramCache
+{
+    const uint32_t MAGIC = 0x42475250; // "PRGB"
+    const uint32_t VERSION = 1;
+
+    const GLenum PROGRAM_BINARY_RETRIEVABLE_HINT = 0x8257;
+    const GLenum PROGRAM_BINARY_LENGTH = 0x8741;
+    const GLenum NUM_PROGRAM_BINARY_FORMATS = 0x87FE;
+
+    struct FileHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t key;
+        uint32_t binaryFormat;
+        uint32_t binaryLength;
+    };
+
+    struct Stats {
+        // programs loaded from a cached binary, compiled from source, and cached binaries the driver rejected
+        unsigned int hits = 0;
+        unsigned int misses = 0;
+        unsigned int rejected = 0;
+        // time spent creating programs either way
+        double milliseconds = 0.0;
+    };
+
+    struct Functions {
+        void (APIENTRYP getProgramBinary)(GLuint program, GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, void *binary) = nullptr;
+        void (APIENTRYP programBinary)(GLuint program, GLenum binaryFormat, const void *binary, GLsizei length) = nullptr;
+        void (APIENTRYP programParameteri)(GLuint program, GLenum pname, GLint value) = nullptr;
+    };
+
+    inline Functions& functions()
+    {
+        static Functions loaded;
+        return loaded;
+    }
+
+    // false disables the cache (--no-program-cache), programs are always compiled
+    inline bool& Enabled()
+    {
+        static bool enabled = true;
+        return enabled;
+    }
+
+    inline Stats& GetStats()
+    {
+        static Stats stats;
+        return stats;
+    }
+
+    inline void PrintStats()
+    {
+        const Stats &stats = GetStats();
+        std::cout << "Shaders: " << stats.hits << " from the program cache, " << stats.misses << " compiled ("
+                  << stats.rejected << " cached binaries rejected) in " << stats.milliseconds << " ms" << std::endl;
+    }
+
+    // loads the program binary entry points, call once the context is current. Returns false if the context
+    // has no program binaries
+    inline bool LoadFunctions(GLADloadproc load)
+    {
+        Functions &f = functions();
+        f = Functions();
+        if (!GLExtensions::Version(4, 1) && !GLExtensions::Has("GL_ARB_get_program_binary"))
+            return false;
+        f.getProgramBinary = (decltype(f.getProgramBinary))load("glGetProgramBinary");
+        f.programBinary = (decltype(f.programBinary))load("glProgramBinary");
+        f.programParameteri = (decltype(f.programParameteri))load("glProgramParameteri");
+        if (!f.getProgramBinary || !f.programBinary || !f.programParameteri)
+            f = Functions();
+        return f.programBinary != nullptr;
+    }
+
+    // true if programs can be stored and loaded: the entry points are there and the driver has a binary format
+    inline bool Supported()
+    {
+        static int formats = -1;
+        if (!Enabled() || !functions().programBinary)
+            return false;
+        if (formats < 0)
+        {
+            GLint count = 0;
+            glGetIntegerv(NUM_PROGRAM_BINARY_FORMATS, &count);
+            formats = count;
+        }
+        return formats > 0;
+    }
+
+    inline uint64_t combine(uint64_t key, const void *data, size_t size)
+    {
+        const unsigned char *bytes = (const unsigned char*)data;
+        for (size_t i = 0; i < size; i++)
+        {
+            key ^= bytes[i];
+            key *= 1099511628211ULL;
+        }
+        return key;
+    }
+
+    // variants compiled with defines get a file each: <vertex shader>+<fragment shader>.<hash of defines>.progcache
+    inline std::string CachePath(const std::string &vertexPath, const std::string &fragmentPath, const std::string &defines = "")
+    {
+        std::string path = vertexPath + "+" + fragmentPath.substr(fragmentPath.find_last_of('/') + 1);
+        if (!defines.empty())
+        {
+            char suffix[24];
+            snprintf(suffix, sizeof(suffix), ".%016llx", (unsigned long long)combine(14695981039346656037ULL, defines.data(), defines.size()));
+            path += suffix;
+        }
+        return path + ".progcache";
+    }
+
+    // key of a program made of the given stage sources (in stage order, empty for stages it doesn't have) and
+    // defines, on this context's driver
+    inline uint64_t Key(const std::vector<const AssetFile*> &sources, const std::string &defines)
+    {
+        uint64_t key = 14695981039346656037ULL;
+        for (const AssetFile *source : sources)
+        {
+            uint64_t hash = source && source->IsOpen() ? AssetPack::Hash(source->Data(), source->Size()) : 0;
+            key = combine(key, &hash, sizeof(hash));
+        }
+        key = combine(key, defines.data(), defines.size() + 1);
+        for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION})
+        {
+            const char *value = (const char*)glGetString(name);
+            std::string text = value ? value : "";
+            key = combine(key, text.c_str(), text.size() + 1);
+        }
+        return key;
+    }
+
+    // asks the driver to keep the binary of program around, call before linking it
+    inline void PrepareLink(GLuint program)
+    {
+        if (Supported())
+            functions().programParameteri(program, PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+
+    // links program from the binary cached at cachePath. False on a miss, a stale key or a binary the driver
+    // rejects; program is then left unlinked and can be compiled as usual.
+    // Cached binaries belong to the machine that wrote them, they are read from disk and never from the asset pack
+    inline bool Load(const std::string &cachePath, uint64_t key, GLuint program)
+    {
+        if (!Supported())
+            return false;
+        MappedFile file;
+        if (!file.Open(cachePath))
+            return false;
+        FileHeader header;
+        if (file.Size() < sizeof(header))
+            return false;
+        memcpy(&header, file.Data(), sizeof(header));
+        if (header.magic != MAGIC || header.version != VERSION || header.key != key
+            || sizeof(header) + header.binaryLength > file.Size())
+            return false;
+
+        functions().programBinary(program, header.binaryFormat, file.Data() + sizeof(header), (GLsizei)header.binaryLength);
+        GLint linked = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if (!linked)
+        {
+            std::cout << "WARNING::PROGRAM_CACHE:: the driver rejected " << cachePath << ", compiling again" << std::endl;
+            GetStats().rejected++;
+            return false;
+        }
+        return true;
+    }
+
+    // writes the binary of the linked program to cachePath, through a temporary file like the other caches
+    inline bool Store(const std::string &cachePath, uint64_t key, GLuint program)
+    {
+        if (!Supported())
+            return false;
+        GLint length = 0;
+        glGetProgramiv(program, PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0)
+            return false;
+        std::vector<unsigned char> binary((size_t)length);
+        GLenum format = 0;
+        GLsizei written = 0;
+        functions().getProgramBinary(program, length, &written, &format, binary.data());
+        if (written <= 0)
+            return false;
+
+        FileHeader header = {MAGIC, VERSION, key, (uint32_t)format, (uint32_t)written};
+        std::ostringstream tmpName;
+        tmpName << cachePath << ".tmp" << std::this_thread::get_id();
+        std::string tmpPath = tmpName.str();
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!out)
+        {
+            std::cout << "WARNING::PROGRAM_CACHE:: can't write " << tmpPath << std::endl;
+            return false;
+        }
+        out.write((const char*)&header, sizeof(header));
+        out.write((const char*)binary.data(), written);
+        out.close();
+        if (!out || std::rename(tmpPath.c_str(), cachePath.c_str()) != 0)
+        {
+            std::remove(tmpPath.c_str());
+            std::cout << "WARNING::PROGRAM_CACHE:: failed to write " << cachePath << std::endl;
+            return false;
+        }
+        return true;
+    }
+}
+#endif
@@ -0,0 +1,152 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Draw items of a frame, ordered by a 64-bit key and executed in that order. The scene submits an item per draw
+// with the index of whatever describes the draw on its side; Sort orders them by key with a radix sort, Execute hands
+// the indices back in that order. From the most to the least significant bits the key holds
+//
+//   pass (4) | shader (10) | material (14) | vertex array (16) | depth (20)
+//
+// so passes run in enum order (the skybox last), items of a pass are grouped by program, then by material and
+// vertex array, and items sharing all of these are drawn front to back. Ids wider than their field are truncated:
+// two ids sharing the low bits are only grouped less well, the draws are still all there. The buffers are kept
+// between frames, a frame with no more items than an earlier one doesn't allocate.
+class RenderQueue
+{
+public:
+    enum Pass { Opaque = 0, Skybox = 15 };
+
+    struct Item
+    {
+        uint64_t key;
+        uint32_t index;
+    };
+
+    // how often the program, material and vertex array change from one item to the next, in the order the items
+    // were submitted and in the order they are executed in
+    struct Stats
+    {
+        unsigned int items = 0;
+        unsigned int submittedChanges[3] = {};
+        unsigned int sortedChanges[3] = {};
+
+        unsigned int Submitted() const
+        {
+            return submittedChanges[0] + submittedChanges[1] + submittedChanges[2];
+        }
+
+        unsigned int Sorted() const
+        {
+            return sortedChanges[0] + sortedChanges[1] + sortedChanges[2];
+        }
+    };
+
+    static const unsigned int SHADER_BITS = 10;
+    static const unsigned int MATERIAL_BITS = 14;
+    static const unsigned int VERTEX_ARRAY_BITS = 16;
+    static const unsigned int DEPTH_BITS = 20;
+
+    // depth is the distance from the camera, quantized over [0, farPlane], farther than farPlane sorts last
+    static uint64_t MakeKey(Pass pass, uint32_t shader, uint32_t material, uint32_t vertexArray, float depth, float farPlane)
+    {
+        const uint32_t maxDepth = (1u << DEPTH_BITS) - 1;
+        float normalized = farPlane > 0.0f ? depth / farPlane : 0.0f;
+        uint32_t quantized = normalized <= 0.0f ? 0 : normalized >= 1.0f ? maxDepth : (uint32_t)(normalized * maxDepth);
+        uint64_t key = (uint64_t)pass;
+        key = (key << SHADER_BITS) | (shader & ((1u << SHADER_BITS) - 1));
+        key = (key << MATERIAL_BITS) | (material & ((1u << MATERIAL_BITS) - 1));
+        key = (key << VERTEX_ARRAY_BITS) | (vertexArray & ((1u << VERTEX_ARRAY_BITS) - 1));
+        key = (key << DEPTH_BITS) | quantized;
+        return key;
+    }
+
+    void Clear()
+    {
+        items.clear();
+    }
+
+    void Submit(uint64_t key, uint32_t index)
+    {
+        items.push_back(Item{key, index});
+    }
+
+    size_t Size() const
+    {
+        return items.size();
+    }
+
+    const std::vector<Item>& Items() const
+    {
+        return items;
+    }
+
+    // stable LSD radix sort on the key, a byte per pass. Passes over a byte every key shares are skipped, which
+    // for a small scene is most of them
+    void Sort()
+    {
+        stats = Stats();
+        stats.items = (unsigned int)items.size();
+        countChanges(stats.submittedChanges);
+        scratch.resize(items.size());
+        for (unsigned int shift = 0; shift < 64; shift += 8)
+        {
+            size_t counts[256];
+            std::memset(counts, 0, sizeof(counts));
+            for (const Item &item : items)
+                counts[(item.key >> shift) & 0xFF]++;
+            if (items.empty() || counts[(items[0].key >> shift) & 0xFF] == items.size())
+                continue;
+            size_t offset = 0;
+            for (size_t &count : counts)
+            {
+                size_t bucket = count;
+                count = offset;
+                offset += bucket;
+            }
+            for (const Item &item : items)
+                scratch[counts[(item.key >> shift) & 0xFF]++] = item;
+            items.swap(scratch);
+        }
+        countChanges(stats.sortedChanges);
+    }
+
+    // calls draw(index) for every item, in key order once sorted
+    template <typename Draw>
+    void Execute(Draw draw) const
+    {
+        for (const Item &item : items)
+            draw(item.index);
+    }
+
+    // of the last Sort
+    const Stats& GetStats() const
+    {
+        return stats;
+    }
+
+private:
+    std::vector<Item> items;
+    std::vector<Item> scratch;
+    Stats stats;
+
+    // changes of the shader, material and vertex array fields between neighbouring items
+    void countChanges(unsigned int changes[3]) const
+    {
+        const unsigned int shifts[3] = {DEPTH_BITS + VERTEX_ARRAY_BITS + MATERIAL_BITS, DEPTH_BITS + VERTEX_ARRAY_BITS, DEPTH_BITS};
+        const uint64_t masks[3] = {(1u << SHADER_BITS) - 1, (1u << MATERIAL_BITS) - 1, (1u << VERTEX_ARRAY_BITS) - 1};
+        for (size_t i = 0; i < items.size(); i++)
+        {
+            for (int field = 0; field < 3; field++)
+            {
+                uint64_t value = (items[i].key >> shifts[field]) & masks[field];
+                if (i == 0 || value != ((items[i - 1].key >> shifts[field]) & masks[field]))
+                    changes[field]++;
+            }
+        }
+    }
+};
+#endif
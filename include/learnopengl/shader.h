@@ -4,178 +4,540 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <map>
 #include <string>
+#include <vector>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <common.h>
+#include <learnopengl/asset_pack.h>
+#include <learnopengl/gl_state.h>
+#include <learnopengl/parallel_compile.h>
+#include <learnopengl/program_cache.h>
+#include <learnopengl/uniform_blocks.h>
+
+// 32-bit FNV-1a of a uniform name, at compile time for literals
+constexpr uint32_t UniformHash(const char *name, size_t length)
+{
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++)
+    {
+        hash ^= (unsigned char)name[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// name of a uniform, hashed at compile time when it is a literal: shader.GetUniform("sunLight.position")
+struct UniformName
+{
+    uint32_t hash;
+
+    template <size_t N>
+    constexpr UniformName(const char (&name)[N]) : hash(UniformHash(name, N - 1))
+    {
+    }
+
+    // names put together at run time, hash them once and keep the UniformName
+    explicit UniformName(const std::string &name) : hash(UniformHash(name.c_str(), name.size()))
+    {
+    }
+};
+
+// location of a uniform in one program, resolved once. Setting a uniform the program doesn't have (location -1)
+// does nothing, like it does with glGetUniformLocation
+struct Uniform
+{
+    GLint location = -1;
+
+    bool Valid() const
+    {
+        return location >= 0;
+    }
+};
+
+// #defines a program variant is compiled with: ShaderDefines().Set("BLOOM").Set("SPOT_LIGHTS", 1). Key names the set
+// the same way whatever order the defines were set in, it is computed as they are set so looking a variant up by
+// it doesn't build strings
+class ShaderDefines
+{
+public:
+    ShaderDefines& Set(const std::string &name, const std::string &value = "1")
+    {
+        values[name] = value;
+        key.clear();
+        for (const auto &define : values)
+            key += define.first + "=" + define.second + ";";
+        return *this;
+    }
+
+    ShaderDefines& Set(const std::string &name, int value)
+    {
+        return Set(name, std::to_string(value));
+    }
+
+    const std::string& Key() const
+    {
+        return key;
+    }
+
+    bool Empty() const
+    {
+        return values.empty();
+    }
+
+    // the #define lines, one per define
+    std::string Source() const
+    {
+        std::string source;
+        for (const auto &define : values)
+            source += "#define " + define.first + " " + define.second + "\n";
+        return source;
+    }
+
+private:
+    std::map<std::string, std::string> values;
+    std::string key;
+};
+
 class Shader
 {
 public:
     unsigned int ID;
-    // constructor generates the shader on the fly
-    // ------------------------------------------------------------------------
-    Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr)
-    {
-        std::string vertexPathString(vertexPath);
-        std::string fragmentPathString(fragmentPath);
-
-        vertexPath = vertexPathString.c_str();
-        fragmentPath= fragmentPathString.c_str();
-        // 1. retrieve the vertex/fragment source code from filePath
-        std::string vertexCode;
-        std::string fragmentCode;
-        std::string geometryCode;
-        std::ifstream vShaderFile;
-        std::ifstream fShaderFile;
-        std::ifstream gShaderFile;
-        // ensure ifstream objects can throw exceptions:
-        vShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
-        fShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
-        gShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
-        try 
-        {
-            // open files
-            vShaderFile.open(vertexPath);
-            fShaderFile.open(fragmentPath);
-            std::stringstream vShaderStream, fShaderStream;
-            // read file's buffer contents into streams
-            vShaderStream << vShaderFile.rdbuf();
-            fShaderStream << fShaderFile.rdbuf();		
-            // close file handlers
-            vShaderFile.close();
-            fShaderFile.close();
-            // convert stream into string
-            vertexCode = vShaderStream.str();
-            fragmentCode = fShaderStream.str();			
-            // if geometry shader path is present, also load a geometry shader
-            if(geometryPath != nullptr)
-            {
-                std::string geometryPathString(geometryPath);
-                geometryPath = geometryPathString.c_str();
-                gShaderFile.open(geometryPath);
-                std::stringstream gShaderStream;
-                gShaderStream << gShaderFile.rdbuf();
-                gShaderFile.close();
-                geometryCode = gShaderStream.str();
-            }
-        }
-        catch (std::ifstream::failure& e)
-        {
+    // time from the constructor until the program was ready, and whether it came from the program cache
+    double loadMilliseconds = 0.0;
+    bool loadedFromCache = false;
+    // constructor generates the shader on the fly. defines are inserted into every stage right after its #version.
+    // A deferred shader only submits the compile and the link: Ready tells when the driver is done, without waiting
+    // for it where the context compiles in parallel (see ParallelCompile). Uniforms can be looked up once it is
+    // ------------------------------------------------------------------------
+    Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr,
+           const ShaderDefines &defines = ShaderDefines(), bool deferred = false)
+        : vertexPath(vertexPath), buildStart(std::chrono::steady_clock::now())
+    {
+        // 1. retrieve the vertex/fragment source code from filePath, straight from the asset pack or the mapped file
+        AssetFile vShaderFile;
+        AssetFile fShaderFile;
+        AssetFile gShaderFile;
+        if (!vShaderFile.Open(vertexPath) || !fShaderFile.Open(fragmentPath) || (geometryPath != nullptr && !gShaderFile.Open(geometryPath)))
             std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
+        // 2. reuse the driver binary of an earlier run when the sources and the driver are still the same
+        ID = glCreateProgram();
+        cachePath = ProgramCache::CachePath(vertexPath, fragmentPath, defines.Key());
+        cacheKey = ProgramCache::Key({&vShaderFile, &fShaderFile, &gShaderFile}, defines.Key());
+        if (ProgramCache::Load(cachePath, cacheKey, ID))
+        {
+            reflectUniforms();
+            bindUniformBlocks(this->vertexPath);
+            loadMilliseconds = millisecondsSince(buildStart);
+            loadedFromCache = true;
+            ProgramCache::GetStats().hits++;
+            ProgramCache::GetStats().milliseconds += loadMilliseconds;
+            return;
         }
-        const char* vShaderCode = vertexCode.c_str();
-        const char * fShaderCode = fragmentCode.c_str();
-        // 2. compile shaders
-        unsigned int vertex, fragment;
+        // start over with a fresh program, drivers differ in what a rejected binary leaves behind
+        glDeleteProgram(ID);
+        // 3. compile shaders. Their errors are checked by finish(), asking for them here would wait for the compile
+        std::string defineSource = defines.Source();
         // vertex shader
         vertex = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(vertex, 1, &vShaderCode, NULL);
+        setSource(vertex, vShaderFile, defineSource);
         glCompileShader(vertex);
-        checkCompileErrors(vertex, "VERTEX");
         // fragment Shader
         fragment = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(fragment, 1, &fShaderCode, NULL);
+        setSource(fragment, fShaderFile, defineSource);
         glCompileShader(fragment);
-        checkCompileErrors(fragment, "FRAGMENT");
         // if geometry shader is given, compile geometry shader
-        unsigned int geometry;
         if(geometryPath != nullptr)
         {
-            const char * gShaderCode = geometryCode.c_str();
             geometry = glCreateShader(GL_GEOMETRY_SHADER);
-            glShaderSource(geometry, 1, &gShaderCode, NULL);
+            setSource(geometry, gShaderFile, defineSource);
             glCompileShader(geometry);
-            checkCompileErrors(geometry, "GEOMETRY");
         }
         // shader Program
         ID = glCreateProgram();
         glAttachShader(ID, vertex);
         glAttachShader(ID, fragment);
-        if(geometryPath != nullptr)
+        if(geometry != 0)
             glAttachShader(ID, geometry);
+        ProgramCache::PrepareLink(ID);
         glLinkProgram(ID);
-        checkCompileErrors(ID, "PROGRAM");
-        // delete the shaders as they're linked into our program now and no longer necessery
-        glDeleteShader(vertex);
-        glDeleteShader(fragment);
-        if(geometryPath != nullptr)
-            glDeleteShader(geometry);
-
+        pending = true;
+        if (!deferred)
+            finish();
     }
-    // activate the shader
+    // true once the program is linked and its uniforms are known. Finishes the program when the driver is done
+    // with it, or right away, waiting for the driver, when the context can't tell
+    // ------------------------------------------------------------------------
+    bool Ready()
+    {
+        if (!pending)
+            return true;
+        if (ParallelCompile::Supported())
+        {
+            GLint done = GL_FALSE;
+            glGetProgramiv(ID, ParallelCompile::COMPLETION_STATUS, &done);
+            if (!done)
+                return false;
+        }
+        finish();
+        return true;
+    }
+    // waits for the driver to finish the program
+    // ------------------------------------------------------------------------
+    void Wait()
+    {
+        if (pending)
+            finish();
+    }
+    // activate the shader, nothing reaches the driver if it already is
     // ------------------------------------------------------------------------
     void use() 
     { 
-        glUseProgram(ID); 
+        GLState::Instance().UseProgram(ID); 
+    }
+    // the uniform called name, looked up in the table filled when the program was linked. Resolve the uniforms
+    // a render loop sets once, outside of it
+    // ------------------------------------------------------------------------
+    Uniform GetUniform(UniformName name) const
+    {
+        Uniform uniform;
+        uniform.location = location(name.hash);
+        return uniform;
+    }
+    // texture unit of the sampler, the same for every mesh drawn with this program. A sampler gets the next free
+    // unit the first time it is asked for, which is set in the program right away (making it current); draws then
+    // only bind textures
+    // ------------------------------------------------------------------------
+    GLuint SamplerUnit(Uniform sampler)
+    {
+        for (const std::pair<GLint, GLuint> &assigned : samplerUnits)
+        {
+            if (assigned.first == sampler.location)
+                return assigned.second;
+        }
+        GLuint unit = (GLuint)samplerUnits.size();
+        if (unit >= GLState::MAX_TEXTURE_UNITS)
+        {
+            std::cout << "WARNING::SHADER:: more than " << GLState::MAX_TEXTURE_UNITS << " samplers, they share the last unit" << std::endl;
+            unit = GLState::MAX_TEXTURE_UNITS - 1;
+        }
+        use();
+        glUniform1i(sampler.location, (GLint)unit);
+        samplerUnits.push_back(std::make_pair(sampler.location, unit));
+        return unit;
+    }
+    // number of active uniforms (array elements count one by one)
+    size_t UniformCount() const
+    {
+        return uniformCount;
     }
-    // utility uniform functions
+    // utility uniform functions, by name: a table lookup per call, without asking the driver
     // ------------------------------------------------------------------------
     void setBool(const std::string &name, bool value) const
     {         
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value); 
+        glUniform1i(location(name), (int)value); 
     }
     // ------------------------------------------------------------------------
     void setInt(const std::string &name, int value) const
     { 
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value); 
+        glUniform1i(location(name), value); 
     }
     // ------------------------------------------------------------------------
     void setFloat(const std::string &name, float value) const
     { 
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value); 
+        glUniform1f(location(name), value); 
     }
     // ------------------------------------------------------------------------
     void setVec2(const std::string &name, const glm::vec2 &value) const
     { 
-        glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+        glUniform2fv(location(name), 1, &value[0]); 
     }
     void setVec2(const std::string &name, float x, float y) const
     { 
-        glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y); 
+        glUniform2f(location(name), x, y); 
     }
     // ------------------------------------------------------------------------
     void setVec3(const std::string &name, const glm::vec3 &value) const
     { 
-        glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+        glUniform3fv(location(name), 1, &value[0]); 
     }
     void setVec3(const std::string &name, float value) const
     {
-        glUniform3f(glGetUniformLocation(ID, name.c_str()), value, value, value);
+        glUniform3f(location(name), value, value, value);
     }
     void setVec3(const std::string &name, float x, float y, float z) const
     { 
-        glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z); 
+        glUniform3f(location(name), x, y, z); 
     }
     // ------------------------------------------------------------------------
     void setVec4(const std::string &name, const glm::vec4 &value) const
     { 
-        glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+        glUniform4fv(location(name), 1, &value[0]); 
     }
     void setVec4(const std::string &name, float x, float y, float z, float w) 
     { 
-        glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w); 
+        glUniform4f(location(name), x, y, z, w); 
     }
     // ------------------------------------------------------------------------
     void setMat2(const std::string &name, const glm::mat2 &mat) const
     {
-        glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix2fv(location(name), 1, GL_FALSE, &mat[0][0]);
     }
     // ------------------------------------------------------------------------
     void setMat3(const std::string &name, const glm::mat3 &mat) const
     {
-        glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix3fv(location(name), 1, GL_FALSE, &mat[0][0]);
     }
     // ------------------------------------------------------------------------
     void setMat4(const std::string &name, const glm::mat4 &mat) const
     {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        glUniformMatrix4fv(location(name), 1, GL_FALSE, &mat[0][0]);
+    }
+    // utility uniform functions, by pre-resolved handle: no lookup at all
+    // ------------------------------------------------------------------------
+    void setBool(Uniform uniform, bool value) const
+    {
+        glUniform1i(uniform.location, (int)value);
+    }
+    void setInt(Uniform uniform, int value) const
+    {
+        glUniform1i(uniform.location, value);
+    }
+    void setFloat(Uniform uniform, float value) const
+    {
+        glUniform1f(uniform.location, value);
+    }
+    void setVec2(Uniform uniform, const glm::vec2 &value) const
+    {
+        glUniform2fv(uniform.location, 1, &value[0]);
+    }
+    void setVec3(Uniform uniform, const glm::vec3 &value) const
+    {
+        glUniform3fv(uniform.location, 1, &value[0]);
+    }
+    void setVec3(Uniform uniform, float value) const
+    {
+        glUniform3f(uniform.location, value, value, value);
+    }
+    void setVec4(Uniform uniform, const glm::vec4 &value) const
+    {
+        glUniform4fv(uniform.location, 1, &value[0]);
+    }
+    void setMat3(Uniform uniform, const glm::mat3 &mat) const
+    {
+        glUniformMatrix3fv(uniform.location, 1, GL_FALSE, &mat[0][0]);
+    }
+    void setMat4(Uniform uniform, const glm::mat4 &mat) const
+    {
+        glUniformMatrix4fv(uniform.location, 1, GL_FALSE, &mat[0][0]);
     }
 
 private:
-    // utility function for checking shader compilation/linking errors.
+    // open addressing table of the active uniforms, keyed by name hash. Power of two sized, at most half full
+    struct UniformSlot
+    {
+        uint32_t hash;
+        GLint location;
+    };
+    std::vector<UniformSlot> uniforms;
+    // sampler location and unit, in the order SamplerUnit handed them out
+    std::vector<std::pair<GLint, GLuint>> samplerUnits;
+    size_t uniformCount = 0;
+    // what finish() needs of a program that is still being built
+    std::string vertexPath;
+    std::string cachePath;
+    uint64_t cacheKey = 0;
+    std::chrono::steady_clock::time_point buildStart;
+    unsigned int vertex = 0, fragment = 0, geometry = 0;
+    bool pending = false;
+
+    // checks the compile and link results, which waits for the driver if it isn't done yet, and takes in the
+    // linked program
+    // ------------------------------------------------------------------------
+    void finish()
+    {
+        checkCompileErrors(vertex, "VERTEX");
+        checkCompileErrors(fragment, "FRAGMENT");
+        if (geometry != 0)
+            checkCompileErrors(geometry, "GEOMETRY");
+        if (checkCompileErrors(ID, "PROGRAM"))
+            ProgramCache::Store(cachePath, cacheKey, ID);
+        reflectUniforms();
+        bindUniformBlocks(vertexPath);
+        // delete the shaders as they're linked into our program now and no longer necessery
+        glDeleteShader(vertex);
+        glDeleteShader(fragment);
+        if (geometry != 0)
+            glDeleteShader(geometry);
+        vertex = fragment = geometry = 0;
+        pending = false;
+        loadMilliseconds = millisecondsSince(buildStart);
+        ProgramCache::GetStats().misses++;
+        ProgramCache::GetStats().milliseconds += loadMilliseconds;
+    }
+
+    GLint location(uint32_t hash) const
+    {
+        if (uniforms.empty())
+            return -1;
+        size_t mask = uniforms.size() - 1;
+        for (size_t i = hash & mask;; i = (i + 1) & mask)
+        {
+            if (uniforms[i].location < 0)
+                return -1;
+            if (uniforms[i].hash == hash)
+                return uniforms[i].location;
+        }
+    }
+
+    GLint location(const std::string &name) const
+    {
+        return location(UniformHash(name.c_str(), name.size()));
+    }
+
+    void addUniform(const std::string &name, GLint uniformLocation)
+    {
+        uint32_t hash = UniformHash(name.c_str(), name.size());
+        size_t mask = uniforms.size() - 1;
+        size_t i = hash & mask;
+        for (; uniforms[i].location >= 0; i = (i + 1) & mask)
+        {
+            if (uniforms[i].hash == hash)
+            {
+                std::cout << "WARNING::SHADER:: uniform " << name << " collides with another uniform's hash, it can't be set" << std::endl;
+                return;
+            }
+        }
+        uniforms[i].hash = hash;
+        uniforms[i].location = uniformLocation;
+    }
+
+    // fills the uniform table with every active uniform of the linked program. Arrays are entered as a whole
+    // ("lights", same as "lights[0]") and element by element; uniforms in blocks have no location and are left out
+    // ------------------------------------------------------------------------
+    void reflectUniforms()
+    {
+        GLint count = 0, maxLength = 0;
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+        std::vector<std::pair<std::string, GLint>> found;
+        std::vector<GLchar> nameBuffer((size_t)maxLength + 1);
+        for (GLint i = 0; i < count; i++)
+        {
+            GLint size = 0;
+            GLenum type = 0;
+            GLsizei length = 0;
+            glGetActiveUniform(ID, (GLuint)i, (GLsizei)nameBuffer.size(), &length, &size, &type, nameBuffer.data());
+            std::string name(nameBuffer.data(), (size_t)length);
+            GLint uniformLocation = glGetUniformLocation(ID, name.c_str());
+            if (uniformLocation < 0)
+                continue;
+            found.push_back(std::make_pair(name, uniformLocation));
+            if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)
+            {
+                std::string base = name.substr(0, name.size() - 3);
+                found.push_back(std::make_pair(base, uniformLocation));
+                for (GLint element = 1; element < size; element++)
+                {
+                    std::string elementName = base + "[" + std::to_string(element) + "]";
+                    found.push_back(std::make_pair(elementName, glGetUniformLocation(ID, elementName.c_str())));
+                }
+            }
+        }
+
+        size_t capacity = 16;
+        while (capacity < found.size() * 2)
+            capacity *= 2;
+        uniforms.assign(capacity, UniformSlot{0, -1});
+        samplerUnits.clear();
+        uniformCount = found.size();
+        for (const auto &uniform : found)
+            addUniform(uniform.first, uniform.second);
+    }
+
+    // binds every shared block the program declares (see uniform_blocks.h) to its fixed binding point, and checks
+    // that the driver laid it out the way the C++ struct is: same size, same offset for every active member
+    // ------------------------------------------------------------------------
+    void bindUniformBlocks(const std::string &vertexPath)
+    {
+        GLint count = 0;
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORM_BLOCKS, &count);
+        for (GLint i = 0; i < count; i++)
+        {
+            GLchar nameBuffer[64];
+            GLsizei length = 0;
+            glGetActiveUniformBlockName(ID, (GLuint)i, sizeof(nameBuffer), &length, nameBuffer);
+            std::string name(nameBuffer, (size_t)length);
+            GLint binding = UniformBlocks::Binding(name);
+            if (binding < 0)
+            {
+                std::cout << "WARNING::SHADER:: " << vertexPath << " declares the unknown uniform block " << name << std::endl;
+                continue;
+            }
+            glUniformBlockBinding(ID, (GLuint)i, (GLuint)binding);
+
+            GLint dataSize = 0;
+            glGetActiveUniformBlockiv(ID, (GLuint)i, GL_UNIFORM_BLOCK_DATA_SIZE, &dataSize);
+            if ((size_t)dataSize != UniformBlocks::Size(name))
+                std::cout << "ERROR::SHADER::UNIFORM_BLOCK " << name << " in " << vertexPath << " is " << dataSize
+                          << " bytes, expected " << UniformBlocks::Size(name) << std::endl;
+            for (const UniformBlocks::Member *member = UniformBlocks::Members(name); member->name; member++)
+            {
+                // members the program doesn't use may be optimized out
+                GLuint index = GL_INVALID_INDEX;
+                glGetUniformIndices(ID, 1, &member->name, &index);
+                if (index == GL_INVALID_INDEX)
+                    continue;
+                GLint offset = -1;
+                glGetActiveUniformsiv(ID, 1, &index, GL_UNIFORM_OFFSET, &offset);
+                if ((size_t)offset != member->offset)
+                    std::cout << "ERROR::SHADER::UNIFORM_BLOCK " << name << "." << member->name << " in " << vertexPath
+                              << " is at " << offset << ", expected " << member->offset << std::endl;
+            }
+        }
+    }
+
+    // hands the file's text to GL by pointer and length, it is never copied into a string. defines go after the
+    // #version line, which has to come first, and a #line keeps the line numbers of compile errors those of the file
+    // ------------------------------------------------------------------------
+    void setSource(GLuint shader, const AssetFile &file, const std::string &defines)
+    {
+        const GLchar *code = file.IsOpen() ? (const GLchar*)file.Data() : "";
+        GLint length = file.IsOpen() ? (GLint)file.Size() : 0;
+        if (defines.empty())
+        {
+            glShaderSource(shader, 1, &code, &length);
+            return;
+        }
+        GLint versionLength = 0;
+        if (length >= 8 && strncmp(code, "#version", 8) == 0)
+        {
+            while (versionLength < length && code[versionLength] != '\n')
+                versionLength++;
+            if (versionLength < length)
+                versionLength++;
+        }
+        std::string injected = defines + "#line " + (versionLength > 0 ? "2" : "1") + "\n";
+        if (versionLength > 0 && code[versionLength - 1] != '\n')
+            injected = "\n" + injected;
+        const GLchar *parts[3] = {code, injected.c_str(), code + versionLength};
+        GLint lengths[3] = {versionLength, (GLint)injected.size(), length - versionLength};
+        glShaderSource(shader, 3, parts, lengths);
+    }
+
+    static double millisecondsSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // utility function for checking shader compilation/linking errors, returns true if there were none.
     // ------------------------------------------------------------------------
-    void checkCompileErrors(GLuint shader, std::string type)
+    bool checkCompileErrors(GLuint shader, std::string type)
     {
         GLint success;
         GLchar infoLog[1024];
@@ -197,6 +559,7 @@ private:
                 std::cout << "ERROR::PROGRAM_LINKING_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
             }
         }
+        return success != 0;
     }
 };
 #endif
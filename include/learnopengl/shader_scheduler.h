@@ -0,0 +1,135 @@
+#ifndef SHADER_SCHEDULER_H
+#define SHADER_SCHEDULER_H
+
+#include <learnopengl/parallel_compile.h>
+#include <learnopengl/shader.h>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Builds the programs of the application without waiting for them. Submit hands every compile and link to the
+// driver up front; Ready asks about one program when a pass needs it, and a pass whose program isn't ready is skipped
+// that frame. Where the driver compiles in parallel (see ParallelCompile) startup then takes as long as the slowest
+// program instead of all of them in a row. Without it the driver still gets every program before any is waited
+// for, and the first Ready of each waits for that one.
+//
+// onReady runs once per program, when it is first found ready, for what needs the linked program: sampler units,
+// uniform handles.
+class ShaderScheduler
+{
+public:
+    struct Program
+    {
+        std::string name;
+        std::unique_ptr<Shader> shader;
+        std::function<void(Shader&)> onReady;
+        bool ready = false;
+    };
+
+    ShaderScheduler() : start(std::chrono::steady_clock::now())
+    {
+    }
+
+    ShaderScheduler(const ShaderScheduler&) = delete;
+    ShaderScheduler& operator=(const ShaderScheduler&) = delete;
+
+    // starts building the program, the reference stays valid as long as the scheduler
+    Shader& Submit(const std::string &vertexPath, const std::string &fragmentPath,
+                   std::function<void(Shader&)> onReady = nullptr)
+    {
+        std::unique_ptr<Program> program(new Program());
+        program->name = fragmentPath.substr(fragmentPath.find_last_of('/') + 1);
+        program->shader.reset(new Shader(vertexPath.c_str(), fragmentPath.c_str(), nullptr, ShaderDefines(), true));
+        program->onReady = onReady;
+        programs.push_back(std::move(program));
+        return *programs.back()->shader;
+    }
+
+    // true once shader, which has to come from Submit, is linked and set up
+    bool Ready(Shader &shader)
+    {
+        for (std::unique_ptr<Program> &program : programs)
+        {
+            if (program->shader.get() == &shader)
+                return ready(*program);
+        }
+        return shader.Ready();
+    }
+
+    // asks every program that isn't ready yet, returns how many still aren't. Only waits without parallel compiling
+    size_t Update()
+    {
+        size_t pending = 0;
+        for (std::unique_ptr<Program> &program : programs)
+        {
+            if (!ready(*program))
+                pending++;
+        }
+        if (pending == 0 && allReadyMilliseconds < 0.0)
+            allReadyMilliseconds = millisecondsSince(start);
+        return pending;
+    }
+
+    // waits for every program, for code that can't skip a missing one
+    void WaitAll()
+    {
+        for (std::unique_ptr<Program> &program : programs)
+        {
+            program->shader->Wait();
+            ready(*program);
+        }
+        Update();
+    }
+
+    const std::vector<std::unique_ptr<Program>>& Programs() const
+    {
+        return programs;
+    }
+
+    // from the construction of the scheduler until the last program was found ready, negative until then
+    double AllReadyMilliseconds() const
+    {
+        return allReadyMilliseconds;
+    }
+
+    void PrintReport() const
+    {
+        double slowest = 0.0;
+        for (const std::unique_ptr<Program> &program : programs)
+        {
+            std::cout << "Program " << program->name << ": ready after " << program->shader->loadMilliseconds << " ms"
+                      << (program->shader->loadedFromCache ? " (program cache)" : "") << std::endl;
+            slowest = std::max(slowest, program->shader->loadMilliseconds);
+        }
+        std::cout << programs.size() << " programs ready after " << allReadyMilliseconds << " ms, the slowest after "
+                  << slowest << " ms" << (ParallelCompile::Supported() ? " (parallel compile)" : "") << std::endl;
+    }
+
+private:
+    std::vector<std::unique_ptr<Program>> programs;
+    std::chrono::steady_clock::time_point start;
+    double allReadyMilliseconds = -1.0;
+
+    bool ready(Program &program)
+    {
+        if (program.ready)
+            return true;
+        if (!program.shader->Ready())
+            return false;
+        program.ready = true;
+        if (program.onReady)
+            program.onReady(*program.shader);
+        return true;
+    }
+
+    static double millisecondsSince(std::chrono::steady_clock::time_point since)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+    }
+};
+#endif
@@ -0,0 +1,112 @@
+#ifndef SHADER_VARIANTS_H
+#define SHADER_VARIANTS_H
+
+#include <learnopengl/shader.h>
+
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// The programs one pair of shader files compiles to under different ShaderDefines. A variant is compiled the first
+// time it is asked for and kept, so a render loop picks the specialized program for its settings every frame (bloom
+// on or off, the number of spotlights) and branches that can't be taken never reach the GPU. Compiling goes through
+// Shader, cached driver binaries included; onCompiled sets up what a new program needs once, like its sampler units.
+// Request asks for a variant without waiting for it, a render loop keeps using the variant it had until the new one
+// is ready.
+class ShaderVariants
+{
+public:
+    struct Variant
+    {
+        std::string key;
+        double milliseconds;
+        bool fromCache;
+    };
+
+    ShaderVariants(const std::string &vertexPath, const std::string &fragmentPath,
+                   std::function<void(Shader&)> onCompiled = nullptr)
+        : vertexPath(vertexPath), fragmentPath(fragmentPath), onCompiled(onCompiled)
+    {
+    }
+
+    ShaderVariants(const ShaderVariants&) = delete;
+    ShaderVariants& operator=(const ShaderVariants&) = delete;
+
+    // the program of defines, compiled now if it is the first time it is asked for and waited for if it is still
+    // being compiled. References stay valid
+    Shader& Get(const ShaderDefines &defines)
+    {
+        Entry &entry = find(defines);
+        entry.shader->Wait();
+        completed(entry);
+        return *entry.shader;
+    }
+
+    // the program of defines if it is ready, otherwise null; the first request submits its compile
+    Shader* Request(const ShaderDefines &defines)
+    {
+        Entry &entry = find(defines);
+        if (!entry.shader->Ready())
+            return nullptr;
+        completed(entry);
+        return entry.shader.get();
+    }
+
+    // name of the shader files for reports
+    std::string Name() const
+    {
+        return fragmentPath.substr(fragmentPath.find_last_of('/') + 1);
+    }
+
+    // in the order they were compiled in
+    const std::vector<Variant>& Compiled() const
+    {
+        return compiled;
+    }
+
+    void PrintReport() const
+    {
+        for (const Variant &variant : compiled)
+            std::cout << "Shader variant " << Name() << " [" << variant.key << "]: " << variant.milliseconds << " ms"
+                      << (variant.fromCache ? " (program cache)" : " (compiled)") << std::endl;
+    }
+
+private:
+    std::string vertexPath;
+    std::string fragmentPath;
+    std::function<void(Shader&)> onCompiled;
+    struct Entry
+    {
+        std::string key;
+        std::unique_ptr<Shader> shader;
+        // onCompiled ran and the variant is in compiled
+        bool reported = false;
+    };
+    std::map<std::string, Entry> programs;
+    std::vector<Variant> compiled;
+
+    Entry& find(const ShaderDefines &defines)
+    {
+        auto it = programs.find(defines.Key());
+        if (it != programs.end())
+            return it->second;
+        Entry &entry = programs[defines.Key()];
+        entry.key = defines.Empty() ? "(none)" : defines.Key();
+        entry.shader.reset(new Shader(vertexPath.c_str(), fragmentPath.c_str(), nullptr, defines, true));
+        return entry;
+    }
+
+    void completed(Entry &entry)
+    {
+        if (entry.reported)
+            return;
+        entry.reported = true;
+        compiled.push_back(Variant{entry.key, entry.shader->loadMilliseconds, entry.shader->loadedFromCache});
+        if (onCompiled)
+            onCompiled(*entry.shader);
+    }
+};
+#endif
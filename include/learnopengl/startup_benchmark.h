@@ -0,0 +1,204 @@
+#ifndef STARTUP_BENCHMARK_H
+#define STARTUP_BENCHMARK_H
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Timings of the stages of startup, for --startup-bench. Stages on the main thread follow each other: Mark(name)
+// closes the stage that started at the previous Mark. Work on the asset workers overlaps them and is added with
+// Record. The report is JSON, and a report of an earlier run can serve as the baseline of the next one.
+class StartupBenchmark
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Stage
+    {
+        std::string name;
+        double milliseconds;
+        // ran on worker threads, overlapping the main thread stages
+        bool async;
+    };
+
+    StartupBenchmark() : start(Clock::now()), last(start)
+    {
+    }
+
+    // starts the clock over, for setup that isn't part of startup (dropping the page cache)
+    void Restart()
+    {
+        start = last = Clock::now();
+    }
+
+    // ends the current stage, naming it
+    void Mark(const std::string &name)
+    {
+        Clock::time_point now = Clock::now();
+        stages.push_back({name, std::chrono::duration<double, std::milli>(now - last).count(), false});
+        last = now;
+    }
+
+    void Record(const std::string &name, double milliseconds)
+    {
+        stages.push_back({name, milliseconds, true});
+    }
+
+    // time since the start, in milliseconds
+    double Elapsed() const
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    const std::vector<Stage>& Stages() const
+    {
+        return stages;
+    }
+
+    void Print() const
+    {
+        for (const Stage &stage : stages)
+            std::cout << "  " << stage.name << ": " << stage.milliseconds << " ms" << (stage.async ? " (async)" : "") << std::endl;
+    }
+
+    // writes the stages and the total as JSON, mode says how the run was made ("warm" or "cold")
+    bool WriteJson(const std::string &path, const std::string &mode) const
+    {
+        std::ofstream out(path, std::ios::trunc);
+        if (!out)
+        {
+            std::cout << "ERROR::STARTUP_BENCHMARK:: can't write " << path << std::endl;
+            return false;
+        }
+        out << "{\n  \"mode\": \"" << mode << "\",\n  \"stages\": [\n";
+        for (const Stage &stage : stages)
+        {
+            out << "    {\"name\": \"" << stage.name << "\", \"ms\": " << stage.milliseconds
+                << ", \"async\": " << (stage.async ? "true" : "false") << "},\n";
+        }
+        out << "    {\"name\": \"total\", \"ms\": " << Elapsed() << ", \"async\": false}\n  ]\n}\n";
+        return (bool)out;
+    }
+
+    // compares the stages with the report at baselinePath. A stage regressed when it took more than
+    // (1 + tolerance) times its baseline and at least slack milliseconds more; stages that aren't in both are
+    // skipped. Returns the number of regressions, -1 if the baseline can't be read
+    int Compare(const std::string &baselinePath, double tolerance, double slack) const
+    {
+        std::vector<Stage> baseline;
+        if (!ReadJson(baselinePath, baseline))
+        {
+            std::cout << "ERROR::STARTUP_BENCHMARK:: can't read the baseline " << baselinePath << std::endl;
+            return -1;
+        }
+        std::vector<Stage> current = stages;
+        current.push_back({"total", Elapsed(), false});
+        int regressions = 0;
+        for (const Stage &stage : current)
+        {
+            for (const Stage &base : baseline)
+            {
+                if (base.name != stage.name)
+                    continue;
+                if (stage.milliseconds > base.milliseconds * (1.0 + tolerance) && stage.milliseconds - base.milliseconds > slack)
+                {
+                    std::cout << "REGRESSION::STARTUP_BENCHMARK:: " << stage.name << " took " << stage.milliseconds
+                              << " ms, baseline " << base.milliseconds << " ms" << std::endl;
+                    regressions++;
+                }
+                break;
+            }
+        }
+        return regressions;
+    }
+
+    // reads the stages of a report written by WriteJson
+    static bool ReadJson(const std::string &path, std::vector<Stage> &result)
+    {
+        std::ifstream in(path);
+        if (!in)
+            return false;
+        std::stringstream buffer;
+        buffer << in.rdbuf();
+        std::string text = buffer.str();
+        result.clear();
+        size_t position = 0;
+        while ((position = text.find("\"name\": \"", position)) != std::string::npos)
+        {
+            position += 9;
+            size_t end = text.find('"', position);
+            size_t ms = text.find("\"ms\": ", end);
+            if (end == std::string::npos || ms == std::string::npos)
+                return false;
+            Stage stage;
+            stage.name = text.substr(position, end - position);
+            stage.milliseconds = strtod(text.c_str() + ms + 6, nullptr);
+            stage.async = false;
+            result.push_back(stage);
+            position = ms;
+        }
+        return !result.empty();
+    }
+
+    // evicts the files at paths (directories recursively) from the page cache, so the next reads go to the disk.
+    // Dropping the whole cache needs root; without it every file is flushed and evicted with posix_fadvise, which
+    // misses pages that are still mapped. Returns a description of what was done
+    static std::string DropPageCache(const std::vector<std::string> &paths)
+    {
+        sync();
+        {
+            std::ofstream dropCaches("/proc/sys/vm/drop_caches");
+            if (dropCaches && (dropCaches << "3\n") && dropCaches.flush())
+                return "drop_caches";
+        }
+        size_t files = 0;
+        for (const std::string &path : paths)
+            files += evict(path);
+        return "fadvise (" + std::to_string(files) + " files)";
+    }
+
+private:
+    Clock::time_point start;
+    Clock::time_point last;
+    std::vector<Stage> stages;
+
+    static size_t evict(const std::string &path)
+    {
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0)
+            return 0;
+        if (S_ISDIR(st.st_mode))
+        {
+            size_t files = 0;
+            DIR *dir = opendir(path.c_str());
+            if (!dir)
+                return 0;
+            while (dirent *entry = readdir(dir))
+            {
+                std::string name = entry->d_name;
+                if (name != "." && name != "..")
+                    files += evict(path + '/' + name);
+            }
+            closedir(dir);
+            return files;
+        }
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return 0;
+        fdatasync(fd);
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+        return 1;
+    }
+};
+#endif
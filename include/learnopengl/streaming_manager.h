@@ -0,0 +1,189 @@
+#ifndef STREAMING_MANAGER_H
+#define STREAMING_MANAGER_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/asset_loader.h>
+#include <learnopengl/model.h>
+
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Loads models only while the camera is near the region they are seen in, and unloads them again once it has left.
+// Every streamed model is registered with an axis aligned trigger region. When the camera comes within
+// prefetchDistance of it the model starts loading on the loader's workers. When the camera has been further than
+// evictDistance for evictDelay seconds, its meshes and texture references are released. evictDistance is larger
+// than prefetchDistance, so walking along the edge of a region doesn't load and unload the model over and over.
+// Update and Get are meant for the context thread, the loads themselves run like any other Model(path, loader).
+class StreamingManager
+{
+public:
+    enum class Residency { Unloaded, Loading, Resident };
+
+    struct Settings
+    {
+        float prefetchDistance = 1.5f;
+        float evictDistance = 3.0f;
+        double evictDelay = 5.0;
+    };
+
+    // what the ImGui panel shows of a streamed model
+    struct Status
+    {
+        std::string name;
+        Residency residency = Residency::Unloaded;
+        // distance of the camera from the region, 0 inside it
+        float distance = 0.0f;
+        // load time of the current (or last) load: request to the model being uploaded
+        double lastLoadMilliseconds = 0.0;
+        bool lastLoadFromCache = false;
+        // time the camera spent inside the region while the model wasn't there yet, over all loads
+        double missedMilliseconds = 0.0;
+        unsigned int loads = 0;
+        unsigned int evictions = 0;
+        Model::MemoryUsage memory;
+    };
+
+    Settings settings;
+
+    explicit StreamingManager(AssetLoader &loader) : loader(loader)
+    {
+    }
+
+    StreamingManager(const StreamingManager&) = delete;
+    StreamingManager& operator=(const StreamingManager&) = delete;
+
+    // registers the model at path to be loaded near the box regionMin..regionMax, setup configures every new
+    // instance (texture prefix, vertex format...) right after it is created. Returns the handle for Get
+    size_t Register(const std::string &name, const std::string &path, glm::vec3 regionMin, glm::vec3 regionMax,
+                    std::function<void(Model&)> setup = nullptr)
+    {
+        Entry entry;
+        entry.status.name = name;
+        entry.path = path;
+        entry.regionMin = regionMin;
+        entry.regionMax = regionMax;
+        entry.setup = setup;
+        entries.push_back(std::move(entry));
+        return entries.size() - 1;
+    }
+
+    // loads and evicts against the camera position, time in seconds (glfwGetTime). Call once per frame
+    void Update(const glm::vec3 &cameraPosition, double time)
+    {
+        double frameMilliseconds = lastTime < 0.0 ? 0.0 : (time - lastTime) * 1000.0;
+        lastTime = time;
+        for (Entry &entry : entries)
+        {
+            Status &status = entry.status;
+            glm::vec3 outside = glm::max(glm::max(entry.regionMin - cameraPosition, cameraPosition - entry.regionMax), glm::vec3(0.0f));
+            status.distance = glm::length(outside);
+
+            if (status.distance <= settings.prefetchDistance)
+            {
+                entry.farSince = -1.0;
+                if (!entry.model)
+                    load(entry, time);
+            }
+            else if (entry.model && status.distance > settings.evictDistance)
+            {
+                if (entry.farSince < 0.0)
+                    entry.farSince = time;
+                else if (time - entry.farSince >= settings.evictDelay)
+                    evict(entry);
+            }
+            else
+                entry.farSince = -1.0;
+
+            if (entry.model && status.residency == Residency::Loading && entry.model->IsLoaded())
+            {
+                status.residency = Residency::Resident;
+                status.lastLoadMilliseconds = (time - entry.requested) * 1000.0;
+                status.lastLoadFromCache = entry.model->loadedFromCache;
+            }
+            if (status.residency == Residency::Resident)
+                status.memory = entry.model->GetMemoryUsage();
+            if (status.distance == 0.0f && status.residency != Residency::Resident)
+                status.missedMilliseconds += frameMilliseconds;
+        }
+    }
+
+    // the model of handle if it is loaded, null otherwise
+    Model* Get(size_t handle)
+    {
+        Entry &entry = entries[handle];
+        return entry.status.residency == Residency::Resident ? entry.model.get() : nullptr;
+    }
+
+    // drops every model at once, regardless of the camera
+    void EvictAll()
+    {
+        for (Entry &entry : entries)
+        {
+            if (entry.model)
+                evict(entry);
+        }
+    }
+
+    std::vector<Status> GetStatus() const
+    {
+        std::vector<Status> result;
+        for (const Entry &entry : entries)
+            result.push_back(entry.status);
+        return result;
+    }
+
+    static const char* Name(Residency residency)
+    {
+        switch (residency)
+        {
+            case Residency::Unloaded: return "unloaded";
+            case Residency::Loading: return "loading";
+            default: return "resident";
+        }
+    }
+
+private:
+    struct Entry
+    {
+        Status status;
+        std::string path;
+        glm::vec3 regionMin;
+        glm::vec3 regionMax;
+        std::function<void(Model&)> setup;
+        std::unique_ptr<Model> model;
+        double requested = 0.0;
+        // when the camera went past evictDistance, negative while it is closer
+        double farSince = -1.0;
+    };
+
+    AssetLoader &loader;
+    std::vector<Entry> entries;
+    double lastTime = -1.0;
+
+    void load(Entry &entry, double time)
+    {
+        entry.model.reset(new Model(entry.path, loader));
+        if (entry.setup)
+            entry.setup(*entry.model);
+        entry.requested = time;
+        entry.status.residency = Residency::Loading;
+        entry.status.loads++;
+    }
+
+    // the model may still be loading, Model drops the results of a load it no longer exists for
+    void evict(Entry &entry)
+    {
+        entry.model.reset();
+        entry.farSince = -1.0;
+        entry.status.residency = Residency::Unloaded;
+        entry.status.memory = Model::MemoryUsage();
+        entry.status.evictions++;
+        std::cout << "Streaming: evicted " << entry.status.name << std::endl;
+    }
+};
+#endif
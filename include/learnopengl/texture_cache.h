@@ -0,0 +1,648 @@
+#ifndef TEXTURE_CACHE_H
+#define TEXTURE_CACHE_H
+
+#include <glad/glad.h>
+#include <stb_image.h>
+
+#include <learnopengl/asset_pack.h>
+#include <learnopengl/block_compression.h>
+#include <learnopengl/gl_extensions.h>
+#include <learnopengl/gl_state.h>
+#include <learnopengl/mapped_file.h>
+
+#include <dirent.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// decoded image as returned by stb_image, the pixels are freed when it goes out of scope.
+// decoding doesn't need the GL context, so images can be loaded on any thread.
+struct ImageData
+{
+    int width = 0, height = 0, components = 0;
+    unsigned char *pixels = nullptr;
+
+    ImageData() = default;
+    ImageData(const ImageData&) = delete;
+    ImageData& operator=(const ImageData&) = delete;
+    ImageData(ImageData &&other) noexcept : width(other.width), height(other.height), components(other.components), pixels(other.pixels)
+    {
+        other.pixels = nullptr;
+    }
+    ~ImageData()
+    {
+        if (pixels)
+            stbi_image_free(pixels);
+    }
+
+    // decodes the image straight from the asset pack or the mapped file
+    bool Load(const std::string &filename)
+    {
+        AssetFile file;
+        if (!file.Open(filename))
+            return false;
+        pixels = stbi_load_from_memory(file.Data(), (int)file.Size(), &width, &height, &components, 0);
+        return pixels != nullptr;
+    }
+};
+
+// one mip level, pixels point into the owning TextureData
+struct TextureLevel
+{
+    const unsigned char *pixels;
+    int width, height;
+    size_t size;
+};
+
+// every mip level of a texture in its final GL format, either mapped from the texture cache or baked in memory.
+// like ImageData it's plain cpu data, so it can be produced on any thread.
+struct TextureData
+{
+    GLenum internalFormat = GL_RGBA8;
+    GLenum format = GL_RGBA;
+    GLenum type = GL_UNSIGNED_BYTE;
+    int components = 0;
+    std::vector<TextureLevel> levels;
+    bool fromCache = false;
+    // block compression of the levels, psnr is the quality of the base level against the source (dB)
+    BlockFormat blockFormat = BlockFormat::None;
+    float psnr = 0.0f;
+    // size of all levels without block compression
+    size_t uncompressedSize = 0;
+
+    // backing storage of levels, only one of them is used
+    AssetFile file;
+    std::vector<unsigned char> storage;
+
+    bool Valid() const
+    {
+        return !levels.empty();
+    }
+
+    bool Compressed() const
+    {
+        return blockFormat != BlockFormat::None;
+    }
+
+    size_t Size() const
+    {
+        size_t size = 0;
+        for (const TextureLevel &level : levels)
+            size += level.size;
+        return size;
+    }
+
+    // compressed levels can only be addressed in rows of 4x4 blocks
+    int RowGroupHeight() const
+    {
+        return Compressed() ? 4 : 1;
+    }
+
+    size_t RowGroupSize(const TextureLevel &level) const
+    {
+        if (Compressed())
+            return (size_t)((level.width + 3) / 4) * BlockCompression::BlockBytes(blockFormat);
+        return (size_t)level.width * components;
+    }
+};
+
+// which block compressed formats the driver accepts, and how textures pick one of them
+struct TextureCompression
+{
+    // BC1/BC3, GL_EXT_texture_compression_s3tc
+    bool s3tc = false;
+    // BC7, GL 4.2 or GL_ARB_texture_compression_bptc
+    bool bptc = false;
+    // lowest acceptable quality of a compressed texture, below it the texture stays uncompressed
+    double minPSNR = 38.0;
+    // used for every texture instead of picking by quality when set, cubemap faces have to share one format
+    BlockFormat forced = BlockFormat::None;
+
+    // settings that change the baked result, stored in the cache
+    uint32_t Key() const
+    {
+        return (s3tc ? 1u : 0u) | (bptc ? 2u : 0u) | ((uint32_t)forced << 2) | ((uint32_t)(minPSNR * 10.0) << 8);
+    }
+
+    // true if compressing a texture of the given components with these settings picks baked, the format it got
+    // under the settings of bakedKey. Baking tries the same candidates in the same order, so a driver that supports
+    // fewer formats than the bake had reuses every texture that ended up in one of its formats; --bake-textures
+    // bakes for all of them at once
+    bool Reproduces(uint32_t bakedKey, BlockFormat baked, int components) const
+    {
+        // never compressed whatever the settings
+        if (components < 3)
+            return true;
+        if (forced != BlockFormat::None)
+            return baked == (Supports(forced) ? forced : BlockFormat::None);
+        bool bakedS3TC = (bakedKey & 1u) != 0, bakedBPTC = (bakedKey & 2u) != 0;
+        BlockFormat bakedForced = (BlockFormat)((bakedKey >> 2) & 0x3Fu);
+        if (bakedForced != BlockFormat::None || (bakedKey >> 8) != (uint32_t)(minPSNR * 10.0))
+            return false;
+        // a format the bake didn't have could have been picked before baked
+        if ((s3tc && !bakedS3TC) || (bptc && !bakedBPTC))
+            return false;
+        return baked == BlockFormat::None || Supports(baked);
+    }
+
+    // enables every format the current context supports
+    void DetectSupport()
+    {
+        s3tc = GLExtensions::Has("GL_EXT_texture_compression_s3tc");
+        bptc = GLExtensions::Version(4, 2) || GLExtensions::Has("GL_ARB_texture_compression_bptc");
+    }
+
+    bool Supports(BlockFormat format) const
+    {
+        if (format == BlockFormat::BC7)
+            return bptc;
+        return format != BlockFormat::None && s3tc;
+    }
+
+    // settings for the faces of a cubemap, which all need the same format whatever their content
+    TextureCompression Cubemap() const
+    {
+        TextureCompression cubemap = *this;
+        cubemap.forced = bptc ? BlockFormat::BC7 : (s3tc ? BlockFormat::BC3 : BlockFormat::None);
+        return cubemap;
+    }
+};
+
+// On-disk cache of textures with a precomputed mip chain, so later runs skip stb_image decoding and
+// glGenerateMipmap. The cache file sits next to the source as <image>.texcache, is created on the first
+// load (or ahead of time with --bake-textures) and is only used while the hash of the source file matches.
+//
+// layout, KTX-like:
+//   FileHeader, LevelHeader for every level, then the level data, each level starting 16-byte aligned
+namespace TextureCache
+{
+    const uint32_t MAGIC = 0x58455445; // "ETEX"
+    // bump whenever the layout or the baking changes
+    const uint32_t VERSION = 2;
+    const size_t LEVEL_ALIGNMENT = 16;
+
+    struct FileHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t sourceHash;
+        uint32_t internalFormat;
+        uint32_t format;
+        uint32_t type;
+        uint32_t components;
+        uint32_t width;
+        uint32_t height;
+        uint32_t levelCount;
+        uint32_t compressionKey;
+        uint32_t blockFormat;
+        float    psnr;
+        uint64_t uncompressedSize;
+    };
+
+    // compression used when baking, set up once (see TextureCompression::DetectSupport) before any texture loads
+    inline TextureCompression& Compression()
+    {
+        static TextureCompression compression;
+        return compression;
+    }
+
+    struct LevelHeader {
+        uint32_t width;
+        uint32_t height;
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    inline std::string CachePath(const std::string &sourcePath)
+    {
+        return sourcePath + ".texcache";
+    }
+
+    // 64-bit FNV-1a over the file contents, 0 if the file can't be read. Packed files have it precomputed
+    inline uint64_t HashFile(const std::string &path)
+    {
+        if (const AssetPack::Entry *entry = AssetPack::Instance().Resolve(path))
+            return entry->hash;
+        AssetFile file;
+        if (!file.Open(path))
+            return 0;
+        return AssetPack::Hash(file.Data(), file.Size());
+    }
+
+    inline void formatsForComponents(int components, GLenum &internalFormat, GLenum &format)
+    {
+        if (components == 1)
+        {
+            internalFormat = GL_R8;
+            format = GL_RED;
+        }
+        else if (components == 2)
+        {
+            internalFormat = GL_RG8;
+            format = GL_RG;
+        }
+        else if (components == 3)
+        {
+            internalFormat = GL_RGB8;
+            format = GL_RGB;
+        }
+        else
+        {
+            internalFormat = GL_RGBA8;
+            format = GL_RGBA;
+        }
+    }
+
+    // size of every level from the base down to 1x1, same rounding as glGenerateMipmap
+    inline std::vector<TextureLevel> mipLevels(int width, int height, int components)
+    {
+        std::vector<TextureLevel> levels;
+        while (true)
+        {
+            levels.push_back(TextureLevel{nullptr, width, height, (size_t)width * height * components});
+            if (width == 1 && height == 1)
+                break;
+            width = width > 1 ? width / 2 : 1;
+            height = height > 1 ? height / 2 : 1;
+        }
+        return levels;
+    }
+
+    // 2x2 box filter, the last row/column is repeated for odd sizes
+    inline void downsample(const unsigned char *src, int srcWidth, int srcHeight, unsigned char *dst, int dstWidth, int dstHeight, int components)
+    {
+        for (int y = 0; y < dstHeight; y++)
+        {
+            int y0 = std::min(2 * y, srcHeight - 1), y1 = std::min(2 * y + 1, srcHeight - 1);
+            for (int x = 0; x < dstWidth; x++)
+            {
+                int x0 = std::min(2 * x, srcWidth - 1), x1 = std::min(2 * x + 1, srcWidth - 1);
+                for (int c = 0; c < components; c++)
+                {
+                    int sum = src[(y0 * srcWidth + x0) * components + c] + src[(y0 * srcWidth + x1) * components + c]
+                            + src[(y1 * srcWidth + x0) * components + c] + src[(y1 * srcWidth + x1) * components + c];
+                    dst[(y * dstWidth + x) * components + c] = (unsigned char)((sum + 2) / 4);
+                }
+            }
+        }
+    }
+
+    // builds the full mip chain of a decoded image into texture.storage
+    inline void Bake(const ImageData &image, TextureData &texture)
+    {
+        texture.components = image.components;
+        texture.type = GL_UNSIGNED_BYTE;
+        formatsForComponents(image.components, texture.internalFormat, texture.format);
+        texture.levels = mipLevels(image.width, image.height, image.components);
+
+        size_t total = 0;
+        for (const TextureLevel &level : texture.levels)
+            total += level.size;
+        texture.storage.resize(total);
+
+        size_t offset = 0;
+        for (size_t i = 0; i < texture.levels.size(); i++)
+        {
+            TextureLevel &level = texture.levels[i];
+            unsigned char *dst = texture.storage.data() + offset;
+            if (i == 0)
+                memcpy(dst, image.pixels, level.size);
+            else
+            {
+                const TextureLevel &parent = texture.levels[i - 1];
+                downsample(parent.pixels, parent.width, parent.height, dst, level.width, level.height, image.components);
+            }
+            level.pixels = dst;
+            offset += level.size;
+        }
+        texture.uncompressedSize = total;
+        texture.blockFormat = BlockFormat::None;
+        texture.psnr = 0.0f;
+    }
+
+    inline GLenum compressedInternalFormat(BlockFormat format)
+    {
+        if (format == BlockFormat::BC1)
+            return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        if (format == BlockFormat::BC3)
+            return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        return GL_COMPRESSED_RGBA_BPTC_UNORM;
+    }
+
+    inline std::vector<unsigned char> toRGBA(const TextureData &texture, const TextureLevel &level)
+    {
+        std::vector<unsigned char> rgba((size_t)level.width * level.height * 4);
+        size_t pixels = (size_t)level.width * level.height;
+        for (size_t i = 0; i < pixels; i++)
+        {
+            for (int c = 0; c < 4; c++)
+                rgba[i * 4 + c] = c < texture.components ? level.pixels[i * texture.components + c] : 255;
+        }
+        return rgba;
+    }
+
+    // candidate formats in order of preference: opaque textures try the 4 bpp BC1 first, textures with
+    // alpha go straight to the 8 bpp formats, BC7 before BC3 since it's the same size at a higher quality
+    inline std::vector<BlockFormat> candidateFormats(bool opaque, const TextureCompression &settings)
+    {
+        std::vector<BlockFormat> candidates;
+        if (settings.forced != BlockFormat::None)
+        {
+            if (settings.Supports(settings.forced))
+                candidates.push_back(settings.forced);
+            return candidates;
+        }
+        if (opaque && settings.s3tc)
+            candidates.push_back(BlockFormat::BC1);
+        if (settings.bptc)
+            candidates.push_back(BlockFormat::BC7);
+        if (!opaque && settings.s3tc)
+            candidates.push_back(BlockFormat::BC3);
+        return candidates;
+    }
+
+    // replaces the levels of a baked RGB(A) texture with their block compressed version, using the first candidate
+    // format whose quality is at least settings.minPSNR. Leaves the texture alone if none qualifies.
+    inline void Compress(TextureData &texture, const TextureCompression &settings)
+    {
+        if (texture.components < 3 || texture.type != GL_UNSIGNED_BYTE)
+            return;
+
+        std::vector<unsigned char> base = toRGBA(texture, texture.levels[0]);
+        bool opaque = true;
+        for (size_t i = 3; i < base.size() && opaque; i += 4)
+            opaque = base[i] == 255;
+        int channels = opaque ? 3 : 4;
+
+        for (BlockFormat format : candidateFormats(opaque, settings))
+        {
+            std::vector<unsigned char> compressedBase;
+            double psnr = BlockCompression::CompressWithPSNR(format, base.data(), texture.levels[0].width, texture.levels[0].height, channels, compressedBase);
+            if (psnr < settings.minPSNR && settings.forced == BlockFormat::None)
+                continue;
+
+            std::vector<std::vector<unsigned char>> compressedLevels(texture.levels.size());
+            compressedLevels[0].swap(compressedBase);
+            size_t total = compressedLevels[0].size();
+            for (size_t i = 1; i < texture.levels.size(); i++)
+            {
+                const TextureLevel &level = texture.levels[i];
+                std::vector<unsigned char> rgba = toRGBA(texture, level);
+                compressedLevels[i].resize(BlockCompression::CompressedSize(format, level.width, level.height));
+                BlockCompression::Compress(format, rgba.data(), level.width, level.height, compressedLevels[i].data());
+                total += compressedLevels[i].size();
+            }
+
+            std::vector<unsigned char> storage(total);
+            size_t offset = 0;
+            for (size_t i = 0; i < texture.levels.size(); i++)
+            {
+                memcpy(storage.data() + offset, compressedLevels[i].data(), compressedLevels[i].size());
+                texture.levels[i].pixels = storage.data() + offset;
+                texture.levels[i].size = compressedLevels[i].size();
+                offset += compressedLevels[i].size();
+            }
+            texture.storage.swap(storage);
+            texture.blockFormat = format;
+            texture.internalFormat = compressedInternalFormat(format);
+            texture.psnr = (float)psnr;
+            return;
+        }
+    }
+
+    // one line memory report of a texture, e.g. "12.35 MB -> 3.09 MB (BC7, 44.9 dB)"
+    inline std::string Describe(const TextureData &texture)
+    {
+        std::ostringstream description;
+        description.precision(3);
+        description << texture.uncompressedSize / (1024.0 * 1024.0) << " MB -> " << texture.Size() / (1024.0 * 1024.0) << " MB ("
+                    << BlockCompression::Name(texture.blockFormat);
+        if (texture.Compressed())
+            description << ", " << texture.psnr << " dB";
+        description << ")";
+        return description.str();
+    }
+
+    inline size_t alignLevel(size_t n)
+    {
+        return (n + LEVEL_ALIGNMENT - 1) & ~(LEVEL_ALIGNMENT - 1);
+    }
+
+    // maps the cache of sourcePath, false on a miss or when the source or the compression settings changed since it was baked
+    inline bool Load(const std::string &sourcePath, uint64_t sourceHash, const TextureCompression &settings, TextureData &texture)
+    {
+        if (!texture.file.Open(CachePath(sourcePath)))
+            return false;
+        const unsigned char *data = texture.file.Data();
+        size_t size = texture.file.Size();
+
+        FileHeader header;
+        if (size < sizeof(header))
+            return false;
+        memcpy(&header, data, sizeof(header));
+        if (header.magic != MAGIC || header.version != VERSION || header.sourceHash != sourceHash || header.levelCount == 0
+            || !settings.Reproduces(header.compressionKey, (BlockFormat)header.blockFormat, (int)header.components))
+            return false;
+        if (sizeof(header) + header.levelCount * sizeof(LevelHeader) > size)
+            return false;
+
+        std::vector<TextureLevel> levels(header.levelCount);
+        for (uint32_t i = 0; i < header.levelCount; i++)
+        {
+            LevelHeader levelHeader;
+            memcpy(&levelHeader, data + sizeof(header) + i * sizeof(LevelHeader), sizeof(levelHeader));
+            if (levelHeader.offset + levelHeader.size > size)
+                return false;
+            levels[i] = TextureLevel{data + levelHeader.offset, (int)levelHeader.width, (int)levelHeader.height, (size_t)levelHeader.size};
+        }
+
+        texture.internalFormat = header.internalFormat;
+        texture.format = header.format;
+        texture.type = header.type;
+        texture.components = (int)header.components;
+        texture.blockFormat = (BlockFormat)header.blockFormat;
+        texture.psnr = header.psnr;
+        texture.uncompressedSize = header.uncompressedSize;
+        texture.levels.swap(levels);
+        texture.fromCache = true;
+        return true;
+    }
+
+    // writes texture as the cache of sourcePath, through a temporary file so readers never see a partial cache
+    inline bool Store(const std::string &sourcePath, uint64_t sourceHash, const TextureCompression &settings, const TextureData &texture)
+    {
+        FileHeader header;
+        header.magic = MAGIC;
+        header.version = VERSION;
+        header.sourceHash = sourceHash;
+        header.internalFormat = texture.internalFormat;
+        header.format = texture.format;
+        header.type = texture.type;
+        header.components = (uint32_t)texture.components;
+        header.width = (uint32_t)texture.levels[0].width;
+        header.height = (uint32_t)texture.levels[0].height;
+        header.levelCount = (uint32_t)texture.levels.size();
+        header.compressionKey = settings.Key();
+        header.blockFormat = (uint32_t)texture.blockFormat;
+        header.psnr = texture.psnr;
+        header.uncompressedSize = texture.uncompressedSize;
+
+        std::string cachePath = CachePath(sourcePath);
+        std::ostringstream tmpName;
+        tmpName << cachePath << ".tmp" << std::this_thread::get_id();
+        std::string tmpPath = tmpName.str();
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!out)
+        {
+            std::cout << "WARNING::TEXTURE_CACHE:: can't write " << tmpPath << std::endl;
+            return false;
+        }
+
+        size_t offset = alignLevel(sizeof(header) + texture.levels.size() * sizeof(LevelHeader));
+        out.write((const char*)&header, sizeof(header));
+        for (const TextureLevel &level : texture.levels)
+        {
+            LevelHeader levelHeader{(uint32_t)level.width, (uint32_t)level.height, offset, level.size};
+            out.write((const char*)&levelHeader, sizeof(levelHeader));
+            offset = alignLevel(offset + level.size);
+        }
+
+        static const char zeros[LEVEL_ALIGNMENT] = {};
+        size_t written = sizeof(header) + texture.levels.size() * sizeof(LevelHeader);
+        for (const TextureLevel &level : texture.levels)
+        {
+            out.write(zeros, alignLevel(written) - written);
+            written = alignLevel(written);
+            out.write((const char*)level.pixels, level.size);
+            written += level.size;
+        }
+        out.close();
+        if (!out || std::rename(tmpPath.c_str(), cachePath.c_str()) != 0)
+        {
+            std::remove(tmpPath.c_str());
+            std::cout << "WARNING::TEXTURE_CACHE:: failed to write " << cachePath << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    // fills texture from the cache of sourcePath, baking and storing it first if the cache is missing or stale.
+    // sourceHash can be passed in when the caller already hashed the source. Returns false if the source image can't be loaded
+    inline bool Get(const std::string &sourcePath, TextureData &texture, const TextureCompression &settings = Compression(), uint64_t sourceHash = 0)
+    {
+        if (sourceHash == 0)
+            sourceHash = HashFile(sourcePath);
+        if (sourceHash == 0)
+            return false;
+        if (Load(sourcePath, sourceHash, settings, texture))
+            return true;
+        texture.file.Close();
+
+        ImageData image;
+        if (!image.Load(sourcePath))
+            return false;
+        Bake(image, texture);
+        Compress(texture, settings);
+        Store(sourcePath, sourceHash, settings, texture);
+        std::cout << "Baked " << sourcePath << ": " << Describe(texture) << std::endl;
+        return true;
+    }
+
+    inline bool isImagePath(const std::string &path)
+    {
+        static const char *extensions[] = {".png", ".jpg", ".jpeg", ".bmp", ".tga"};
+        for (const char *extension : extensions)
+        {
+            size_t length = strlen(extension);
+            if (path.size() > length && path.compare(path.size() - length, length, extension) == 0)
+                return true;
+        }
+        return false;
+    }
+
+    // offline baking: brings the cache of every image below directory up to date, returns the number of images.
+    // cubemap faces have to be baked with the same settings they are loaded with, so directories named
+    // skybox use cubemapSettings
+    inline unsigned int BakeDirectory(const std::string &directory, const TextureCompression &settings, const TextureCompression &cubemapSettings)
+    {
+        unsigned int baked = 0;
+        DIR *dir = opendir(directory.c_str());
+        if (!dir)
+            return 0;
+        while (dirent *entry = readdir(dir))
+        {
+            std::string name = entry->d_name;
+            if (name == "." || name == "..")
+                continue;
+            std::string path = directory + '/' + name;
+            struct stat st;
+            if (stat(path.c_str(), &st) != 0)
+                continue;
+            if (S_ISDIR(st.st_mode))
+                baked += BakeDirectory(path, name == "skybox" ? cubemapSettings : settings, cubemapSettings);
+            else if (isImagePath(path))
+            {
+                TextureData texture;
+                if (Get(path, texture, settings))
+                {
+                    if (texture.fromCache)
+                        std::cout << "Up to date " << path << ": " << Describe(texture) << std::endl;
+                    baked++;
+                }
+                else
+                    std::cout << "Texture failed to load at path: " << path << std::endl;
+            }
+        }
+        closedir(dir);
+        return baked;
+    }
+}
+
+// uploads every level of texture into the currently bound target (GL_TEXTURE_2D or a cubemap face), needs the GL context
+inline void UploadTextureLevels(GLenum target, const TextureData &texture, unsigned int levelCount)
+{
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (unsigned int i = 0; i < levelCount && i < texture.levels.size(); i++)
+    {
+        const TextureLevel &level = texture.levels[i];
+        if (texture.Compressed())
+            glCompressedTexImage2D(target, i, texture.internalFormat, level.width, level.height, 0, (GLsizei)level.size, level.pixels);
+        else
+            glTexImage2D(target, i, texture.internalFormat, level.width, level.height, 0, texture.format, texture.type, level.pixels);
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+// creates a mipmapped GL_TEXTURE_2D from texture, needs the GL context. Reports a texture without data and
+// returns an empty texture for it
+inline unsigned int TextureFromData(const TextureData &texture, const char *path, bool gamma = false)
+{
+    unsigned int textureID;
+    glGenTextures(1, &textureID);
+
+    if (texture.Valid())
+    {
+        GLState::Instance().BindTexture(0, GL_TEXTURE_2D, textureID);
+        UploadTextureLevels(GL_TEXTURE_2D, texture, texture.levels.size());
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)texture.levels.size() - 1);
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, texture.levels.size() > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+    else
+    {
+        std::cout << "Texture failed to load at path: " << path << std::endl;
+    }
+
+    return textureID;
+}
+#endif
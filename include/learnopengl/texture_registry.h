@@ -0,0 +1,291 @@
+#ifndef TEXTURE_REGISTRY_H
+#define TEXTURE_REGISTRY_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/filesystem.h>
+#include <learnopengl/gl_state.h>
+#include <learnopengl/texture_cache.h>
+#include <learnopengl/texture_uploader.h>
+
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+// identity of a texture file: its canonical path (see FileSystem::canonical) plus the hash of its contents, so the same image reached through
+// different relative paths is shared, while a file that changed on disk gets a texture of its own
+struct TextureKey
+{
+    std::string path;
+    uint64_t hash = 0;
+
+    // the file doesn't exist or can't be read, users get a default texture
+    bool Missing() const
+    {
+        return hash == 0;
+    }
+
+    bool operator<(const TextureKey &other) const
+    {
+        return path != other.path ? path < other.path : hash < other.hash;
+    }
+};
+
+// Process-wide registry of the textures used by models. Every texture is uploaded once and shared by all its users
+// through a reference count: Acquire hands out the texture and Release gives it back, the last Release deletes it.
+// Files that don't exist are remembered, so later loads neither touch the disk nor allocate textures for them; they
+// get one shared 1x1 default texture per sampler type instead.
+// Identify and Contains are safe on any thread, everything else needs the GL context.
+class TextureRegistry
+{
+public:
+    struct Stats
+    {
+        // Acquire calls served by a texture that was already there, and calls that had to create one
+        unsigned int hits = 0;
+        unsigned int misses = 0;
+        // Acquire calls for missing files, and lookups of files already known to be missing
+        unsigned int missing = 0;
+        unsigned int negativeHits = 0;
+        // texture memory created, and the memory the hits would have created without sharing
+        size_t bytesUploaded = 0;
+        size_t bytesSaved = 0;
+        // textures alive right now
+        unsigned int textures = 0;
+    };
+
+    static TextureRegistry& Instance()
+    {
+        static TextureRegistry registry;
+        return registry;
+    }
+
+    TextureRegistry(const TextureRegistry&) = delete;
+    TextureRegistry& operator=(const TextureRegistry&) = delete;
+
+    // canonical path and content hash of the file at path, a missing key if it doesn't exist
+    TextureKey Identify(const std::string &path)
+    {
+        TextureKey key;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (missingPaths.count(path))
+            {
+                stats.negativeHits++;
+                key.path = path;
+                return key;
+            }
+        }
+
+        key.path = FileSystem::canonical(path);
+        if (!key.path.empty())
+            key.hash = TextureCache::HashFile(key.path);
+        if (key.Missing())
+        {
+            std::cout << "Texture failed to load at path: " << path << ", using a default texture" << std::endl;
+            std::lock_guard<std::mutex> lock(mutex);
+            missingPaths.insert(path);
+            key.path = path;
+        }
+        return key;
+    }
+
+    // true if Acquire(key) won't need any texture data, so the caller can skip loading it
+    bool Contains(const TextureKey &key)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return key.Missing() || entries.count(key) != 0;
+    }
+
+    // returns the texture of key for a sampler of the given type, creating it from data if it's not there yet.
+    // with an uploader the data is streamed and the returned texture is a placeholder until onReady receives the
+    // real one; onReady is never called after Release(key, owner). Without data (and without a texture) the
+    // file is loaded right here.
+    unsigned int Acquire(const TextureKey &key, const std::string &type, std::shared_ptr<const TextureData> data,
+                         TextureUploader *uploader, const void *owner, std::function<void(unsigned int)> onReady)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (key.Missing())
+        {
+            stats.missing++;
+            return defaultTexture(type);
+        }
+
+        auto it = entries.find(key);
+        if (it != entries.end())
+        {
+            Entry &entry = it->second;
+            entry.refs++;
+            stats.hits++;
+            stats.bytesSaved += entry.bytes;
+            if (entry.ready)
+                return entry.id;
+            entry.listeners.push_back(std::make_pair(owner, onReady));
+            return TextureUploader::Placeholder();
+        }
+
+        if (!data || !data->Valid())
+        {
+            std::shared_ptr<TextureData> loaded = std::make_shared<TextureData>();
+            if (!TextureCache::Get(key.path, *loaded, TextureCache::Compression(), key.hash))
+            {
+                std::cout << "Texture failed to load at path: " << key.path << std::endl;
+                stats.missing++;
+                return defaultTexture(type);
+            }
+            data = loaded;
+        }
+
+        Entry &entry = entries[key];
+        entry.refs = 1;
+        entry.bytes = data->Size();
+        stats.misses++;
+        stats.bytesUploaded += entry.bytes;
+        stats.textures++;
+        if (uploader)
+        {
+            entry.listeners.push_back(std::make_pair(owner, onReady));
+            entry.upload = ++uploads;
+            uint64_t upload = entry.upload;
+            uploader->Upload(data, [this, key, upload](unsigned int textureID) { uploaded(key, upload, textureID); });
+            return TextureUploader::Placeholder();
+        }
+        entry.id = TextureFromData(*data, key.path.c_str());
+        entry.ready = true;
+        return entry.id;
+    }
+
+    // gives back one reference to the texture of key taken by owner, deleting the texture with the last one
+    void Release(const TextureKey &key, const void *owner)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(key);
+        if (key.Missing() || it == entries.end())
+            return;
+        Entry &entry = it->second;
+        for (size_t i = 0; i < entry.listeners.size();)
+        {
+            if (entry.listeners[i].first == owner)
+                entry.listeners.erase(entry.listeners.begin() + i);
+            else
+                i++;
+        }
+        if (--entry.refs > 0)
+            return;
+        // a texture that is still streaming is deleted by uploaded() once its upload completes, it no longer finds
+        // its upload in entries even if key was acquired again meanwhile
+        if (entry.ready)
+        {
+            GLState::Instance().ForgetTexture(entry.id);
+            glDeleteTextures(1, &entry.id);
+        }
+        entries.erase(it);
+        stats.textures--;
+    }
+
+    // texture memory of key, 0 for missing files and textures nobody holds
+    size_t Bytes(const TextureKey &key)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(key);
+        return it == entries.end() ? 0 : it->second.bytes;
+    }
+
+    Stats GetStats()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return stats;
+    }
+
+    void PrintStats()
+    {
+        Stats current = GetStats();
+        std::cout << "Textures: " << current.textures << " shared, " << current.hits << " hits, " << current.misses << " misses, "
+                  << current.missing << " missing (" << current.negativeHits << " known), "
+                  << current.bytesUploaded / (1024.0 * 1024.0) << " MB uploaded, " << current.bytesSaved / (1024.0 * 1024.0) << " MB saved" << std::endl;
+    }
+
+private:
+    struct Entry
+    {
+        unsigned int id = 0;
+        int refs = 0;
+        bool ready = false;
+        // the upload that streams this entry's texture, 0 for textures created in place
+        uint64_t upload = 0;
+        size_t bytes = 0;
+        // users waiting for a streamed texture
+        std::vector<std::pair<const void*, std::function<void(unsigned int)>>> listeners;
+    };
+
+    std::mutex mutex;
+    std::map<TextureKey, Entry> entries;
+    std::unordered_set<std::string> missingPaths;
+    std::unordered_map<std::string, unsigned int> defaults;
+    Stats stats;
+    // uploads started, numbers the streamed entries
+    uint64_t uploads = 0;
+
+    TextureRegistry() = default;
+
+    void uploaded(const TextureKey &key, uint64_t upload, unsigned int textureID)
+    {
+        std::vector<std::pair<const void*, std::function<void(unsigned int)>>> listeners;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = entries.find(key);
+            if (it == entries.end() || it->second.upload != upload)
+            {
+                // released by every user while it was streaming, an entry under key now is a later acquire with an
+                // upload of its own
+                GLState::Instance().ForgetTexture(textureID);
+                glDeleteTextures(1, &textureID);
+                return;
+            }
+            it->second.id = textureID;
+            it->second.ready = true;
+            listeners.swap(it->second.listeners);
+        }
+        // outside the lock, the listeners may acquire other textures
+        for (auto &listener : listeners)
+        {
+            if (listener.second)
+                listener.second(textureID);
+        }
+    }
+
+    // 1x1 stand-in for a missing file that leaves the shading neutral: white diffuse, no specular,
+    // a flat tangent space normal, no height
+    unsigned int defaultTexture(const std::string &type)
+    {
+        auto it = defaults.find(type);
+        if (it != defaults.end())
+            return it->second;
+
+        unsigned char pixel[4] = {255, 255, 255, 255};
+        if (type == "texture_specular" || type == "texture_height")
+            pixel[0] = pixel[1] = pixel[2] = 0;
+        else if (type == "texture_normal")
+            pixel[0] = pixel[1] = 128;
+
+        unsigned int textureID;
+        glGenTextures(1, &textureID);
+        GLState::Instance().BindTexture(0, GL_TEXTURE_2D, textureID);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixel);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        defaults[type] = textureID;
+        return textureID;
+    }
+};
+#endif
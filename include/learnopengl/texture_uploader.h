@@ -0,0 +1,248 @@
+#ifndef TEXTURE_UPLOADER_H
+#define TEXTURE_UPLOADER_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/gl_state.h>
+#include <learnopengl/texture_cache.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// Streams textures (every level of a TextureData) into GL through a ring of pixel buffer objects, so big
+// textures never stall a frame. Every frame Process copies as many rows as fit into its time budget into the
+// next free PBO and issues an asynchronous glTexSubImage2D from it; a fence per PBO tells when it can be reused.
+// Until an upload completes, users draw with Placeholder(), a 1x1 white texture, and get the real texture
+// through the onReady callback. All calls need the GL context.
+class TextureUploader
+{
+public:
+    // maximum CPU time per frame spent on texture transfer
+    double frameBudgetMilliseconds = 2.0;
+
+    explicit TextureUploader(unsigned int slotCount = 4, size_t slotSize = 1 << 20) : slotSize(slotSize)
+    {
+        slots.resize(slotCount);
+    }
+
+    ~TextureUploader()
+    {
+        for (Slot &slot : slots)
+        {
+            if (slot.fence)
+                glDeleteSync(slot.fence);
+            if (slot.pbo)
+                glDeleteBuffers(1, &slot.pbo);
+        }
+    }
+
+    TextureUploader(const TextureUploader&) = delete;
+    TextureUploader& operator=(const TextureUploader&) = delete;
+
+    // queues every level of texture for upload. onReady receives the new texture once all rows of all levels are on the GPU
+    void Upload(std::shared_ptr<const TextureData> texture, std::function<void(unsigned int)> onReady)
+    {
+        Job job;
+        job.texture = texture;
+        job.onReady = onReady;
+        jobs.push_back(job);
+    }
+
+    // transfers rows until the frame budget is used up or the next PBO is still in use by the GPU
+    void Process()
+    {
+        if (jobs.empty())
+            return;
+        if (slots[0].pbo == 0)
+            createSlots();
+
+        auto start = std::chrono::steady_clock::now();
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        while (!jobs.empty())
+        {
+            Slot &slot = slots[nextSlot];
+            if (slot.fence)
+            {
+                // never wait, if the GPU hasn't consumed this PBO yet continue next frame
+                GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+                if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+                    break;
+                glDeleteSync(slot.fence);
+                slot.fence = nullptr;
+            }
+
+            Job &job = jobs.front();
+            if (job.textureID == 0)
+                beginJob(job);
+
+            // rows are counted in groups, single pixel rows or rows of 4x4 blocks for compressed textures
+            const TextureData &texture = *job.texture;
+            const TextureLevel &level = texture.levels[job.level];
+            int groupHeight = texture.RowGroupHeight();
+            int groupCount = (level.height + groupHeight - 1) / groupHeight;
+            size_t groupSize = texture.RowGroupSize(level);
+            int groups = (int)(slotSize / groupSize);
+            if (groups < 1)
+                groups = 1;
+            if (groups > groupCount - job.nextRow)
+                groups = groupCount - job.nextRow;
+            size_t chunkSize = groupSize * groups;
+            const unsigned char *source = level.pixels + groupSize * job.nextRow;
+            int y = job.nextRow * groupHeight;
+            int rows = std::min(groups * groupHeight, level.height - y);
+
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.pbo);
+            if (chunkSize > slot.capacity)
+            {
+                glBufferData(GL_PIXEL_UNPACK_BUFFER, chunkSize, nullptr, GL_STREAM_DRAW);
+                slot.capacity = chunkSize;
+            }
+            // the fence above guarantees the GPU is done with the buffer, so the map doesn't need to synchronize
+            void *mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, chunkSize,
+                                            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+            if (mapped)
+            {
+                memcpy(mapped, source, chunkSize);
+                glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+                uploadRows(job, level, y, rows, chunkSize, (void*)0);
+                slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            }
+            else
+            {
+                // the buffer can't be mapped, upload this chunk directly
+                glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+                uploadRows(job, level, y, rows, chunkSize, source);
+            }
+            nextSlot = (nextSlot + 1) % slots.size();
+            bytesUploaded += chunkSize;
+
+            job.nextRow += groups;
+            if (job.nextRow == groupCount)
+            {
+                job.nextRow = 0;
+                job.level++;
+            }
+            if (job.level == job.texture->levels.size())
+            {
+                finishJob(job);
+                jobs.pop_front();
+            }
+
+            double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            if (elapsed >= frameBudgetMilliseconds)
+                break;
+        }
+        // later glTexImage2D calls would otherwise read from the bound PBO
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    }
+
+    bool Idle() const
+    {
+        return jobs.empty();
+    }
+
+    size_t BytesUploaded() const
+    {
+        return bytesUploaded;
+    }
+
+    // 1x1 white texture to draw with while the real one is streaming in
+    static unsigned int Placeholder()
+    {
+        static unsigned int placeholder = 0;
+        if (placeholder == 0)
+        {
+            const unsigned char white[4] = {255, 255, 255, 255};
+            glGenTextures(1, &placeholder);
+            GLState::Instance().BindTexture(0, GL_TEXTURE_2D, placeholder);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        }
+        return placeholder;
+    }
+
+private:
+    struct Slot
+    {
+        unsigned int pbo = 0;
+        size_t capacity = 0;
+        GLsync fence = nullptr;
+    };
+
+    struct Job
+    {
+        std::shared_ptr<const TextureData> texture;
+        std::function<void(unsigned int)> onReady;
+        unsigned int textureID = 0;
+        size_t level = 0;
+        int nextRow = 0;
+    };
+
+    std::vector<Slot> slots;
+    size_t slotSize;
+    unsigned int nextSlot = 0;
+    std::deque<Job> jobs;
+    size_t bytesUploaded = 0;
+
+    void createSlots()
+    {
+        for (Slot &slot : slots)
+        {
+            glGenBuffers(1, &slot.pbo);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.pbo);
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, slotSize, nullptr, GL_STREAM_DRAW);
+            slot.capacity = slotSize;
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+
+    // allocates the storage of every level, the rows are filled in chunk by chunk
+    void beginJob(Job &job)
+    {
+        const TextureData &texture = *job.texture;
+        glGenTextures(1, &job.textureID);
+        GLState::Instance().BindTexture(0, GL_TEXTURE_2D, job.textureID);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        for (size_t i = 0; i < texture.levels.size(); i++)
+        {
+            const TextureLevel &level = texture.levels[i];
+            if (texture.Compressed())
+                glCompressedTexImage2D(GL_TEXTURE_2D, (GLint)i, texture.internalFormat, level.width, level.height, 0, (GLsizei)level.size, nullptr);
+            else
+                glTexImage2D(GL_TEXTURE_2D, (GLint)i, texture.internalFormat, level.width, level.height, 0, texture.format, texture.type, nullptr);
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)texture.levels.size() - 1);
+    }
+
+    // rows [y, y + rows) of the current level from pixels, an offset into the bound PBO or a client pointer
+    void uploadRows(const Job &job, const TextureLevel &level, int y, int rows, size_t size, const void *pixels)
+    {
+        const TextureData &texture = *job.texture;
+        GLState::Instance().BindTexture(0, GL_TEXTURE_2D, job.textureID);
+        if (texture.Compressed())
+            glCompressedTexSubImage2D(GL_TEXTURE_2D, (GLint)job.level, 0, y, level.width, rows, texture.internalFormat, (GLsizei)size, pixels);
+        else
+            glTexSubImage2D(GL_TEXTURE_2D, (GLint)job.level, 0, y, level.width, rows, texture.format, texture.type, pixels);
+    }
+
+    void finishJob(Job &job)
+    {
+        bool mipmapped = job.texture->levels.size() > 1;
+        GLState::Instance().BindTexture(0, GL_TEXTURE_2D, job.textureID);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, mipmapped ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        if (job.onReady)
+            job.onReady(job.textureID);
+        job.texture.reset();
+    }
+};
+#endif
@@ -0,0 +1,271 @@
+#ifndef UNIFORM_BLOCKS_H
+#define UNIFORM_BLOCKS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <learnopengl/frame_ring_buffer.h>
+#include <learnopengl/gl_object.h>
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+// Uniform blocks shared by all programs. Every program that declares one of these blocks gets it bound to the
+// block's fixed binding point when it is linked (see Shader), so each buffer is bound once for the whole frame.
+// The structs below are the std140 layouts of the GLSL declarations quoted above them; the static_asserts keep
+// the C++ side honest, Shader checks the driver's layout of every block against Members() when it links.
+namespace UniformBlocks
+{
+    const GLuint CAMERA_BINDING = 0;
+    const GLuint LIGHTS_BINDING = 1;
+
+    // layout (std140) uniform Camera {
+    //     mat4 projection;
+    //     mat4 view;
+    //     mat4 skyboxView;     // view without the translation
+    //     vec4 viewPosition;   // xyz
+    // };
+    struct Camera
+    {
+        glm::mat4 projection;
+        glm::mat4 view;
+        glm::mat4 skyboxView;
+        glm::vec4 viewPosition;
+    };
+    static_assert(offsetof(Camera, projection) == 0, "Camera.projection");
+    static_assert(offsetof(Camera, view) == 64, "Camera.view");
+    static_assert(offsetof(Camera, skyboxView) == 128, "Camera.skyboxView");
+    static_assert(offsetof(Camera, viewPosition) == 192, "Camera.viewPosition");
+    static_assert(sizeof(Camera) == 208, "Camera size");
+
+    // struct DirectionalLight {
+    //     vec3 direction;
+    //     vec3 specular;
+    //     vec3 diffuse;
+    //     vec3 ambient;
+    // };
+    struct DirectionalLight
+    {
+        glm::vec3 direction;
+        float padding0;
+        glm::vec3 specular;
+        float padding1;
+        glm::vec3 diffuse;
+        float padding2;
+        glm::vec3 ambient;
+        float padding3;
+    };
+    static_assert(offsetof(DirectionalLight, specular) == 16, "DirectionalLight.specular");
+    static_assert(offsetof(DirectionalLight, diffuse) == 32, "DirectionalLight.diffuse");
+    static_assert(offsetof(DirectionalLight, ambient) == 48, "DirectionalLight.ambient");
+    static_assert(sizeof(DirectionalLight) == 64, "DirectionalLight size");
+
+    // struct SpotLight {
+    //     vec3 position;
+    //     vec3 direction;
+    //     float cutOff;        // packed into the padding of direction
+    //     float outerCutOff;
+    //     vec3 specular;
+    //     vec3 diffuse;
+    //     vec3 ambient;
+    //     float constant;      // packed into the padding of ambient
+    //     float linear;
+    //     float quadratic;
+    // };
+    struct SpotLight
+    {
+        glm::vec3 position;
+        float padding0;
+        glm::vec3 direction;
+        float cutOff;
+        float outerCutOff;
+        float padding1[3];
+        glm::vec3 specular;
+        float padding2;
+        glm::vec3 diffuse;
+        float padding3;
+        glm::vec3 ambient;
+        float constant;
+        float linear;
+        float quadratic;
+        float padding4[2];
+    };
+    static_assert(offsetof(SpotLight, direction) == 16, "SpotLight.direction");
+    static_assert(offsetof(SpotLight, cutOff) == 28, "SpotLight.cutOff");
+    static_assert(offsetof(SpotLight, outerCutOff) == 32, "SpotLight.outerCutOff");
+    static_assert(offsetof(SpotLight, specular) == 48, "SpotLight.specular");
+    static_assert(offsetof(SpotLight, diffuse) == 64, "SpotLight.diffuse");
+    static_assert(offsetof(SpotLight, ambient) == 80, "SpotLight.ambient");
+    static_assert(offsetof(SpotLight, constant) == 92, "SpotLight.constant");
+    static_assert(offsetof(SpotLight, linear) == 96, "SpotLight.linear");
+    static_assert(offsetof(SpotLight, quadratic) == 100, "SpotLight.quadratic");
+    static_assert(sizeof(SpotLight) == 112, "SpotLight size");
+
+    // layout (std140) uniform Lights {
+    //     DirectionalLight directionalLight;
+    //     SpotLight sunLight;
+    //     SpotLight moonLight;
+    // };
+    struct Lights
+    {
+        DirectionalLight directionalLight;
+        SpotLight sunLight;
+        SpotLight moonLight;
+    };
+    static_assert(offsetof(Lights, sunLight) == 64, "Lights.sunLight");
+    static_assert(offsetof(Lights, moonLight) == 176, "Lights.moonLight");
+    static_assert(sizeof(Lights) == 288, "Lights size");
+
+    struct Member
+    {
+        const char *name;
+        size_t offset;
+    };
+
+    // binding point of the block called name, -1 for blocks that aren't shared
+    inline GLint Binding(const std::string &name)
+    {
+        if (name == "Camera")
+            return CAMERA_BINDING;
+        if (name == "Lights")
+            return LIGHTS_BINDING;
+        return -1;
+    }
+
+    inline size_t Size(const std::string &name)
+    {
+        return name == "Camera" ? sizeof(Camera) : name == "Lights" ? sizeof(Lights) : 0;
+    }
+
+    // members of the block called name with their offsets on the C++ side, terminated by a null name
+    inline const Member* Members(const std::string &name)
+    {
+        static const Member camera[] = {
+            {"projection", offsetof(Camera, projection)}, {"view", offsetof(Camera, view)},
+            {"skyboxView", offsetof(Camera, skyboxView)}, {"viewPosition", offsetof(Camera, viewPosition)}, {nullptr, 0}
+        };
+        static const Member lights[] = {
+            {"directionalLight.direction", offsetof(Lights, directionalLight) + offsetof(DirectionalLight, direction)},
+            {"directionalLight.specular", offsetof(Lights, directionalLight) + offsetof(DirectionalLight, specular)},
+            {"directionalLight.diffuse", offsetof(Lights, directionalLight) + offsetof(DirectionalLight, diffuse)},
+            {"directionalLight.ambient", offsetof(Lights, directionalLight) + offsetof(DirectionalLight, ambient)},
+            {"sunLight.position", offsetof(Lights, sunLight) + offsetof(SpotLight, position)},
+            {"sunLight.direction", offsetof(Lights, sunLight) + offsetof(SpotLight, direction)},
+            {"sunLight.cutOff", offsetof(Lights, sunLight) + offsetof(SpotLight, cutOff)},
+            {"sunLight.outerCutOff", offsetof(Lights, sunLight) + offsetof(SpotLight, outerCutOff)},
+            {"sunLight.specular", offsetof(Lights, sunLight) + offsetof(SpotLight, specular)},
+            {"sunLight.diffuse", offsetof(Lights, sunLight) + offsetof(SpotLight, diffuse)},
+            {"sunLight.ambient", offsetof(Lights, sunLight) + offsetof(SpotLight, ambient)},
+            {"sunLight.constant", offsetof(Lights, sunLight) + offsetof(SpotLight, constant)},
+            {"sunLight.linear", offsetof(Lights, sunLight) + offsetof(SpotLight, linear)},
+            {"sunLight.quadratic", offsetof(Lights, sunLight) + offsetof(SpotLight, quadratic)},
+            {"moonLight.position", offsetof(Lights, moonLight) + offsetof(SpotLight, position)},
+            {"moonLight.direction", offsetof(Lights, moonLight) + offsetof(SpotLight, direction)},
+            {"moonLight.cutOff", offsetof(Lights, moonLight) + offsetof(SpotLight, cutOff)},
+            {"moonLight.outerCutOff", offsetof(Lights, moonLight) + offsetof(SpotLight, outerCutOff)},
+            {"moonLight.specular", offsetof(Lights, moonLight) + offsetof(SpotLight, specular)},
+            {"moonLight.diffuse", offsetof(Lights, moonLight) + offsetof(SpotLight, diffuse)},
+            {"moonLight.ambient", offsetof(Lights, moonLight) + offsetof(SpotLight, ambient)},
+            {"moonLight.constant", offsetof(Lights, moonLight) + offsetof(SpotLight, constant)},
+            {"moonLight.linear", offsetof(Lights, moonLight) + offsetof(SpotLight, linear)},
+            {"moonLight.quadratic", offsetof(Lights, moonLight) + offsetof(SpotLight, quadratic)},
+            {nullptr, 0}
+        };
+        return name == "Camera" ? camera : name == "Lights" ? lights : nullptr;
+    }
+}
+
+// uniform buffer holding one Block, bound to its binding point for good. Update uploads only the bytes that differ
+// from what the buffer already holds, and nothing at all when the block didn't change. Updated through a
+// FrameRingBuffer a block that changed is written into the frame's range of the ring instead, which is bound in its
+// place; an unchanged one goes back to the own buffer, since the range it was written to gets reused
+template <typename Block>
+class UniformBuffer
+{
+public:
+    struct Stats
+    {
+        unsigned int updates = 0;
+        unsigned int uploads = 0;
+        size_t bytes = 0;
+    };
+
+    explicit UniformBuffer(GLuint binding) : buffer(GLBuffer::Create()), binding(binding)
+    {
+        memset((void*)&shadow, 0, sizeof(shadow));
+        memset((void*)&written, 0, sizeof(written));
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer.Get());
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(Block), &shadow, GL_DYNAMIC_DRAW);
+        glBindBufferBase(GL_UNIFORM_BUFFER, binding, buffer.Get());
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    // block has to be zero initialized, padding included, or every update looks like a change
+    void Update(const Block &block)
+    {
+        if (ringBound)
+        {
+            glBindBufferBase(GL_UNIFORM_BUFFER, binding, buffer.Get());
+            ringBound = false;
+        }
+        stats.updates++;
+        memcpy((void*)&written, &block, sizeof(Block));
+        const unsigned char *next = (const unsigned char*)&block;
+        const unsigned char *current = (const unsigned char*)&shadow;
+        size_t first = 0, last = sizeof(Block);
+        while (first < sizeof(Block) && next[first] == current[first])
+            first++;
+        if (first == sizeof(Block))
+            return;
+        while (last > first && next[last - 1] == current[last - 1])
+            last--;
+        memcpy((unsigned char*)&shadow + first, next + first, last - first);
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer.Get());
+        glBufferSubData(GL_UNIFORM_BUFFER, first, last - first, next + first);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        stats.uploads++;
+        stats.bytes += last - first;
+    }
+
+    // writes the whole block into this frame's section of ring and binds that range, without touching a buffer
+    // the GPU may still be reading. A block equal to the last one written, and one the full ring has no room for,
+    // go through Update(block) instead: an unchanged block is uploaded at most once more and then not at all
+    void Update(const Block &block, FrameRingBuffer &ring)
+    {
+        if (memcmp(&block, &written, sizeof(Block)) == 0)
+        {
+            Update(block);
+            return;
+        }
+        FrameRingBuffer::Range range = ring.Write(&block, sizeof(Block), FrameRingBuffer::UniformAlignment());
+        if (!range)
+        {
+            Update(block);
+            return;
+        }
+        // the shadow stays what the own buffer holds, it catches up on the next update without the ring
+        glBindBufferRange(GL_UNIFORM_BUFFER, binding, range.buffer, range.offset, range.size);
+        ringBound = true;
+        memcpy((void*)&written, &block, sizeof(Block));
+        stats.updates++;
+        stats.uploads++;
+        stats.bytes += sizeof(Block);
+    }
+
+    const Stats& GetStats() const
+    {
+        return stats;
+    }
+
+private:
+    GLBuffer buffer;
+    GLuint binding;
+    // the binding point holds a range of a ring rather than buffer
+    bool ringBound = false;
+    // what buffer holds, and the block last written to either buffer or the ring
+    Block shadow;
+    Block written;
+    Stats stats;
+};
+#endif
@@ -0,0 +1,350 @@
+#ifndef VERTEX_FORMAT_H
+#define VERTEX_FORMAT_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+struct Vertex {
+    // position
+    glm::vec3 Position;
+    // normal
+    glm::vec3 Normal;
+    // texCoords
+    glm::vec2 TexCoords;
+    // tangent
+    glm::vec3 Tangent;
+    // bitangent
+    glm::vec3 Bitangent;
+};
+
+// GPU side layouts of a Vertex, selectable per model:
+//   Full        56 bytes  the Vertex struct as is
+//   Packed      20 bytes  float3 position, tangent frame quaternion (uint32), half2 texture coordinates
+//   PackedHalf  16 bytes  half4 position, tangent frame quaternion (uint32), half2 texture coordinates
+// The tangent frame quaternion rotates (1,0,0), (0,1,0), (0,0,1) onto tangent, bitangent and normal, so it replaces all
+// three vectors. It is stored "smallest three": the largest component is dropped (it follows from the others) and the
+// other three are quantized to 10, 10 and 9 bits, plus 2 bits for the index of the dropped one and 1 bit for the
+// handedness of the bitangent. Shaders decode it with decodeTangentFrame (see flat_earth.vs).
+enum class VertexFormat { Full, Packed, PackedHalf };
+
+namespace VertexPacking
+{
+    // attribute location of the packed tangent frame, the Full format uses 1, 3 and 4 instead
+    const GLuint TANGENT_FRAME_LOCATION = 5;
+
+    inline size_t Stride(VertexFormat format)
+    {
+        if (format == VertexFormat::Packed)
+            return 20;
+        if (format == VertexFormat::PackedHalf)
+            return 16;
+        return sizeof(Vertex);
+    }
+
+    inline const char* Name(VertexFormat format)
+    {
+        if (format == VertexFormat::Packed)
+            return "packed";
+        if (format == VertexFormat::PackedHalf)
+            return "packed half";
+        return "full";
+    }
+
+    // IEEE half precision, rounded to nearest even. Values beyond the half range become infinity
+    inline uint16_t FloatToHalf(float value)
+    {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        uint32_t sign = (bits >> 16) & 0x8000u;
+        uint32_t magnitude = bits & 0x7FFFFFFFu;
+        if (magnitude >= 0x7F800000u)  // inf or nan
+            return (uint16_t)(sign | 0x7C00u | (magnitude > 0x7F800000u ? 0x200u : 0u));
+        if (magnitude >= 0x477FF000u)  // rounds to beyond 65504
+            return (uint16_t)(sign | 0x7C00u);
+        if (magnitude < 0x38800000u)   // half denormal or zero
+        {
+            if (magnitude < 0x33000000u)
+                return (uint16_t)sign;
+            uint32_t mantissa = (magnitude & 0x7FFFFFu) | 0x800000u;
+            int shift = 126 - (int)(magnitude >> 23);
+            uint32_t half = mantissa >> shift;
+            uint32_t rest = mantissa & ((1u << shift) - 1);
+            uint32_t halfway = 1u << (shift - 1);
+            if (rest > halfway || (rest == halfway && (half & 1u)))
+                half++;
+            return (uint16_t)(sign | half);
+        }
+        uint32_t half = ((magnitude - 0x38000000u) >> 13);
+        uint32_t rest = magnitude & 0x1FFFu;
+        if (rest > 0x1000u || (rest == 0x1000u && (half & 1u)))
+            half++;
+        return (uint16_t)(sign | half);
+    }
+
+    inline float HalfToFloat(uint16_t half)
+    {
+        uint32_t sign = (uint32_t)(half & 0x8000u) << 16;
+        uint32_t exponent = (half >> 10) & 0x1Fu;
+        uint32_t mantissa = half & 0x3FFu;
+        uint32_t bits;
+        if (exponent == 0)
+        {
+            float value = std::ldexp((float)mantissa, -24);
+            return sign ? -value : value;
+        }
+        if (exponent == 31)
+            bits = sign | 0x7F800000u | (mantissa << 13);
+        else
+            bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+        float value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    struct Quaternion
+    {
+        float x, y, z, w;
+    };
+
+    // quaternion of the rotation whose matrix has the columns t, b, n (orthonormal, right handed)
+    inline Quaternion fromBasis(const glm::vec3 &t, const glm::vec3 &b, const glm::vec3 &n)
+    {
+        Quaternion q;
+        float trace = t.x + b.y + n.z;
+        if (trace > 0.0f)
+        {
+            float s = std::sqrt(trace + 1.0f) * 2.0f;
+            q.w = 0.25f * s;
+            q.x = (b.z - n.y) / s;
+            q.y = (n.x - t.z) / s;
+            q.z = (t.y - b.x) / s;
+        }
+        else if (t.x > b.y && t.x > n.z)
+        {
+            float s = std::sqrt(1.0f + t.x - b.y - n.z) * 2.0f;
+            q.w = (b.z - n.y) / s;
+            q.x = 0.25f * s;
+            q.y = (b.x + t.y) / s;
+            q.z = (n.x + t.z) / s;
+        }
+        else if (b.y > n.z)
+        {
+            float s = std::sqrt(1.0f + b.y - t.x - n.z) * 2.0f;
+            q.w = (n.x - t.z) / s;
+            q.x = (b.x + t.y) / s;
+            q.y = 0.25f * s;
+            q.z = (n.y + b.z) / s;
+        }
+        else
+        {
+            float s = std::sqrt(1.0f + n.z - t.x - b.y) * 2.0f;
+            q.w = (t.y - b.x) / s;
+            q.x = (n.x + t.z) / s;
+            q.y = (n.y + b.z) / s;
+            q.z = 0.25f * s;
+        }
+        float length = std::sqrt(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+        q.x /= length; q.y /= length; q.z /= length; q.w /= length;
+        return q;
+    }
+
+    inline glm::vec3 rotate(const Quaternion &q, const glm::vec3 &v)
+    {
+        glm::vec3 u(q.x, q.y, q.z);
+        return v + 2.0f * glm::cross(u, glm::cross(u, v) + q.w * v);
+    }
+
+    const float SQRT_HALF = 0.70710678f;
+
+    inline uint32_t quantize(float value, unsigned int bits)
+    {
+        float range = (float)((1u << bits) - 1);
+        float normalized = std::max(0.0f, std::min(1.0f, (value / SQRT_HALF) * 0.5f + 0.5f));
+        return (uint32_t)std::lround(normalized * range);
+    }
+
+    inline float dequantize(uint32_t value, unsigned int bits)
+    {
+        float range = (float)((1u << bits) - 1);
+        return (value / range * 2.0f - 1.0f) * SQRT_HALF;
+    }
+
+    // the frame of normal, tangent and bitangent as one uint32 (see the layout above). The tangent is made orthogonal
+    // to the normal first, a missing tangent is replaced by any vector orthogonal to the normal
+    inline uint32_t PackTangentFrame(const glm::vec3 &normal, const glm::vec3 &tangent, const glm::vec3 &bitangent)
+    {
+        glm::vec3 n = glm::length(normal) > 0.0f ? glm::normalize(normal) : glm::vec3(0.0f, 0.0f, 1.0f);
+        glm::vec3 t = tangent - n * glm::dot(n, tangent);
+        if (glm::length(t) < 1e-6f)
+            t = std::fabs(n.x) < 0.9f ? glm::cross(n, glm::vec3(1.0f, 0.0f, 0.0f)) : glm::cross(n, glm::vec3(0.0f, 1.0f, 0.0f));
+        t = glm::normalize(t);
+        glm::vec3 b = glm::cross(n, t);
+        uint32_t reflected = glm::dot(b, bitangent) < 0.0f ? 1u : 0u;
+
+        Quaternion q = fromBasis(t, b, n);
+        float components[4] = {q.x, q.y, q.z, q.w};
+        uint32_t largest = 0;
+        for (uint32_t i = 1; i < 4; i++)
+        {
+            if (std::fabs(components[i]) > std::fabs(components[largest]))
+                largest = i;
+        }
+        // q and -q are the same rotation, make the dropped component positive
+        float sign = components[largest] < 0.0f ? -1.0f : 1.0f;
+        float rest[3];
+        for (uint32_t i = 0, j = 0; i < 4; i++)
+        {
+            if (i != largest)
+                rest[j++] = components[i] * sign;
+        }
+        return quantize(rest[0], 10) | (quantize(rest[1], 10) << 10) | (quantize(rest[2], 9) << 20) | (largest << 29) | (reflected << 31);
+    }
+
+    // CPU version of decodeTangentFrame in the shaders
+    inline void UnpackTangentFrame(uint32_t packed, glm::vec3 &normal, glm::vec3 &tangent, glm::vec3 &bitangent)
+    {
+        float rest[3] = {dequantize(packed & 0x3FFu, 10), dequantize((packed >> 10) & 0x3FFu, 10), dequantize((packed >> 20) & 0x1FFu, 9)};
+        uint32_t largest = (packed >> 29) & 3u;
+        float components[4];
+        float sum = 0.0f;
+        for (uint32_t i = 0, j = 0; i < 4; i++)
+        {
+            if (i != largest)
+            {
+                components[i] = rest[j++];
+                sum += components[i] * components[i];
+            }
+        }
+        components[largest] = std::sqrt(std::max(0.0f, 1.0f - sum));
+        Quaternion q = {components[0], components[1], components[2], components[3]};
+        tangent = rotate(q, glm::vec3(1.0f, 0.0f, 0.0f));
+        bitangent = rotate(q, glm::vec3(0.0f, 1.0f, 0.0f)) * ((packed >> 31) ? -1.0f : 1.0f);
+        normal = rotate(q, glm::vec3(0.0f, 0.0f, 1.0f));
+    }
+
+    // largest differences between the original vertices and what the shaders decode
+    struct PackingError
+    {
+        float position = 0.0f;
+        // position error relative to the largest extent of the mesh
+        float relativePosition = 0.0f;
+        // in degrees
+        float normal = 0.0f;
+        float tangent = 0.0f;
+        float texCoords = 0.0f;
+    };
+
+    inline float angleDegrees(const glm::vec3 &a, const glm::vec3 &b)
+    {
+        float lengths = glm::length(a) * glm::length(b);
+        if (lengths == 0.0f)
+            return 0.0f;
+        return std::acos(std::max(-1.0f, std::min(1.0f, glm::dot(a, b) / lengths))) * 57.2957795f;
+    }
+
+    // writes vertices in format to out (Stride(format) bytes each), measuring the error into error if given
+    inline void Pack(const std::vector<Vertex> &vertices, VertexFormat format, std::vector<unsigned char> &out, PackingError *error = nullptr)
+    {
+        size_t stride = Stride(format);
+        out.resize(vertices.size() * stride);
+        if (format == VertexFormat::Full)
+        {
+            if (!vertices.empty())
+                memcpy(out.data(), vertices.data(), out.size());
+            if (error)
+                *error = PackingError();
+            return;
+        }
+
+        glm::vec3 boundsMin(0.0f), boundsMax(0.0f);
+        if (!vertices.empty())
+            boundsMin = boundsMax = vertices[0].Position;
+        PackingError measured;
+        for (size_t i = 0; i < vertices.size(); i++)
+        {
+            const Vertex &vertex = vertices[i];
+            unsigned char *dst = out.data() + i * stride;
+            glm::vec3 position = vertex.Position;
+            if (format == VertexFormat::Packed)
+            {
+                memcpy(dst, &vertex.Position, 12);
+                dst += 12;
+            }
+            else
+            {
+                uint16_t half[4] = {FloatToHalf(position.x), FloatToHalf(position.y), FloatToHalf(position.z), FloatToHalf(1.0f)};
+                memcpy(dst, half, 8);
+                dst += 8;
+                position = glm::vec3(HalfToFloat(half[0]), HalfToFloat(half[1]), HalfToFloat(half[2]));
+            }
+            uint32_t frame = PackTangentFrame(vertex.Normal, vertex.Tangent, vertex.Bitangent);
+            memcpy(dst, &frame, 4);
+            uint16_t texCoords[2] = {FloatToHalf(vertex.TexCoords.x), FloatToHalf(vertex.TexCoords.y)};
+            memcpy(dst + 4, texCoords, 4);
+
+            glm::vec3 normal, tangent, bitangent;
+            UnpackTangentFrame(frame, normal, tangent, bitangent);
+            measured.position = std::max(measured.position, glm::length(position - vertex.Position));
+            measured.normal = std::max(measured.normal, angleDegrees(normal, vertex.Normal));
+            if (glm::length(vertex.Tangent) > 0.0f)
+                measured.tangent = std::max(measured.tangent, angleDegrees(tangent, vertex.Tangent));
+            measured.texCoords = std::max(measured.texCoords, std::max(std::fabs(HalfToFloat(texCoords[0]) - vertex.TexCoords.x),
+                                                                       std::fabs(HalfToFloat(texCoords[1]) - vertex.TexCoords.y)));
+            boundsMin = glm::min(boundsMin, vertex.Position);
+            boundsMax = glm::max(boundsMax, vertex.Position);
+        }
+        glm::vec3 extent = boundsMax - boundsMin;
+        float largestExtent = std::max(extent.x, std::max(extent.y, extent.z));
+        measured.relativePosition = largestExtent > 0.0f ? measured.position / largestExtent : 0.0f;
+        if (error)
+            *error = measured;
+    }
+
+    // sets up the attribute pointers of format for the bound VAO and vertex buffer. Positions and texture coordinates
+    // keep their locations (0 and 2) in every format, half floats are converted by the vertex fetch
+    inline void SetupAttributes(VertexFormat format)
+    {
+        for (GLuint location = 0; location <= TANGENT_FRAME_LOCATION; location++)
+            glDisableVertexAttribArray(location);
+        if (format == VertexFormat::Full)
+        {
+            // vertex Positions
+            glEnableVertexAttribArray(0);
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+            // vertex normals
+            glEnableVertexAttribArray(1);
+            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
+            // vertex texture coords
+            glEnableVertexAttribArray(2);
+            glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
+            // vertex tangent
+            glEnableVertexAttribArray(3);
+            glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Tangent));
+            // vertex bitangent
+            glEnableVertexAttribArray(4);
+            glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
+            return;
+        }
+
+        GLsizei stride = (GLsizei)Stride(format);
+        size_t frameOffset = format == VertexFormat::Packed ? 12 : 8;
+        glEnableVertexAttribArray(0);
+        if (format == VertexFormat::Packed)
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
+        else
+            glVertexAttribPointer(0, 4, GL_HALF_FLOAT, GL_FALSE, stride, (void*)0);
+        glEnableVertexAttribArray(TANGENT_FRAME_LOCATION);
+        glVertexAttribIPointer(TANGENT_FRAME_LOCATION, 1, GL_UNSIGNED_INT, stride, (void*)frameOffset);
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void*)(frameOffset + 4));
+    }
+}
+#endif
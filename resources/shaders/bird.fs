@@ -5,9 +5,10 @@ struct Material {
     sampler2D texture_diffuse1;
 };
 in vec2 TexCoords;
+in vec4 Tint;
 uniform Material material;
 
 void main()
 {
-    FragColor = texture(material.texture_diffuse1, TexCoords);
+    FragColor = texture(material.texture_diffuse1, TexCoords) * Tint;
 }
\ No newline at end of file
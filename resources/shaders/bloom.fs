@@ -5,16 +5,17 @@ in vec2 TexCoords;
 
 uniform sampler2D scene;
 uniform sampler2D bloomBlur;
-uniform bool bloom;
 uniform float exposure;
 
+// BLOOM is defined by the variant with bloom on (see ShaderVariants), the other doesn't sample the blur at all
+
 void main()
 {
     const float gamma = 2.2;
     vec3 hdrColor = texture(scene, TexCoords).rgb;
-    vec3 bloomColor = texture(bloomBlur, TexCoords).rgb;
-    if(bloom)
-        hdrColor += bloomColor;
+#ifdef BLOOM
+    hdrColor += texture(bloomBlur, TexCoords).rgb;
+#endif
     // tone mapping
     vec3 result = vec3(1.0) - exp(-hdrColor * exposure);
     // also gamma correct while we're at it
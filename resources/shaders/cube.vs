@@ -5,8 +5,13 @@ layout (location = 1) in vec3 aCol;
 out vec3 Color;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// per-frame camera data, shared by all programs (see uniform_blocks.h)
+layout (std140) uniform Camera {
+    mat4 projection;
+    mat4 view;
+    mat4 skyboxView;
+    vec4 viewPosition;
+};
 
 void main()
 {
@@ -36,12 +36,24 @@ in vec2 TexCoords;
 in vec3 Normal;
 in vec3 FragPos;
 
-uniform DirectionalLight directionalLight;
-uniform SpotLight moonLight;
-uniform SpotLight sunLight;
+// std140 blocks shared by all programs, their C++ side is in uniform_blocks.h
+layout (std140) uniform Camera {
+    mat4 projection;
+    mat4 view;
+    mat4 skyboxView;
+    vec4 viewPosition;
+};
+layout (std140) uniform Lights {
+    DirectionalLight directionalLight;
+    SpotLight sunLight;
+    SpotLight moonLight;
+};
 uniform Material material;
 
-uniform vec3 viewPosition;
+// how many of the spotlights light the earth, the sun's first: defined by the variant (see ShaderVariants)
+#ifndef SPOT_LIGHTS
+#define SPOT_LIGHTS 2
+#endif
 
 vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
 {
@@ -94,10 +106,14 @@ vec3 CalcDirectionalLight(DirectionalLight light, vec3 normal, vec3 fragPos, vec
 void main()
 {
     vec3 normal = normalize(Normal);
-    vec3 viewDir = normalize(viewPosition - FragPos);
+    vec3 viewDir = normalize(viewPosition.xyz - FragPos);
     vec3 result = CalcDirectionalLight(directionalLight, normal, FragPos, viewDir);
+#if SPOT_LIGHTS > 0
     result += CalcSpotLight(sunLight, normal, FragPos, viewDir);
+#endif
+#if SPOT_LIGHTS > 1
     result += CalcSpotLight(moonLight, normal, FragPos, viewDir);
+#endif
     float brightness = dot(result, vec3(0.2126, 0.7152, 0.0722));
     if (brightness > 1.0)
         BrightColor = vec4(result, 1.0);
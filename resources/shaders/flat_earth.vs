@@ -2,19 +2,49 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
+// packed vertices replace normal, tangent and bitangent by a tangent frame quaternion (see vertex_format.h)
+layout (location = 5) in uint aTangentFrame;
 
 out vec2 TexCoords;
 out vec3 Normal;
 out vec3 FragPos;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// per-frame camera data, shared by all programs (see uniform_blocks.h)
+layout (std140) uniform Camera {
+    mat4 projection;
+    mat4 view;
+    mat4 skyboxView;
+    vec4 viewPosition;
+};
+uniform bool packedVertices;
+
+// quaternion of a packed tangent frame: three components of 10, 10 and 9 bits, the index of the fourth (the largest,
+// rebuilt from the others) in bits 29-30 and the bitangent sign in bit 31
+vec4 decodeTangentFrame(uint frame)
+{
+    vec3 rest = vec3(uvec3(frame, frame >> 10u, frame >> 20u) & uvec3(1023u, 1023u, 511u)) / vec3(1023.0, 1023.0, 511.0);
+    rest = (rest * 2.0 - 1.0) * 0.70710678;
+    float largest = sqrt(max(0.0, 1.0 - dot(rest, rest)));
+    uint index = (frame >> 29u) & 3u;
+    if (index == 0u)
+        return vec4(largest, rest);
+    if (index == 1u)
+        return vec4(rest.x, largest, rest.yz);
+    if (index == 2u)
+        return vec4(rest.xy, largest, rest.z);
+    return vec4(rest, largest);
+}
+
+vec3 rotate(vec4 q, vec3 v)
+{
+    return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
 
 void main()
 {
     FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = aNormal;
+    Normal = packedVertices ? rotate(decodeTangentFrame(aTangentFrame), vec3(0.0, 0.0, 1.0)) : aNormal;
     TexCoords = aTexCoords;
     gl_Position = projection * view * vec4(FragPos, 1.0);
 }
\ No newline at end of file
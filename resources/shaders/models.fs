@@ -9,13 +9,14 @@ struct Material {
     float shininess;
 };
 in vec2 TexCoords;
+in vec4 Tint;
 uniform Material material;
 uniform vec3 ambientLight;
 
 void main()
 {
     //only has ambient component since it is a light source itself
-    vec3 ambient = ambientLight * vec3(texture(material.texture_diffuse1, TexCoords));
+    vec3 ambient = ambientLight * vec3(texture(material.texture_diffuse1, TexCoords)) * Tint.rgb;
     FragColor = vec4(ambient, 1.0);
     float brightness = dot(FragColor.rgb, vec3(0.2126, 0.7152, 0.0722));
     if (brightness > 1.0)
@@ -1,16 +1,26 @@
 #version 330 core
+// packed vertices store half float positions and texture coordinates, the vertex fetch converts them to these
+// floats. The normal isn't used, so the tangent frame of packed vertices (location 5) needs no decoding here
 layout (location = 0) in vec3 aPos;
 layout (location = 2) in vec2 aTexCoords;
 
 out vec2 TexCoords;
+// per-instance color in models_instanced.vs
+out vec4 Tint;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// per-frame camera data, shared by all programs (see uniform_blocks.h)
+layout (std140) uniform Camera {
+    mat4 projection;
+    mat4 view;
+    mat4 skyboxView;
+    vec4 viewPosition;
+};
 
 void main()
 {
     vec3 FragPos = vec3(model * vec4(aPos, 1.0));
     TexCoords = aTexCoords;    
+    Tint = vec4(1.0);
     gl_Position = projection * view * vec4(FragPos, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,26 @@
+#version 330 core
+// models.vs drawn with Model::DrawInstanced: the model matrix and a tint come from the instance buffer
+// (see instance_buffer.h) instead of the model uniform
+layout (location = 0) in vec3 aPos;
+layout (location = 2) in vec2 aTexCoords;
+layout (location = 6) in mat4 aModel;
+layout (location = 10) in vec4 aTint;
+
+out vec2 TexCoords;
+out vec4 Tint;
+
+// per-frame camera data, shared by all programs (see uniform_blocks.h)
+layout (std140) uniform Camera {
+    mat4 projection;
+    mat4 view;
+    mat4 skyboxView;
+    vec4 viewPosition;
+};
+
+void main()
+{
+    vec3 FragPos = vec3(aModel * vec4(aPos, 1.0));
+    TexCoords = aTexCoords;
+    Tint = aTint;
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
@@ -12,8 +12,23 @@
 #include <learnopengl/shader.h>
 #include <learnopengl/camera.h>
 #include <learnopengl/model.h>
-
+#include <learnopengl/asset_loader.h>
+#include <learnopengl/frame_ring_buffer.h>
+#include <learnopengl/geometry_arena.h>
+#include <learnopengl/gl_state.h>
+#include <learnopengl/render_queue.h>
+#include <learnopengl/shader_scheduler.h>
+#include <learnopengl/shader_variants.h>
+#include <learnopengl/startup_benchmark.h>
+#include <learnopengl/streaming_manager.h>
+#include <learnopengl/uniform_blocks.h>
+
+#include <unistd.h>
+
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <map>
 
 void framebuffer_size_callback(GLFWwindow *window, int width, int height);
 
@@ -33,14 +48,33 @@ float calculateValue(tuple<float, float, float, float> &plane, glm::vec3 pos);
 
 unsigned int loadCubemap(vector<std::string> &faces);
 
+unsigned int loadCubemapAsync(vector<std::string> &faces, AssetLoader &loader, std::function<void()> onLoaded = nullptr);
+
 void renderQuad();
 
+double residentMegabytes();
+
 // settings
 const unsigned int SCR_WIDTH = 800;
 const unsigned int SCR_HEIGHT = 600;
 bool hdr = true;
 float exposure = 0.4f;
 bool bloom = true;
+// free the CPU copy of model geometry after upload
+bool releaseGeometry = false;
+// read the assets from resources.pack when there is one
+bool useAssetPack = true;
+// --startup-bench: time the stages of startup, write them to benchReport and exit after the first frame with
+// every asset loaded. Fails when a stage takes benchTolerance longer than in the benchBaseline report
+bool startupBench = false;
+std::string benchReport = "startup_bench.json";
+bool benchCold = false;
+std::string benchBaseline;
+double benchTolerance = 0.25;
+// write the uniform blocks through a FrameRingBuffer
+bool useFrameRing = true;
+// far plane of the projection, the render queue quantizes depth up to it
+const float FAR_PLANE = 100.0f;
 
 // camera
 float lastX = SCR_WIDTH / 2.0f;
@@ -74,6 +108,31 @@ struct DirectionalLight {
     glm::vec3 specular;
 };
 
+// per-draw uniforms, resolved once after linking so the loop neither hashes names nor asks the driver for locations.
+// The camera and the lights are in the shared uniform blocks
+struct TransformUniforms {
+    Uniform model;
+
+    TransformUniforms() = default;
+    explicit TransformUniforms(const Shader &shader) : model(shader.GetUniform("model")) {
+    }
+};
+
+// a draw of the frame, submitted to the render queue with the index of its command
+struct DrawCommand {
+    enum Kind { MeshDraw, Cube, Sky };
+
+    Kind kind;
+    Shader *shader;
+    Uniform modelUniform;
+    glm::mat4 model;
+    // MeshDraw only
+    Mesh *mesh;
+    unsigned int lod;
+};
+
+RenderQueue *renderQueue;
+
 struct ProgramState {
     bool ImGuiEnabled = false;
     Camera camera;
@@ -87,6 +146,8 @@ struct ProgramState {
     glm::vec3 birdPosition = glm::vec3(2.0f, 2.0f, 1.5f);
     float birdScale = 0.01f;
     glm::vec3 karambitPosition = glm::vec3 (1.96f, 1.99f, 2.02f);
+    // spotlights lighting the earth, each count is a variant of flat_earth.fs
+    int earthSpotLights = 2;
 
     DirectionalLight directionalLight;
     SpotLight sunSpotLight;
@@ -99,12 +160,145 @@ struct ProgramState {
 
 ProgramState *programState;
 
+// std140 contents of the shared uniform blocks, zero initialized so the padding compares equal between frames
+UniformBlocks::Camera cameraBlock(const Camera &camera) {
+    UniformBlocks::Camera block = {};
+    block.projection = glm::perspective(glm::radians(camera.Zoom), (float) SCR_WIDTH / (float) SCR_HEIGHT, 0.1f, FAR_PLANE);
+    block.view = camera.GetViewMatrix();
+    block.skyboxView = glm::mat4(glm::mat3(block.view));
+    block.viewPosition = glm::vec4(camera.Position, 1.0f);
+    return block;
+}
+
+UniformBlocks::DirectionalLight lightBlock(const DirectionalLight &light) {
+    UniformBlocks::DirectionalLight block = {};
+    block.direction = light.direction;
+    block.specular = light.specular;
+    block.diffuse = light.diffuse;
+    block.ambient = light.ambient;
+    return block;
+}
+
+// the lights move, their position and direction come from the caller
+UniformBlocks::SpotLight lightBlock(const SpotLight &light, const glm::vec3 &position, const glm::vec3 &direction) {
+    UniformBlocks::SpotLight block = {};
+    block.position = position;
+    block.direction = direction;
+    block.cutOff = light.cutoff;
+    block.outerCutOff = light.outerCutOff;
+    block.specular = light.specular;
+    block.diffuse = light.diffuse;
+    block.ambient = light.ambient;
+    block.constant = light.constant;
+    block.linear = light.linear;
+    block.quadratic = light.quadratic;
+    return block;
+}
+
+// the sun and the moon circle the earth, their spotlights follow them
+UniformBlocks::Lights lightsBlock(double time) {
+    UniformBlocks::Lights block = {};
+    block.directionalLight = lightBlock(programState->directionalLight);
+    block.sunLight = lightBlock(programState->sunSpotLight, programState->sunPosition,
+                                glm::vec3(sin(time)/5.0f-0.2f,-1.0f,cos(time)/5.0f) - programState->sunPosition);
+    block.moonLight = lightBlock(programState->moonSpotLight, programState->moonPosition,
+                                 glm::vec3(-sin(time)/4.0f-0.2f,-1.0f,-cos(time)/4.0f) - programState->moonPosition);
+    return block;
+}
+// models streamed in around the hidden room, for the ImGui panel
+StreamingManager *streamingManager = nullptr;
+// the shared uniform buffers, for their upload counts in the ImGui panel
+UniformBuffer<UniformBlocks::Camera> *cameraUniforms = nullptr;
+UniformBuffer<UniformBlocks::Lights> *lightsUniforms = nullptr;
+// the ring the uniform blocks are written through every frame, null with --no-frame-ring
+FrameRingBuffer *frameRing = nullptr;
+// the programs compiled with defines, for the variant report in the ImGui panel
+vector<const ShaderVariants*> shaderVariants;
+ShaderScheduler *shaderScheduler = nullptr;
+
 void DrawImGui();
 
-int main() {
+int main(int argc, char **argv) {
+    StartupBenchmark startup;
+    // offline tools
+    // -------------
+    for (int i = 1; i < argc; i++) {
+        if (std::string(argv[i]) == "--bake-textures") {
+            // there is no context to ask, bake for a driver that supports both BC1/BC3 and BC7. Drivers with only
+            // one of them reuse the textures that got a format they have (see TextureCompression::Reproduces)
+            TextureCompression settings;
+            settings.s3tc = true;
+            settings.bptc = true;
+            BlockCompression::Threads() = 0;
+            unsigned int baked = TextureCache::BakeDirectory(FileSystem::getPath("resources"), settings, settings.Cubemap());
+            std::cout << baked << " textures in the texture cache" << std::endl;
+            return 0;
+        }
+        // packs resources/, caches included: bake the textures and run once before, so the pack has them
+        if (std::string(argv[i]) == "--build-pack") {
+            unsigned int packed = AssetPack::Build(FileSystem::getPath(""), "resources", FileSystem::getPath("resources.pack"));
+            std::cout << packed << " files in " << FileSystem::getPath("resources.pack") << std::endl;
+            return packed > 0 ? 0 : 1;
+        }
+        // import .obj models through Assimp instead of the ObjLoader
+        if (std::string(argv[i]) == "--assimp")
+            ObjImporter() = MeshImporter::Assimp;
+        if (std::string(argv[i]) == "--release-geometry")
+            releaseGeometry = true;
+        if (std::string(argv[i]) == "--no-pack")
+            useAssetPack = false;
+        if (std::string(argv[i]) == "--no-program-cache")
+            ProgramCache::Enabled() = false;
+        if (std::string(argv[i]) == "--startup-bench") {
+            startupBench = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-')
+                benchReport = argv[++i];
+        }
+        // evict the assets from the page cache first, so they are read from the disk
+        if (std::string(argv[i]) == "--bench-cold")
+            benchCold = true;
+        if (std::string(argv[i]) == "--bench-baseline" && i + 1 < argc)
+            benchBaseline = argv[++i];
+        if (std::string(argv[i]) == "--bench-tolerance" && i + 1 < argc)
+            benchTolerance = atof(argv[++i]);
+        // check the GL state shadow against glGet on every state change
+        if (std::string(argv[i]) == "--gl-state-debug")
+            GLState::Debug() = true;
+        // one draw call per mesh even where glMultiDrawElementsIndirect is available, to compare
+        if (std::string(argv[i]) == "--no-multi-draw")
+            GeometryArena::MultiDrawEnabled() = false;
+        // never ask whether a program is done compiling, wait for it on first use instead
+        if (std::string(argv[i]) == "--no-parallel-compile")
+            ParallelCompile::Enabled() = false;
+        // orphan the frame ring buffer even where it could be mapped persistently
+        if (std::string(argv[i]) == "--no-persistent-mapping")
+            FrameRingBuffer::PersistentEnabled() = false;
+        // update the uniform blocks in place (glBufferSubData of the changed bytes) instead of through the ring
+        if (std::string(argv[i]) == "--no-frame-ring")
+            useFrameRing = false;
+    }
+    std::string benchMode = "warm";
+    if (startupBench && benchCold) {
+        benchMode = "cold, " + StartupBenchmark::DropPageCache({FileSystem::getPath("resources"), FileSystem::getPath("resources.pack")});
+        startup.Restart();
+    }
+
+    // asset pack: one mapping read ahead sequentially instead of a file per asset, loose files are the fallback
+    // -------------------------------------------------------------------------------------------------------
+    if (useAssetPack && FileSystem::exists(FileSystem::getPath("resources.pack"))) {
+        if (FileSystem::mountPack(FileSystem::getPath("resources.pack")))
+            std::cout << "Mounted resources.pack (" << AssetPack::Instance().Size() / (1024.0 * 1024.0) << " MB)" << std::endl;
+    }
+    startup.Mark("asset_pack");
+
     // glfw: initialize and configure
     // ------------------------------
     glfwInit();
+    // glfw: terminate, clearing all previously allocated GLFW resources, when main returns. Declared before
+    // the models and everything else owning GL objects, so those are destroyed while the context still exists.
+    struct GlfwTerminator {
+        ~GlfwTerminator() { glfwTerminate(); }
+    } glfwTerminator;
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
@@ -125,12 +319,28 @@ int main() {
     // tell GLFW to capture our mouse
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
+    startup.Mark("glfw_init");
+
     // glad: load all OpenGL function pointers
     // ---------------------------------------
     if (!gladLoadGLLoader((GLADloadproc) glfwGetProcAddress)) {
         std::cout << "Failed to initialize GLAD" << std::endl;
         return -1;
     }
+    // linked shader programs are cached as driver binaries when the context can give them out
+    ProgramCache::LoadFunctions((GLADloadproc) glfwGetProcAddress);
+    // programs are compiled on the driver's threads where it has them, see ShaderScheduler
+    if (!ParallelCompile::LoadFunctions((GLADloadproc) glfwGetProcAddress))
+        std::cout << "KHR_parallel_shader_compile not available, programs are waited for on first use" << std::endl;
+    // meshes sharing material and vertex format are drawn with one indirect call where the context can
+    if (!GeometryArena::Instance().LoadFunctions((GLADloadproc) glfwGetProcAddress))
+        std::cout << "glMultiDrawElementsIndirect not available, drawing meshes one by one" << std::endl;
+    // per-frame data goes through persistently mapped memory where the context can map it
+    if (!FrameRingBuffer::LoadFunctions((GLADloadproc) glfwGetProcAddress))
+        std::cout << "glBufferStorage not available, the frame ring buffer orphans" << std::endl;
+    // textures are block compressed into whatever formats this driver can sample
+    TextureCache::Compression().DetectSupport();
+    startup.Mark("glad_init");
 
     // tell stb_image.h to flip loaded texture's on the y-axis (before loading model).
     stbi_set_flip_vertically_on_load(false);
@@ -146,13 +356,14 @@ int main() {
 
     // configure global opengl state
     // -----------------------------
-    glEnable(GL_DEPTH_TEST);
+    GLState &glState = GLState::Instance();
+    glState.Enable(GL_DEPTH_TEST);
 
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glState.Enable(GL_BLEND);
+    glState.BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-    glEnable(GL_CULL_FACE);
-    glCullFace(GL_BACK);
+    glState.Enable(GL_CULL_FACE);
+    glState.CullFace(GL_BACK);
 
     float vertices[] = {
             // position                       color
@@ -207,7 +418,7 @@ int main() {
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 
-    glBindVertexArray(cubeVAO);
+    glState.BindVertexArray(cubeVAO);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
 
@@ -263,40 +474,114 @@ int main() {
     unsigned int skyboxVAO, skyboxVBO;
     glGenVertexArrays(1, &skyboxVAO);
     glGenBuffers(1, &skyboxVBO);
-    glBindVertexArray(skyboxVAO);
+    glState.BindVertexArray(skyboxVAO);
     glBindBuffer(GL_ARRAY_BUFFER, skyboxVBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(skyboxVertices), &skyboxVertices, GL_STATIC_DRAW);
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-
+    startup.Mark("imgui_and_geometry");
 
     // build and compile shaders
     // -------------------------
-    Shader modelsShader("resources/shaders/models.vs", "resources/shaders/models.fs");
-    Shader earthShader("resources/shaders/flat_earth.vs", "resources/shaders/flat_earth.fs");
-    Shader skyboxShader("resources/shaders/skybox.vs", "resources/shaders/skybox.fs");
-    Shader boxShader("resources/shaders/cube.vs","resources/shaders/cube.fs");
-    Shader birdShader("resources/shaders/bird.vs","resources/shaders/bird.fs");
-    Shader hdrShader("resources/shaders/hdr.vs","resources/shaders/hdr.fs");
-    Shader shaderBlur("resources/shaders/blur.vs","resources/shaders/blur.fs");
-    Shader shaderBloom("resources/shaders/bloom.vs","resources/shaders/bloom.fs");
+    // every program is handed to the driver now and set up once it is ready, passes skip the frames before that
+    ShaderScheduler shaders;
+    shaderScheduler = &shaders;
+    TransformUniforms modelsTransform, boxTransform, birdTransform;
+    Uniform modelsAmbientLight, blurHorizontal;
+    Shader &modelsShader = shaders.Submit("resources/shaders/models.vs", "resources/shaders/models.fs", [&](Shader &shader) {
+        modelsTransform = TransformUniforms(shader);
+        modelsAmbientLight = shader.GetUniform("ambientLight");
+    });
+    Shader &skyboxShader = shaders.Submit("resources/shaders/skybox.vs", "resources/shaders/skybox.fs", [](Shader &shader) {
+        shader.use();
+        shader.setInt("skybox", 0);
+    });
+    Shader &boxShader = shaders.Submit("resources/shaders/cube.vs", "resources/shaders/cube.fs", [&](Shader &shader) {
+        boxTransform = TransformUniforms(shader);
+    });
+    Shader &birdShader = shaders.Submit("resources/shaders/bird.vs", "resources/shaders/bird.fs", [&](Shader &shader) {
+        birdTransform = TransformUniforms(shader);
+    });
+    shaders.Submit("resources/shaders/hdr.vs", "resources/shaders/hdr.fs", [](Shader &shader) {
+        shader.use();
+        shader.setInt("hdrBuffer", 0);
+    });
+    Shader &shaderBlur = shaders.Submit("resources/shaders/blur.vs", "resources/shaders/blur.fs", [&](Shader &shader) {
+        shader.use();
+        shader.setInt("image", 0);
+        blurHorizontal = shader.GetUniform("horizontal");
+    });
+    // a variant per number of spotlights, the one with both is requested up front. The material is the same for
+    // every frame, it is set once per variant along with looking up its model matrix
+    std::map<const Shader*, TransformUniforms> earthTransforms;
+    ShaderVariants earthVariants("resources/shaders/flat_earth.vs", "resources/shaders/flat_earth.fs", [&](Shader &variant) {
+        earthTransforms[&variant] = TransformUniforms(variant);
+        variant.use();
+        variant.setFloat(variant.GetUniform("material.shininess"), 32.0f);
+        variant.setVec3(variant.GetUniform("material.specular"), 0.05f);
+    });
+    ShaderDefines earthDefines[3];
+    for (int lights = 0; lights < 3; lights++)
+        earthDefines[lights].Set("SPOT_LIGHTS", lights);
+    earthVariants.Request(earthDefines[2]);
+    // with and without the bloom texture, the variant for the current setting is requested up front
+    std::map<const Shader*, Uniform> bloomExposures;
+    ShaderVariants bloomVariants("resources/shaders/bloom.vs", "resources/shaders/bloom.fs", [&](Shader &variant) {
+        variant.use();
+        variant.setInt("scene", 0);
+        variant.setInt("bloomBlur", 1);
+        bloomExposures[&variant] = variant.GetUniform("exposure");
+    });
+    const ShaderDefines bloomDefines[2] = {ShaderDefines(), ShaderDefines().Set("BLOOM")};
+    bloomVariants.Request(bloomDefines[bloom]);
+    shaderVariants = {&earthVariants, &bloomVariants};
+    // the earth and bloom programs used last, drawn with while the ones for changed settings compile, and their
+    // uniforms
+    Shader *earthProgram = nullptr;
+    TransformUniforms earthTransform;
+    Shader *bloomProgram = nullptr;
+    Uniform bloomExposure;
+    bool bloomProgramBlurs = false;
+    startup.Mark("shaders_submitted");
 
     // load models
     // -----------
-    Model earthModel("resources/objects/earth/flat_earth.obj");
+    // models and the skybox are parsed and decoded on background threads, the render loop starts right away
+    // and uploads them as they arrive (see ProcessUploads below), drawing nothing for what isn't there yet.
+    double assetsStart = glfwGetTime();
+    AssetLoader assetLoader;
+
+    // packed vertices are a third of the size or less; the earth keeps float positions, it is lit by its normals
+    // and viewed from up close
+    Model earthModel("resources/objects/earth/flat_earth.obj", assetLoader);
     earthModel.SetShaderTextureNamePrefix("material.");
+    earthModel.SetVertexFormat(VertexFormat::Packed);
+    earthModel.SetReleaseGeometry(releaseGeometry);
 
-    Model sunModel("resources/objects/sun/sun.obj");
+    Model sunModel("resources/objects/sun/sun.obj", assetLoader);
     sunModel.SetShaderTextureNamePrefix("material.");
+    sunModel.SetVertexFormat(VertexFormat::PackedHalf);
+    sunModel.SetReleaseGeometry(releaseGeometry);
 
-    Model moonModel("resources/objects/moon/moon.obj");
+    Model moonModel("resources/objects/moon/moon.obj", assetLoader);
     moonModel.SetShaderTextureNamePrefix("material.");
-
-    Model birdModel("resources/objects/bird/bird.obj");
-    birdModel.SetShaderTextureNamePrefix("material.");
-
-    Model karambitModel("resources/objects/karambit/karambit.obj");
-    karambitModel.SetShaderTextureNamePrefix("material.");
+    moonModel.SetVertexFormat(VertexFormat::PackedHalf);
+    moonModel.SetReleaseGeometry(releaseGeometry);
+
+    // the bird and the karambit are only drawn inside the cube at (2,2,2): they are loaded as the camera
+    // approaches it and dropped once it has been away for a while
+    StreamingManager streaming(assetLoader);
+    streamingManager = &streaming;
+    auto setupStreamed = [](Model &streamed) {
+        streamed.SetShaderTextureNamePrefix("material.");
+        streamed.SetVertexFormat(VertexFormat::PackedHalf);
+        streamed.SetReleaseGeometry(releaseGeometry);
+    };
+    size_t birdHandle = streaming.Register("bird", "resources/objects/bird/bird.obj", glm::vec3(1.5f), glm::vec3(2.5f), setupStreamed);
+    size_t karambitHandle = streaming.Register("karambit", "resources/objects/karambit/karambit.obj", glm::vec3(1.5f), glm::vec3(2.5f), setupStreamed);
+    bool assetsReported = false;
+    bool shadersReported = false;
+    startup.Mark("models_submit");
 
     DirectionalLight& directionalLight = programState->directionalLight;
     directionalLight.direction = glm::vec3(0.0f, -0.5f, 0.0f);
@@ -336,17 +621,20 @@ int main() {
             FileSystem::getPath("resources/textures/skybox/stars_front.png"),
             FileSystem::getPath("resources/textures/skybox/stars_back.png")
     };
-    unsigned int cubemapTexture = loadCubemap(faces);
+    unsigned int cubemapTexture = loadCubemapAsync(faces, assetLoader, [&startup, assetsStart]() {
+        startup.Record("cubemap", (glfwGetTime() - assetsStart) * 1000.0);
+    });
+    startup.Mark("cubemap_submit");
 
     unsigned int hdrFBO;
     glGenFramebuffers(1,&hdrFBO);
-    glBindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
+    glState.BindFramebuffer(hdrFBO);
 
     unsigned int colorBuffers[2];
     glGenTextures(2, colorBuffers);
 
     for (int i = 0; i < 2; i++) {
-        glBindTexture(GL_TEXTURE_2D, colorBuffers[i]);
+        glState.BindTexture(0, GL_TEXTURE_2D, colorBuffers[i]);
         glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -366,7 +654,7 @@ int main() {
     if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
         std::cout<<"SOMETHING AIN'T RIGHT!\n";
     }
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glState.BindFramebuffer(0);
 
     // ping-pong-framebuffer for blurring
     unsigned int pingpongFBO[2];
@@ -374,8 +662,8 @@ int main() {
     glGenFramebuffers(2, pingpongFBO);
     glGenTextures(2, pingpongColorbuffers);
     for (unsigned int i = 0; i < 2; i++) {
-        glBindFramebuffer(GL_FRAMEBUFFER, pingpongFBO[i]);
-        glBindTexture(GL_TEXTURE_2D, pingpongColorbuffers[i]);
+        glState.BindFramebuffer(pingpongFBO[i]);
+        glState.BindTexture(0, GL_TEXTURE_2D, pingpongColorbuffers[i]);
         glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -386,20 +674,43 @@ int main() {
             std::cout << "Framebuffer not complete!" << std::endl;
     }
 
-    skyboxShader.use();
-    skyboxShader.setInt("skybox", 0);
-
-    hdrShader.use();
-    hdrShader.setInt("hdrBuffer", 0);
-
-    shaderBlur.use();
-    shaderBlur.setInt("image", 0);
-
-    shaderBloom.use();
-    shaderBloom.setInt("scene", 0);
-    shaderBloom.setInt("bloomBlur", 1);
+    startup.Mark("framebuffers");
+
+    // shared by every program that declares the blocks, Shader binds them to these binding points when linking
+    UniformBuffer<UniformBlocks::Camera> cameraBuffer(UniformBlocks::CAMERA_BINDING);
+    UniformBuffer<UniformBlocks::Lights> lightsBuffer(UniformBlocks::LIGHTS_BINDING);
+    cameraUniforms = &cameraBuffer;
+    lightsUniforms = &lightsBuffer;
+    // room for both blocks at the strictest offset alignment the spec allows
+    FrameRingBuffer uniformRing(GL_UNIFORM_BUFFER, 4 * 1024);
+    if (useFrameRing)
+        frameRing = &uniformRing;
+
+    int exitCode = 0;
+
+    // the frame's draws, ordered by their key instead of the order they are submitted in
+    RenderQueue queue;
+    vector<DrawCommand> commands;
+    MeshBatch meshBatch;
+    renderQueue = &queue;
+    // submits every mesh of a model as its own item, so meshes sharing a material or program end up together
+    auto submitModel = [&queue, &commands](Model &drawnModel, Shader &shader, Uniform modelUniform, const glm::mat4 &model) {
+        const Camera &camera = programState->camera;
+        for (Mesh &mesh : drawnModel.meshes) {
+            glm::vec3 center = glm::vec3(model * glm::vec4((mesh.boundsMin + mesh.boundsMax) * 0.5f, 1.0f));
+            // the first texture stands for the material, it is the one every mesh has
+            uint32_t material = mesh.textures.empty() ? 0 : mesh.textures[0].id;
+            queue.Submit(RenderQueue::MakeKey(RenderQueue::Opaque, shader.ID, material, mesh.VertexArray(),
+                                              glm::length(center - camera.Position), FAR_PLANE), (uint32_t)commands.size());
+            unsigned int lod = Model::SelectLod(mesh, model, camera.Position, camera.Zoom, (float)SCR_HEIGHT);
+            commands.push_back(DrawCommand{DrawCommand::MeshDraw, &shader, modelUniform, model, &mesh, lod});
+        }
+    };
 
     bool firstPass=true;
+    unsigned int frames = 0;
+    // the frame after the one that finished loading is the first to show every asset
+    bool completeFrame = false;
     // render loop
     // -----------
     while (!glfwWindowShouldClose(window)) {
@@ -413,76 +724,110 @@ int main() {
         // -----
         processInput(window);
 
+        // start loading what the camera is getting close to, drop what it left behind
+        streaming.Update(programState->camera.Position, glfwGetTime());
+        // upload whatever the asset workers finished since the last frame
+        assetLoader.ProcessUploads(4.0);
+        // set up the programs the driver finished since the last frame
+        size_t pendingShaders = shaders.Update();
+        if (pendingShaders == 0 && !shadersReported) {
+            startup.Record("shaders_ready", shaders.AllReadyMilliseconds());
+            shadersReported = true;
+        }
+        if (!assetsReported && !assetLoader.Busy() && pendingShaders == 0) {
+            // startup report, run once with the *.meshcache files deleted (cold) and once with them present (warm) to compare
+            for (const Model *loadedModel : {&earthModel, &sunModel, &moonModel}) {
+                std::cout << "Loaded " << loadedModel->directory << " in " << loadedModel->loadMilliseconds << " ms"
+                          << (loadedModel->loadedFromCache ? " (mesh cache)" : " (import)") << std::endl;
+            }
+            std::cout << "All assets loaded in " << (glfwGetTime() - assetsStart) * 1000.0 << " ms on "
+                      << assetLoader.WorkerCount() << " worker threads" << std::endl;
+            TextureRegistry::Instance().PrintStats();
+            ProgramCache::PrintStats();
+            shaders.PrintReport();
+            for (const ShaderVariants *variants : shaderVariants)
+                variants->PrintReport();
+            for (const Model *loadedModel : {&earthModel, &sunModel, &moonModel}) {
+                Model::MemoryUsage usage = loadedModel->GetMemoryUsage();
+                std::cout << "Memory of " << loadedModel->directory << ": geometry " << usage.cpuGeometry / (1024.0 * 1024.0)
+                          << " MB RAM, " << usage.gpuGeometry / (1024.0 * 1024.0) << " MB GPU, textures "
+                          << usage.textures / (1024.0 * 1024.0) << " MB (shared)" << std::endl;
+            }
+            std::cout << "Resident memory: " << residentMegabytes() << " MB"
+                      << (releaseGeometry ? " (geometry released after upload)" : "") << std::endl;
+            assetsReported = true;
+            const char *modelNames[] = {"earth", "sun", "moon"};
+            const Model *models[] = {&earthModel, &sunModel, &moonModel};
+            for (int i = 0; i < 3; i++)
+                startup.Record(std::string("model.") + modelNames[i], models[i]->loadMilliseconds);
+            startup.Record("assets", (glfwGetTime() - assetsStart) * 1000.0);
+            startup.Mark("frames_until_loaded");
+            completeFrame = true;
+        }
+
         // render
         // ------
-        glBindFramebuffer(GL_FRAMEBUFFER, hdrFBO);
-        glEnable(GL_DEPTH_TEST);
+        FrameDrawStatistics() = DrawStatistics();
+        // every texture bind goes through the shadow, uploads included, and ImGui puts back whatever state it
+        // changes, so the shadow stays valid from frame to frame
+        glState.BeginFrame();
+        glState.BindFramebuffer(hdrFBO);
+        glState.Enable(GL_DEPTH_TEST);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 
-        modelsShader.use();
-        // view/projection transformations
-        glm::mat4 projection = glm::perspective(glm::radians(programState->camera.Zoom),
-                                                (float) SCR_WIDTH / (float) SCR_HEIGHT, 0.1f, 100.0f);
-        glm::mat4 view = programState->camera.GetViewMatrix();
-        modelsShader.setMat4("projection", projection);
-        modelsShader.setMat4("view", view);
-        modelsShader.setVec3("ambientLight", glm::vec3(3.0f));
-
-        // render the sun model
+        // view/projection transformations and the lights, for every pass at once. Only the bytes that changed since
+        // the last frame are uploaded: the camera when it moves, the spotlights as they circle, the rest when edited
         programState->sunPosition=glm::vec3(sin(glfwGetTime())-0.2,1.0f,cos(glfwGetTime()));
+        programState->moonPosition=glm::vec3(-sin(glfwGetTime())-0.2f,1.0f,-cos(glfwGetTime()));
+        if (frameRing) {
+            // blocks that changed are written into a part of the ring the GPU is done with, waiting for it if it
+            // isn't; the others stay in their own buffers
+            frameRing->BeginFrame();
+            cameraBuffer.Update(cameraBlock(programState->camera), *frameRing);
+            lightsBuffer.Update(lightsBlock(glfwGetTime()), *frameRing);
+        } else {
+            cameraBuffer.Update(cameraBlock(programState->camera));
+            lightsBuffer.Update(lightsBlock(glfwGetTime()));
+        }
+
+        // what isn't ready yet is left out of the frame, the earth keeps its previous program while the one for
+        // a new number of spotlights compiles
+        bool modelsReady = shaders.Ready(modelsShader);
+        if (Shader *requested = earthVariants.Request(earthDefines[std::max(0, std::min(programState->earthSpotLights, 2))])) {
+            if (requested != earthProgram)
+                earthTransform = earthTransforms[requested];
+            earthProgram = requested;
+        }
+
+        // the uniforms every draw of a program shares, they stay set however the queue orders the draws
+        if (modelsReady) {
+            modelsShader.use();
+            modelsShader.setVec3(modelsAmbientLight, glm::vec3(3.0f));
+        }
+
+        queue.Clear();
+        commands.clear();
+
+        // the sun model
         glm::mat4 model = glm::mat4(1.0f);
         model = glm::translate(model,programState->sunPosition);
         model = glm::scale(model, glm::vec3(programState->sunScale));
-        modelsShader.setMat4("model", model);
-        sunModel.Draw(modelsShader);
+        if (modelsReady)
+            submitModel(sunModel, modelsShader, modelsTransform.model, model);
 
-        // render the moon model
-        programState->moonPosition=glm::vec3(-sin(glfwGetTime())-0.2f,1.0f,-cos(glfwGetTime()));
+        // the moon model
         model = glm::mat4(1.0f);
         model = glm::translate(model,programState->moonPosition);
         model = glm::scale(model, glm::vec3(programState->moonScale));
-        modelsShader.setMat4("model", model);
-        moonModel.Draw(modelsShader);
-
-        earthShader.use();
-        earthShader.setVec3("directionalLight.direction", directionalLight.direction);
-        earthShader.setVec3("directionalLight.ambient", directionalLight.ambient);
-        earthShader.setVec3("directionalLight.diffuse", directionalLight.diffuse);
-        earthShader.setVec3("directionalLight.specular", directionalLight.specular);
-        earthShader.setVec3("sunLight.ambient", sunSpotLight.ambient);
-        earthShader.setVec3("sunLight.diffuse", sunSpotLight.diffuse);
-        earthShader.setVec3("sunLight.specular", sunSpotLight.specular);
-        earthShader.setVec3("sunLight.position", programState->sunPosition);
-        earthShader.setVec3("sunLight.direction", glm::vec3(sin(glfwGetTime())/5.0f-0.2f,-1.0f,cos(glfwGetTime())/5.0f) - programState->sunPosition);
-        earthShader.setFloat("sunLight.cutOff", sunSpotLight.cutoff);
-        earthShader.setFloat("sunLight.outerCutOff", sunSpotLight.outerCutOff);
-        earthShader.setFloat("sunLight.constant", sunSpotLight.constant);
-        earthShader.setFloat("sunLight.linear", sunSpotLight.linear);
-        earthShader.setFloat("sunLight.quadratic", sunSpotLight.quadratic);
-
-        earthShader.setVec3("moonLight.ambient", moonSpotLight.ambient);
-        earthShader.setVec3("moonLight.diffuse", moonSpotLight.diffuse);
-        earthShader.setVec3("moonLight.specular", moonSpotLight.specular);
-        earthShader.setVec3("moonLight.position", programState->moonPosition);
-        earthShader.setVec3("moonLight.direction", glm::vec3(-sin(glfwGetTime())/4.0f-0.2f,-1.0f,-cos(glfwGetTime())/4.0f) - programState->moonPosition);
-        earthShader.setFloat("moonLight.cutOff", moonSpotLight.cutoff);
-        earthShader.setFloat("moonLight.outerCutOff", moonSpotLight.outerCutOff);
-        earthShader.setFloat("moonLight.constant", moonSpotLight.constant);
-        earthShader.setFloat("moonLight.linear", moonSpotLight.linear);
-        earthShader.setFloat("moonLight.quadratic", moonSpotLight.quadratic);
-
-        earthShader.setVec3("viewPosition", programState->camera.Position);
-        earthShader.setFloat("material.shininess", 32.0f);
-        earthShader.setVec3("material.specular", 0.05f);
-        earthShader.setMat4("projection", projection);
-        earthShader.setMat4("view", view);
-
-        // render the flatEarth model
+        if (modelsReady)
+            submitModel(moonModel, modelsShader, modelsTransform.model, model);
+
+        // the flatEarth model
         model = glm::mat4(1.0f);
         model = glm::translate(model,programState->earthPosition);
         model = glm::scale(model, glm::vec3(programState->earthScale));
-        earthShader.setMat4("model", model);
-        earthModel.Draw(earthShader);
+        if (earthProgram)
+            submitModel(earthModel, *earthProgram, earthTransform.model, model);
 
         model = glm::mat4(1.0f);
         model = glm::translate(model, glm::vec3(2.0f));  //could be randomized
@@ -529,75 +874,107 @@ int main() {
         }
 
         if(isCameraInside(planes, programState->camera.Position)) {
-            boxShader.use();
-            projection = glm::perspective(glm::radians(programState->camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-            view = programState->camera.GetViewMatrix();
-            boxShader.setMat4("projection", projection);
-            boxShader.setMat4("view", view);
-            boxShader.setMat4("model", model);
-            glBindVertexArray(cubeVAO);
-            glDrawArrays(GL_TRIANGLES, 0, 36);
-
-            birdShader.use();
-            birdShader.setMat4("projection", projection);
-            birdShader.setMat4("view", view);
+            if (shaders.Ready(boxShader)) {
+                queue.Submit(RenderQueue::MakeKey(RenderQueue::Opaque, boxShader.ID, 0, cubeVAO,
+                                                  glm::length(glm::vec3(model[3]) - programState->camera.Position), FAR_PLANE),
+                             (uint32_t)commands.size());
+                commands.push_back(DrawCommand{DrawCommand::Cube, &boxShader, boxTransform.model, model, nullptr, 0});
+            }
+            bool birdReady = shaders.Ready(birdShader);
+
             model = glm::mat4(1.0f);
             model = glm::translate(model,programState->birdPosition);
             model = glm::rotate(model, glm::radians(90.0f), glm::vec3(0,0,-1));
             model = glm::scale(model, glm::vec3(programState->birdScale));
-            birdShader.setMat4("model", model);
-            birdModel.Draw(birdShader);
+            if (Model *birdModel = birdReady ? streaming.Get(birdHandle) : nullptr)
+                submitModel(*birdModel, birdShader, birdTransform.model, model);
 
             model = glm::mat4(1.0f);
             model = glm::translate(model,programState->karambitPosition);
             model = glm::rotate(model, glm::radians(170.0f), glm::vec3(0,0,-1));
-            birdShader.setMat4("model", model);
-            karambitModel.Draw(birdShader);
+            if (Model *karambitModel = birdReady ? streaming.Get(karambitHandle) : nullptr)
+                submitModel(*karambitModel, birdShader, birdTransform.model, model);
         }
 
-        // draw skybox
-        glDepthMask(GL_FALSE);
-        glDepthFunc(GL_LEQUAL);
-        skyboxShader.use();
-        view = glm::mat4(glm::mat3(programState->camera.GetViewMatrix()));
-        skyboxShader.setMat4("view", view);
-        skyboxShader.setMat4("projection", projection);
-        // skybox cube
-        glBindVertexArray(skyboxVAO);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTexture);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-        glBindVertexArray(0);
-        glDepthFunc(GL_LESS);
-        glDepthMask(GL_TRUE);
-
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        // the skybox, behind everything and drawn last so it only shades what nothing else covered
+        if (shaders.Ready(skyboxShader)) {
+            queue.Submit(RenderQueue::MakeKey(RenderQueue::Skybox, skyboxShader.ID, cubemapTexture, skyboxVAO, 0.0f, FAR_PLANE),
+                         (uint32_t)commands.size());
+            commands.push_back(DrawCommand{DrawCommand::Sky, &skyboxShader, Uniform(), glm::mat4(1.0f), nullptr, 0});
+        }
 
+        queue.Sort();
+        // neighbouring meshes of one model and material share a batch, it is flushed before the program or the
+        // model matrix the batched draws read changes
+        const DrawCommand *batched = nullptr;
+        queue.Execute([&](uint32_t index) {
+            const DrawCommand &command = commands[index];
+            if (batched && (command.kind != DrawCommand::MeshDraw || command.shader != batched->shader ||
+                            command.model != batched->model)) {
+                meshBatch.Flush();
+                batched = nullptr;
+            }
+            command.shader->use();
+            switch (command.kind) {
+                case DrawCommand::MeshDraw:
+                    if (!batched) {
+                        command.shader->setMat4(command.modelUniform, command.model);
+                        batched = &command;
+                    }
+                    meshBatch.Add(*command.mesh, *command.shader, command.lod);
+                    break;
+                case DrawCommand::Cube:
+                    command.shader->setMat4(command.modelUniform, command.model);
+                    glState.BindVertexArray(cubeVAO);
+                    glDrawArrays(GL_TRIANGLES, 0, 36);
+                    break;
+                case DrawCommand::Sky:
+                    glState.DepthMask(false);
+                    glState.DepthFunc(GL_LEQUAL);
+                    glState.BindVertexArray(skyboxVAO);
+                    glState.BindTexture(0, GL_TEXTURE_CUBE_MAP, cubemapTexture);
+                    glDrawArrays(GL_TRIANGLES, 0, 36);
+                    glState.DepthFunc(GL_LESS);
+                    glState.DepthMask(true);
+                    break;
+            }
+        });
+        meshBatch.Flush();
+
+        // without the blur program the frame goes out without bloom. The variant without bloom never samples the
+        // blur, so it isn't made
+        bool blur = bloom && shaders.Ready(shaderBlur);
+        if (Shader *requested = bloomVariants.Request(bloomDefines[blur])) {
+            if (requested != bloomProgram)
+                bloomExposure = bloomExposures[requested];
+            bloomProgram = requested;
+            bloomProgramBlurs = blur;
+        }
         bool horizontal = true, first_iteration = true;
-        int amount = 10;
-        shaderBlur.use();
+        int amount = bloomProgram && bloomProgramBlurs ? 10 : 0;
+        if (amount > 0)
+            shaderBlur.use();
         for (int i = 0; i < amount; i++) {
-            glBindFramebuffer(GL_FRAMEBUFFER, pingpongFBO[horizontal]);
-            shaderBlur.setInt("horizontal", horizontal);
-            glBindTexture(GL_TEXTURE_2D, first_iteration ? colorBuffers[1] : pingpongColorbuffers[!horizontal]);
+            glState.BindFramebuffer(pingpongFBO[horizontal]);
+            shaderBlur.setInt(blurHorizontal, horizontal);
+            glState.BindTexture(0, GL_TEXTURE_2D, first_iteration ? colorBuffers[1] : pingpongColorbuffers[!horizontal]);
             renderQuad();
             horizontal = !horizontal;
             if (first_iteration)
                 first_iteration = false;
         }
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glState.BindFramebuffer(0);
 
 
 
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        shaderBloom.use();
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, colorBuffers[0]);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, pingpongColorbuffers[!horizontal]);
-        shaderBloom.setBool("bloom", bloom);
-        shaderBloom.setFloat("exposure", exposure);
-        renderQuad();
+        if (bloomProgram) {
+            bloomProgram->use();
+            glState.BindTexture(0, GL_TEXTURE_2D, colorBuffers[0]);
+            glState.BindTexture(1, GL_TEXTURE_2D, pingpongColorbuffers[!horizontal]);
+            bloomProgram->setFloat(bloomExposure, exposure);
+            renderQuad();
+        }
 
 //        hdrShader.use();
 //        glBindVertexArray(quadVAO);
@@ -608,21 +985,42 @@ int main() {
 
         if (programState->ImGuiEnabled)
             DrawImGui();
+        if (frameRing)
+            frameRing->EndFrame();
 
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
         // -------------------------------------------------------------------------------
         glfwSwapBuffers(window);
         glfwPollEvents();
+
+        if (startupBench && (frames == 0 || completeFrame)) {
+            // wait for the GPU, a frame isn't done when its commands are queued
+            glFinish();
+            startup.Mark(frames == 0 ? "first_frame" : "first_complete_frame");
+            if (completeFrame)
+                glfwSetWindowShouldClose(window, true);
+        }
+        completeFrame = false;
+        frames++;
+    }
+
+    if (startupBench) {
+        std::cout << "Startup (" << benchMode << ") in " << startup.Elapsed() << " ms:" << std::endl;
+        startup.Print();
+        if (!startup.WriteJson(benchReport, benchMode))
+            exitCode = 2;
+        if (!benchBaseline.empty()) {
+            int regressions = startup.Compare(benchBaseline, benchTolerance, 5.0);
+            if (regressions != 0)
+                exitCode = regressions < 0 ? 2 : 1;
+        }
     }
 
     delete programState;
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
-    // glfw: terminate, clearing all previously allocated GLFW resources.
-    // ------------------------------------------------------------------
-    glfwTerminate();
-    return 0;
+    return exitCode;
 }
 
 // process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
@@ -699,6 +1097,26 @@ void DrawImGui() {
     ImGui::DragFloat("Sun constant factor", &programState->sunSpotLight.constant, 0.05f);
     ImGui::DragFloat("Sun linear factor", &programState->sunSpotLight.linear, 0.01f);
     ImGui::DragFloat("Sun quadratic factor", &programState->sunSpotLight.quadratic, 0.001f);
+    ImGui::SliderInt("Earth spotlights", &programState->earthSpotLights, 0, 2);
+    ImGui::Checkbox("Bloom", &bloom);
+    const char *blockNames[] = {"Camera", "Lights"};
+    const UniformBuffer<UniformBlocks::Camera>::Stats &cameraStats = cameraUniforms->GetStats();
+    const UniformBuffer<UniformBlocks::Lights>::Stats &lightsStats = lightsUniforms->GetStats();
+    unsigned int updates[] = {cameraStats.updates, lightsStats.updates};
+    unsigned int uploads[] = {cameraStats.uploads, lightsStats.uploads};
+    size_t bytes[] = {cameraStats.bytes, lightsStats.bytes};
+    for (int i = 0; i < 2; i++)
+        ImGui::Text("%s block: uploaded %u of %u frames, %.1f bytes per upload", blockNames[i], uploads[i], updates[i],
+                    uploads[i] ? (double)bytes[i] / uploads[i] : 0.0);
+    if (frameRing) {
+        const FrameRingBuffer::Stats &ringStats = frameRing->GetStats();
+        ImGui::Text("Frame ring (%s): %zu bytes last frame, %zu at most", frameRing->Persistent() ? "persistent" : "orphaning",
+                    ringStats.frameBytes, ringStats.peakBytes);
+        ImGui::Text("  waited on a fence %u times, %.2f ms in total, %.2f ms last frame", ringStats.waits,
+                    ringStats.waitMilliseconds, ringStats.lastWaitMilliseconds);
+    } else {
+        ImGui::Text("Frame ring off");
+    }
     ImGui::End();
 
     ImGui::Begin("Camera info");
@@ -708,6 +1126,85 @@ void DrawImGui() {
     ImGui::Text("Camera front: (%f, %f, %f)", c.Front.x, c.Front.y, c.Front.z);
     ImGui::End();
 
+    ImGui::Begin("Level of detail");
+    const DrawStatistics &statistics = FrameDrawStatistics();
+    ImGui::DragFloat("Max error (pixels)", &LodPixelError(), 0.05f, 0.0f, 16.0f);
+    ImGui::Text("Triangles: %zu of %zu (%.1f%%)", statistics.triangles, statistics.fullTriangles,
+                statistics.fullTriangles ? 100.0 * statistics.triangles / statistics.fullTriangles : 100.0);
+    ImGui::Text("Draw calls: %u for %u meshes", statistics.drawCalls, statistics.meshes);
+    ImGui::End();
+
+    ImGui::Begin("Geometry arena");
+    GeometryArena &arena = GeometryArena::Instance();
+    ImGui::Checkbox("Multi-draw indirect", &GeometryArena::MultiDrawEnabled());
+    if (!arena.MultiDrawSupported())
+        ImGui::Text("Drawing meshes one by one");
+    for (const auto &buffer : arena.Stats()) {
+        const GeometryArena::BufferStats &bufferStats = buffer.second;
+        ImGui::Separator();
+        ImGui::Text("%s: %u blocks, %.2f of %.2f MB used", buffer.first, bufferStats.blocks,
+                    bufferStats.usedBytes / (1024.0 * 1024.0), bufferStats.capacityBytes / (1024.0 * 1024.0));
+        ImGui::Text("  %zu free ranges, largest %.2f MB, fragmentation %.1f%%", bufferStats.freeRanges,
+                    bufferStats.largestFreeBytes / (1024.0 * 1024.0), 100.0 * bufferStats.Fragmentation());
+        ImGui::Text("  %u grows, %u compactions, %.2f MB moved", bufferStats.grows, bufferStats.compactions,
+                    bufferStats.movedBytes / (1024.0 * 1024.0));
+    }
+    ImGui::End();
+
+    ImGui::Begin("Render queue");
+    const RenderQueue::Stats &queueStats = renderQueue->GetStats();
+    const char *fieldNames[] = {"program", "material", "vertex array"};
+    ImGui::Text("%u items, %u state changes sorted, %u in submission order", queueStats.items, queueStats.Sorted(),
+                queueStats.Submitted());
+    for (int field = 0; field < 3; field++)
+        ImGui::Text("  %s: %u sorted, %u submitted", fieldNames[field], queueStats.sortedChanges[field],
+                    queueStats.submittedChanges[field]);
+    ImGui::End();
+
+    ImGui::Begin("Shaders");
+    if (shaderScheduler->AllReadyMilliseconds() >= 0.0)
+        ImGui::Text("All programs ready after %.1f ms%s", shaderScheduler->AllReadyMilliseconds(),
+                    ParallelCompile::Supported() ? " (parallel compile)" : "");
+    for (const auto &program : shaderScheduler->Programs()) {
+        if (program->ready)
+            ImGui::Text("%s: ready after %.2f ms%s", program->name.c_str(), program->shader->loadMilliseconds,
+                        program->shader->loadedFromCache ? " (program cache)" : "");
+        else
+            ImGui::Text("%s: compiling", program->name.c_str());
+    }
+    for (const ShaderVariants *variants : shaderVariants) {
+        ImGui::Text("%s: %zu compiled", variants->Name().c_str(), variants->Compiled().size());
+        for (const ShaderVariants::Variant &variant : variants->Compiled())
+            ImGui::Text("  [%s] %.2f ms%s", variant.key.c_str(), variant.milliseconds, variant.fromCache ? " (program cache)" : "");
+    }
+    ImGui::End();
+
+    ImGui::Begin("GL state");
+    const GLState::Counters &counters = GLState::Instance().LastFrame();
+    ImGui::Text("Last frame: %u calls issued, %u skipped", counters.Issued(), counters.Skipped());
+    for (int call = 0; call < GLState::CALL_COUNT; call++)
+        ImGui::Text("  %s: %u issued, %u skipped", GLState::Name((GLState::Call)call), counters.issued[call],
+                    counters.skipped[call]);
+    ImGui::Checkbox("Check against glGet", &GLState::Debug());
+    ImGui::End();
+
+    ImGui::Begin("Streaming");
+    StreamingManager::Settings &streamingSettings = streamingManager->settings;
+    ImGui::DragFloat("Prefetch distance", &streamingSettings.prefetchDistance, 0.05f, 0.0f, streamingSettings.evictDistance);
+    ImGui::DragFloat("Evict distance", &streamingSettings.evictDistance, 0.05f, streamingSettings.prefetchDistance, 20.0f);
+    float evictDelay = (float)streamingSettings.evictDelay;
+    if (ImGui::DragFloat("Evict delay (s)", &evictDelay, 0.1f, 0.0f, 60.0f))
+        streamingSettings.evictDelay = evictDelay;
+    for (const StreamingManager::Status &status : streamingManager->GetStatus()) {
+        ImGui::Separator();
+        ImGui::Text("%s: %s, %.2f away", status.name.c_str(), StreamingManager::Name(status.residency), status.distance);
+        ImGui::Text("  last load %.1f ms%s, %u loads, %u evictions", status.lastLoadMilliseconds,
+                    status.lastLoadFromCache ? " (mesh cache)" : "", status.loads, status.evictions);
+        ImGui::Text("  missing while in view %.1f ms, geometry %.2f MB, textures %.2f MB", status.missedMilliseconds,
+                    (status.memory.cpuGeometry + status.memory.gpuGeometry) / (1024.0 * 1024.0), status.memory.textures / (1024.0 * 1024.0));
+    }
+    ImGui::End();
+
     ImGui::Render();
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 }
@@ -734,12 +1231,13 @@ unsigned int loadCubemap(vector<std::string> &faces)
 {
     unsigned int textureID;
     glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+    GLState::Instance().BindTexture(0, GL_TEXTURE_CUBE_MAP, textureID);
 
     int width, height, nrChannels;
     for (unsigned int i = 0; i < faces.size(); i++)
     {
-        unsigned char *data = stbi_load(faces[i].c_str(), &width, &height, &nrChannels, 0);
+        AssetFile file;
+        unsigned char *data = file.Open(faces[i]) ? stbi_load_from_memory(file.Data(), (int)file.Size(), &width, &height, &nrChannels, 0) : nullptr;
         if (data)
         {
             glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i,
@@ -762,6 +1260,47 @@ unsigned int loadCubemap(vector<std::string> &faces)
     return textureID;
 }
 
+// same as loadCubemap, but the faces are decoded on the loader's workers. The texture is returned right away
+// and each face is uploaded by loader.ProcessUploads once it is decoded, until then the skybox stays black.
+unsigned int loadCubemapAsync(vector<std::string> &faces, AssetLoader &loader, std::function<void()> onLoaded)
+{
+    unsigned int textureID;
+    glGenTextures(1, &textureID);
+    GLState::Instance().BindTexture(0, GL_TEXTURE_CUBE_MAP, textureID);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+
+    // onLoaded runs after the upload of the last face
+    std::shared_ptr<unsigned int> remaining = std::make_shared<unsigned int>((unsigned int)faces.size());
+    for (unsigned int i = 0; i < faces.size(); i++)
+    {
+        std::string face = faces[i];
+        loader.Submit([face, i, textureID, &loader, remaining, onLoaded]() {
+            // faces go through the texture cache as well, the skybox only samples their base level
+            std::shared_ptr<TextureData> image = std::make_shared<TextureData>();
+            TextureCache::Get(face, *image, TextureCache::Compression().Cubemap());
+            loader.QueueUpload([face, i, textureID, image, remaining, onLoaded]() {
+                if (image->Valid())
+                {
+                    GLState::Instance().BindTexture(0, GL_TEXTURE_CUBE_MAP, textureID);
+                    UploadTextureLevels(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, *image, 1);
+                }
+                else
+                {
+                    std::cout << "Cubemap tex failed to load at path: " << face << std::endl;
+                }
+                if (--*remaining == 0 && onLoaded)
+                    onLoaded();
+            });
+        });
+    }
+
+    return textureID;
+}
+
 bool isCameraInside(vector<tuple<float, float, float, float>> &planes, glm::vec3 cameraPos)
 {
     for(int i=0;i<planes.size();i+=2){
@@ -808,7 +1347,7 @@ void renderQuad()
         // setup plane VAO
         glGenVertexArrays(1, &quadVAO);
         glGenBuffers(1, &quadVBO);
-        glBindVertexArray(quadVAO);
+        GLState::Instance().BindVertexArray(quadVAO);
         glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
         glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
         glEnableVertexAttribArray(0);
@@ -816,7 +1355,16 @@ void renderQuad()
         glEnableVertexAttribArray(1);
         glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
     }
-    glBindVertexArray(quadVAO);
+    GLState::Instance().BindVertexArray(quadVAO);
     glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-    glBindVertexArray(0);
-}
\ No newline at end of file
+}
+
+// resident set size of the process, from /proc/self/statm
+double residentMegabytes()
+{
+    std::ifstream statm("/proc/self/statm");
+    size_t pages = 0, resident = 0;
+    if (!(statm >> pages >> resident))
+        return 0.0;
+    return resident * (double)sysconf(_SC_PAGESIZE) / (1024.0 * 1024.0);
+}
@@ -0,0 +1,135 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/camera.h>
+#include <learnopengl/geometry_arena.h>
+#include <learnopengl/model.h>
+#include <learnopengl/shader.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+// checks run by ctest (see add_test in CMakeLists.txt), the name of the check is the argument. Exit code 0 when it
+// passes. They run in the project directory and read the assets from resources/ the way the application does
+
+// heap allocations made by each thread, counted by the replaced global operator new. Only this executable replaces
+// it, the application keeps the standard allocator
+thread_local size_t threadAllocations = 0;
+
+void *operator new(size_t size) {
+    threadAllocations++;
+    if (void *memory = std::malloc(size ? size : 1))
+        return memory;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void *memory, size_t) noexcept {
+    std::free(memory);
+}
+
+// loads the earth, the sun and the moon the way the scene sets them up and draws every model with its shader a few
+// times, which resolves the materials, then counts the heap allocations of 100 more rounds of Model::Draw on this
+// thread. Fails when there are any. Needs a GL context, the window is never shown
+int drawAllocations()
+{
+    glfwInit();
+    // terminate when the check returns, after the models and shaders are gone
+    struct GlfwTerminator {
+        ~GlfwTerminator() { glfwTerminate(); }
+    } glfwTerminator;
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow *window = glfwCreateWindow(800, 600, "draw_allocations", nullptr, nullptr);
+    if (window == nullptr) {
+        std::cout << "ERROR::TESTS:: failed to create GLFW window" << std::endl;
+        return 1;
+    }
+    glfwMakeContextCurrent(window);
+    if (!gladLoadGLLoader((GLADloadproc) glfwGetProcAddress)) {
+        std::cout << "ERROR::TESTS:: failed to initialize GLAD" << std::endl;
+        return 1;
+    }
+    // the same draw path as the scene, with glMultiDrawElementsIndirect where the context has it
+    GeometryArena::Instance().LoadFunctions((GLADloadproc) glfwGetProcAddress);
+
+    Shader earthShader("resources/shaders/flat_earth.vs", "resources/shaders/flat_earth.fs", nullptr,
+                       ShaderDefines().Set("SPOT_LIGHTS", 2));
+    Shader modelsShader("resources/shaders/models.vs", "resources/shaders/models.fs");
+    Model earthModel("resources/objects/earth/flat_earth.obj");
+    earthModel.SetShaderTextureNamePrefix("material.");
+    earthModel.SetVertexFormat(VertexFormat::Packed);
+    Model sunModel("resources/objects/sun/sun.obj");
+    sunModel.SetShaderTextureNamePrefix("material.");
+    sunModel.SetVertexFormat(VertexFormat::PackedHalf);
+    Model moonModel("resources/objects/moon/moon.obj");
+    moonModel.SetShaderTextureNamePrefix("material.");
+    moonModel.SetVertexFormat(VertexFormat::PackedHalf);
+    const std::pair<Model*, Shader*> draws[] = {{&earthModel, &earthShader}, {&sunModel, &modelsShader}, {&moonModel, &modelsShader}};
+
+    Camera camera;
+    glm::mat4 model(1.0f);
+    for (int round = 0; round < 3; round++) {
+        for (const std::pair<Model*, Shader*> &draw : draws) {
+            draw.second->use();
+            draw.first->Draw(*draw.second, model, camera.Position, camera.Zoom, 600.0f);
+        }
+    }
+    size_t before = threadAllocations;
+    for (int round = 0; round < 100; round++) {
+        for (const std::pair<Model*, Shader*> &draw : draws) {
+            draw.second->use();
+            draw.first->Draw(*draw.second, model, camera.Position, camera.Zoom, 600.0f);
+        }
+    }
+    size_t allocations = threadAllocations - before;
+    glFinish();
+    for (const std::pair<Model*, Shader*> &draw : draws)
+        std::cout << draw.first->directory << ": " << draw.first->meshes.size() << " meshes" << std::endl;
+    std::cout << allocations << " heap allocations in " << 100 * 3 << " calls of Model::Draw" << std::endl;
+    return allocations == 0 ? 0 : 1;
+}
+
+// imports every .obj model of the scene with Assimp and with the ObjLoader and compares the results. Fails on a
+// mismatch. Neither importer needs a GL context
+int objLoaderMatchesAssimp()
+{
+    const char *paths[] = {"resources/objects/earth/flat_earth.obj", "resources/objects/sun/sun.obj", "resources/objects/moon/moon.obj",
+                           "resources/objects/bird/bird.obj", "resources/objects/karambit/karambit.obj"};
+    bool matches = true;
+    for (const char *path : paths)
+    {
+        std::vector<MeshData> expected, actual;
+        if (!Model::ImportMeshes(path, expected, MeshImporter::Assimp) || !Model::ImportMeshes(path, actual, MeshImporter::Obj))
+        {
+            std::cout << path << ": import failed" << std::endl;
+            matches = false;
+            continue;
+        }
+        std::cout << path << ":" << std::endl;
+        matches &= ObjLoader::Compare(expected, actual, std::cout);
+    }
+    std::cout << (matches ? "ObjLoader matches Assimp" : "ObjLoader differs from Assimp") << std::endl;
+    return matches ? 0 : 1;
+}
+
+int main(int argc, char **argv)
+{
+    std::string check = argc > 1 ? argv[1] : "";
+    if (check == "draw_allocations")
+        return drawAllocations();
+    if (check == "obj_loader")
+        return objLoaderMatchesAssimp();
+    std::cout << "ERROR::TESTS:: unknown check " << check << std::endl;
+    return 1;
+}